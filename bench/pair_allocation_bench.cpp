@@ -0,0 +1,165 @@
+// Heap allocations and time per registered pair for ICP on the voxel-hash
+// backend. Every pair registers a perturbed copy of one of a few synthetic
+// fragments against the original, sharing the fragment cache like the runner
+// does. After the warm-up pairs have grown the worker's PairArena and built the
+// voxel indices, steady-state pairs should not allocate; build with
+// `xmake f --alloc_counter=y` for the counts to be recorded. Every measured
+// estimate is also compared with PCL's ICP on a KD-tree from the same start,
+// and the largest deviation is reported.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <cxxopts.hpp>
+
+#include "algorithm/icp.hpp"
+#include "algorithm/pair_arena.hpp"
+#include "allocation_counter.hpp"
+#include "fragment_cache.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+PointCloud make_fragment(std::mt19937 &rng, std::size_t points, float extent) {
+    // Points on the faces of a box give ICP well-conditioned geometry.
+    std::uniform_real_distribution<float> coordinate(0.0f, extent);
+    std::uniform_int_distribution<int> face(0, 5);
+    PointCloud cloud;
+    cloud.resize(points);
+    for (auto &point : cloud.points) {
+        Eigen::Vector3f position(coordinate(rng), coordinate(rng), coordinate(rng));
+        const int side = face(rng);
+        position[side % 3] = side < 3 ? 0.0f : extent;
+        point = pcl::PointXYZ(position.x(), position.y(), position.z());
+    }
+    return cloud;
+}
+
+// Translation distance and rotation angle (radians) between two transforms.
+std::pair<double, double> deviation(const TransMat &lhs, const TransMat &rhs) {
+    const TransMat delta = lhs.inverse() * rhs;
+    const double cos_angle =
+        std::clamp((static_cast<double>(delta.topLeftCorner<3, 3>().trace()) - 1.0) * 0.5, -1.0, 1.0);
+    return {static_cast<double>((lhs.topRightCorner<3, 1>() - rhs.topRightCorner<3, 1>()).norm()),
+            std::acos(cos_angle)};
+}
+
+PointCloud transform_cloud(const PointCloud &cloud, const TransMat &transform) {
+    PointCloud moved;
+    moved.resize(cloud.size());
+    for (std::size_t idx = 0; idx < cloud.size(); ++idx) {
+        const Eigen::Vector3f position =
+            transform.topLeftCorner<3, 3>() * cloud[idx].getVector3fMap() +
+            transform.topRightCorner<3, 1>();
+        moved[idx] = pcl::PointXYZ(position.x(), position.y(), position.z());
+    }
+    return moved;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("pair_allocation_bench",
+                             "Count heap allocations per ICP pair on the voxel-hash backend");
+    options.add_options()
+        ("fragments", "Distinct target fragments", cxxopts::value<std::size_t>()->default_value("4"))
+        ("points", "Points per fragment", cxxopts::value<std::size_t>()->default_value("50000"))
+        ("warmup", "Pairs before measuring", cxxopts::value<std::size_t>()->default_value("16"))
+        ("pairs", "Measured pairs", cxxopts::value<std::size_t>()->default_value("200"))
+        ("voxel-size", "Voxel size and maximum correspondence distance", cxxopts::value<float>()->default_value("0.1"))
+        ("seed", "Random seed", cxxopts::value<unsigned>()->default_value("42"))
+        ("h,help", "Print usage");
+    const auto args = options.parse(argc, argv);
+    if (args.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const auto fragment_count = args["fragments"].as<std::size_t>();
+    const auto warmup = args["warmup"].as<std::size_t>();
+    const auto pair_count = args["pairs"].as<std::size_t>();
+    const auto voxel_size = args["voxel-size"].as<float>();
+
+    std::mt19937 rng(args["seed"].as<unsigned>());
+    std::uniform_real_distribution<float> angle(-0.02f, 0.02f);
+    std::uniform_real_distribution<float> offset(-0.3f * voxel_size, 0.3f * voxel_size);
+
+    // Sources are prepared up front so that only registration is measured.
+    std::vector<PointCloud> targets;
+    std::vector<PointCloud> sources;
+    for (std::size_t idx = 0; idx < fragment_count; ++idx) {
+        targets.emplace_back(make_fragment(rng, args["points"].as<std::size_t>(), 4.0f));
+        TransMat perturbation = TransMat::Identity();
+        perturbation.topLeftCorner<3, 3>() =
+            (Eigen::AngleAxisf(angle(rng), Eigen::Vector3f::UnitZ()) *
+             Eigen::AngleAxisf(angle(rng), Eigen::Vector3f::UnitX()))
+                .toRotationMatrix();
+        perturbation.topRightCorner<3, 1>() = Eigen::Vector3f(offset(rng), offset(rng), offset(rng));
+        sources.emplace_back(transform_cloud(targets.back(), perturbation));
+    }
+
+    const nlohmann::json config{{"correspondence", "voxel_hash"},
+                                {"voxel_size", voxel_size},
+                                {"max_iterations", 30}};
+    ICP icp(config);
+    FragmentCache cache;
+
+    // Reference estimates from PCL, computed before anything is measured.
+    ICP reference_icp(nlohmann::json{{"correspondence", "kdtree"},
+                                     {"max_correspondence_distance", voxel_size},
+                                     {"max_iterations", 30}});
+    std::vector<TransMat> references;
+    for (std::size_t idx = 0; idx < fragment_count; ++idx) {
+        references.emplace_back(
+            reference_icp.register_fragments(Fragment{sources[idx]}, Fragment{targets[idx]}));
+    }
+
+    std::size_t allocations = 0;
+    double seconds = 0.0;
+    double max_translation_deviation = 0.0;
+    double max_rotation_deviation = 0.0;
+    for (std::size_t pair = 0; pair < warmup + pair_count; ++pair) {
+        const auto idx = pair % fragment_count;
+        const Fragment source{sources[idx], &cache, fragment_count + idx};
+        const Fragment target{targets[idx], &cache, idx};
+
+        const auto before = thread_allocation_count();
+        const auto begin = Clock::now();
+        const auto transform = icp.register_fragments(source, target);
+        const auto elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+        const auto after = thread_allocation_count();
+
+        if (pair >= warmup) {
+            allocations += after - before;
+            seconds += elapsed;
+            const auto [translation, rotation] = deviation(transform, references[idx]);
+            max_translation_deviation = std::max(max_translation_deviation, translation);
+            max_rotation_deviation = std::max(max_rotation_deviation, rotation);
+        }
+    }
+
+    std::cout << std::format("{} pairs of {} points after {} warm-up pairs\n", pair_count,
+                             targets.front().size(), warmup);
+    std::cout << std::format("time per pair     {:>10.3f} ms\n", 1e3 * seconds / pair_count);
+    std::cout << std::format("max vs PCL        {:>10.3g} m, {:.3g} deg\n",
+                             max_translation_deviation,
+                             max_rotation_deviation * 180.0 / std::numbers::pi);
+    std::cout << std::format("arena capacity    {:>10} KiB ({} chunk allocation(s))\n",
+                             PairArena::local().capacity() / 1024,
+                             PairArena::local().chunk_allocations());
+    if (!allocation_counting_enabled()) {
+        std::cout << "allocations/pair  not counted (configure with --alloc_counter=y)\n";
+        return 0;
+    }
+    std::cout << std::format("allocations/pair  {:>10.2f}\n",
+                             static_cast<double>(allocations) / pair_count);
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+// Build and query cost of the nearest-neighbour structures available to the
+// registration algorithms: the voxel-hash index, PCL's FLANN KD-tree and a
+// nanoflann KD-tree. Queries are cloud points perturbed by up to half a voxel,
+// which matches correspondence search close to convergence.
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <nanoflann.hpp>
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include "algorithm/voxel_hash_index.hpp"
+#include "common.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+struct CloudAdaptor {
+    const PointCloud &cloud;
+
+    std::size_t kdtree_get_point_count() const { return cloud.size(); }
+    float kdtree_get_pt(std::size_t idx, std::size_t dim) const { return cloud[idx].data[dim]; }
+    template <class BBox>
+    bool kdtree_get_bbox(BBox &) const {
+        return false;
+    }
+};
+
+using NanoflannTree = nanoflann::KDTreeSingleIndexAdaptor<
+    nanoflann::L2_Simple_Adaptor<float, CloudAdaptor>, CloudAdaptor, 3, std::uint32_t>;
+
+struct Result {
+    std::string name;
+    double build_ms{0.0};
+    double query_ns{0.0};
+    std::size_t found{0};
+    std::size_t agree{0};
+};
+
+void print(const Result &result, std::size_t queries) {
+    std::cout << std::format("{:<12} build {:>10.2f} ms   query {:>9.1f} ns   found {:>6.2f}%   "
+                             "exact {:>6.2f}%\n",
+                             result.name, result.build_ms, result.query_ns,
+                             100.0 * static_cast<double>(result.found) / queries,
+                             100.0 * static_cast<double>(result.agree) / queries);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("spatial_index_bench",
+                             "Compare nearest-neighbour index build and query cost");
+    options.add_options()
+        ("points", "Points in the indexed cloud", cxxopts::value<std::size_t>()->default_value("1000000"))
+        ("queries", "Number of queries", cxxopts::value<std::size_t>()->default_value("200000"))
+        ("extent", "Side of the cube the points are drawn from", cxxopts::value<float>()->default_value("20"))
+        ("voxel-size", "Voxel size and maximum query distance", cxxopts::value<float>()->default_value("0.1"))
+        ("seed", "Random seed", cxxopts::value<unsigned>()->default_value("42"))
+        ("h,help", "Print usage");
+    const auto args = options.parse(argc, argv);
+    if (args.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const auto point_count = args["points"].as<std::size_t>();
+    const auto query_count = args["queries"].as<std::size_t>();
+    const auto extent = args["extent"].as<float>();
+    const auto voxel_size = args["voxel-size"].as<float>();
+
+    std::mt19937 rng(args["seed"].as<unsigned>());
+    std::uniform_real_distribution<float> coordinate(0.0f, extent);
+    std::uniform_real_distribution<float> jitter(-0.5f * voxel_size, 0.5f * voxel_size);
+
+    auto cloud = std::make_shared<PointCloud>();
+    cloud->resize(point_count);
+    for (auto &point : cloud->points) {
+        point = pcl::PointXYZ(coordinate(rng), coordinate(rng), coordinate(rng));
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(0, point_count - 1);
+    std::vector<pcl::PointXYZ> queries(query_count);
+    for (auto &query : queries) {
+        const auto &base = (*cloud)[pick(rng)];
+        query = pcl::PointXYZ(base.x + jitter(rng), base.y + jitter(rng), base.z + jitter(rng));
+    }
+
+    std::cout << std::format("{} points, {} queries, voxel size {}\n", point_count, query_count,
+                             voxel_size);
+
+    // nanoflann's exact answers are the reference for the other structures.
+    Result nano{"nanoflann"};
+    std::vector<std::uint32_t> reference(query_count);
+    {
+        const CloudAdaptor adaptor{*cloud};
+        auto begin = Clock::now();
+        NanoflannTree tree(3, adaptor, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+        nano.build_ms = elapsed_ms(begin);
+
+        begin = Clock::now();
+        for (std::size_t idx = 0; idx < query_count; ++idx) {
+            std::uint32_t match = 0;
+            float squared_distance = 0.0f;
+            if (tree.knnSearch(queries[idx].data, 1, &match, &squared_distance) == 1 &&
+                squared_distance <= voxel_size * voxel_size) {
+                ++nano.found;
+            }
+            reference[idx] = match;
+        }
+        nano.query_ns = elapsed_ms(begin) * 1e6 / static_cast<double>(query_count);
+        nano.agree = query_count;
+    }
+
+    Result flann{"pcl_flann"};
+    {
+        auto begin = Clock::now();
+        pcl::KdTreeFLANN<pcl::PointXYZ> tree;
+        tree.setInputCloud(cloud);
+        flann.build_ms = elapsed_ms(begin);
+
+        pcl::Indices match(1);
+        std::vector<float> squared_distance(1);
+        begin = Clock::now();
+        for (std::size_t idx = 0; idx < query_count; ++idx) {
+            if (tree.nearestKSearch(queries[idx], 1, match, squared_distance) == 1) {
+                if (squared_distance[0] <= voxel_size * voxel_size) {
+                    ++flann.found;
+                }
+                if (static_cast<std::uint32_t>(match[0]) == reference[idx]) {
+                    ++flann.agree;
+                }
+            }
+        }
+        flann.query_ns = elapsed_ms(begin) * 1e6 / static_cast<double>(query_count);
+    }
+
+    Result voxel{"voxel_hash"};
+    {
+        auto begin = Clock::now();
+        const VoxelHashIndex index(*cloud, voxel_size);
+        voxel.build_ms = elapsed_ms(begin);
+
+        begin = Clock::now();
+        for (std::size_t idx = 0; idx < query_count; ++idx) {
+            std::uint32_t match = 0;
+            float squared_distance = 0.0f;
+            const auto &query = queries[idx];
+            if (index.nearest(Eigen::Vector3f(query.x, query.y, query.z), voxel_size, match,
+                              squared_distance)) {
+                ++voxel.found;
+                if (match == reference[idx]) {
+                    ++voxel.agree;
+                }
+            }
+        }
+        voxel.query_ns = elapsed_ms(begin) * 1e6 / static_cast<double>(query_count);
+        std::cout << std::format("voxel_hash   {} voxels, {:.1f} MiB\n", index.voxel_count(),
+                                 static_cast<double>(index.memory_bytes()) / (1024.0 * 1024.0));
+    }
+
+    print(nano, query_count);
+    print(flann, query_count);
+    print(voxel, query_count);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "affinity.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+thread_local bool pool_worker = false;
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const auto count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+} // namespace
+
+std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(),
+                                   [](unsigned char c) { return std::isspace(c); }),
+                    range.end());
+        if (range.empty()) {
+            continue;
+        }
+        const auto dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::size_t CpuTopology::cpu_count() const {
+    std::size_t count = 0;
+    for (const auto &node : nodes) {
+        count += node.size();
+    }
+    return count;
+}
+
+CpuTopology CpuTopology::detect() {
+    const auto allowed = allowed_cpus();
+    CpuTopology topology;
+
+    namespace fs = std::filesystem;
+    const fs::path node_root{"/sys/devices/system/node"};
+    std::error_code error;
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    for (const auto &entry : fs::directory_iterator(node_root, error)) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with("node") || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            continue;
+        }
+        std::ifstream cpulist(entry.path() / "cpulist");
+        std::string list;
+        if (!cpulist || !std::getline(cpulist, list)) {
+            continue;
+        }
+        std::vector<int> cpus;
+        try {
+            cpus = parse_cpu_list(list);
+        } catch (const std::exception &) {
+            continue;
+        }
+        std::erase_if(cpus, [&allowed](int cpu) {
+            return !std::binary_search(allowed.begin(), allowed.end(), cpu);
+        });
+        if (!cpus.empty()) {
+            nodes.emplace_back(std::stoi(name.substr(4)), std::move(cpus));
+        }
+    }
+
+    std::sort(nodes.begin(), nodes.end());
+    for (auto &[id, cpus] : nodes) {
+        topology.nodes.emplace_back(std::move(cpus));
+    }
+    if (topology.nodes.empty()) {
+        topology.nodes.emplace_back(allowed);
+    }
+    return topology;
+}
+
+AffinityMode affinity_mode_from_string(const std::string &mode) {
+    if (mode == "none") {
+        return AffinityMode::None;
+    }
+    if (mode == "core") {
+        return AffinityMode::Core;
+    }
+    if (mode == "node") {
+        return AffinityMode::Node;
+    }
+    throw std::invalid_argument("affinity must be \"none\", \"core\" or \"node\"");
+}
+
+bool pin_current_thread(const std::vector<int> &cpus) {
+#if defined(__linux__)
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+void mark_pool_worker() {
+    pool_worker = true;
+}
+
+int omp_team_threads(unsigned int configured) {
+    if (configured > 0) {
+        return static_cast<int>(configured);
+    }
+#ifdef _OPENMP
+    return pool_worker ? 1 : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// CPUs this process may run on, grouped by NUMA node. Read from
+// /sys/devices/system/node and intersected with the process affinity mask;
+// machines without that information (or with one node) report a single node
+// holding every allowed CPU.
+struct CpuTopology {
+    std::vector<std::vector<int>> nodes;
+
+    static CpuTopology detect();
+
+    std::size_t node_count() const { return nodes.size(); }
+    std::size_t cpu_count() const;
+};
+
+// Where runner workers are pinned. Core pins each worker to one CPU, Node to
+// the CPUs of its NUMA node.
+enum class AffinityMode { None, Core, Node };
+
+AffinityMode affinity_mode_from_string(const std::string &mode);
+
+// Restricts the calling thread to `cpus`; returns false (leaving the thread
+// unpinned) when the platform refuses or does not support it.
+bool pin_current_thread(const std::vector<int> &cpus);
+
+// Parses a kernel CPU list such as "0-3,8,10-11".
+std::vector<int> parse_cpu_list(const std::string &list);
+
+// Marks the calling thread as a worker of a pool that already keeps one task
+// per core busy (the runner's and the registration engine's), so that OpenMP
+// teams it starts default to a single thread instead of oversubscribing the
+// machine, or sharing a pinned worker's one CPU.
+void mark_pool_worker();
+
+// Threads for an OpenMP team started by the calling thread: `configured` when
+// positive, otherwise one on a pool worker and every hardware thread
+// elsewhere.
+int omp_team_threads(unsigned int configured);
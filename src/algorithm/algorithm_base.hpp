@@ -1,5 +1,6 @@
 #pragma once
 #include "common.hpp"
+#include "fragment_cache.hpp"
 #include "singleton.hpp"
 #include "logger.hpp"
 #include <nlohmann/json.hpp>
@@ -8,6 +9,7 @@
 #include <map>
 #include <functional>
 #include <stdexcept>
+#include <vector>
 #include <eigen3/Eigen/src/Core/Matrix.h>
 
 
@@ -15,7 +17,43 @@ class AlgorithmBase : public LoggerAble<AlgorithmBase> {
 public: 
   virtual ~AlgorithmBase() = default;
   virtual std::string name() const = 0;
-  virtual TransMat register_point_cloud(const PointCloud& source, const PointCloud& target) = 0;
+  // `initial_guess` maps the source into the target frame before the first
+  // iteration; the result includes it.
+  virtual TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                        const TransMat& initial_guess = TransMat::Identity()) = 0;
+  // Entry point used by the runner. Algorithms that derive per-fragment data
+  // override this to reuse it through the fragments' cache.
+  virtual TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                      const TransMat& initial_guess = TransMat::Identity()) {
+    return register_point_cloud(source.cloud, target.cloud, initial_guess);
+  }
+
+  // Called by the runner before it registers a sequence with every fragment
+  // that will serve as a target, so that algorithms whose per-target data is
+  // expensive can derive it for all of them at once (e.g. in parallel)
+  // instead of on first use. The fragments stay valid for the call only.
+  virtual void prepare_targets(const std::vector<Fragment>& targets) {}
+
+  // Name the runner reports results under. Defaults to name(); parameter
+  // sweeps give every variant of one algorithm its own label.
+  std::string label() const { return _label.empty() ? name() : _label; }
+  void set_label(std::string label) { _label = std::move(label); }
+
+  // Iterations run by registrations on the calling thread so far; the runner
+  // reads the difference around a pair. Algorithms that know their count add
+  // it through record_iterations(), the others leave it unchanged.
+  static std::size_t thread_iterations() { return iteration_counter(); }
+
+protected:
+  static void record_iterations(std::size_t iterations) { iteration_counter() += iterations; }
+
+private:
+  static std::size_t &iteration_counter() {
+    thread_local std::size_t iterations = 0;
+    return iterations;
+  }
+
+  std::string _label;
 };
 
 using Algorithm = AlgorithmBase*;
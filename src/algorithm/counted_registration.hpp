@@ -0,0 +1,9 @@
+#pragma once
+
+// A PCL registration that exposes how many iterations its last align() ran,
+// which PCL keeps protected.
+template <typename Registration>
+class CountedRegistration : public Registration {
+public:
+    int iterations() const { return this->nr_iterations_; }
+};
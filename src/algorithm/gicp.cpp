@@ -0,0 +1,140 @@
+#include "algorithm/gicp.hpp"
+#include "algorithm/counted_registration.hpp"
+#include "affinity.hpp"
+#include <Eigen/SVD>
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+REGISTER_ALGORITHM(gicp, GICP);
+
+namespace {
+// Same model as pcl::GeneralizedIterativeClosestPoint::computeCovariances: the
+// covariance of the k nearest neighbours with its eigenvalues replaced by
+// (1, 1, epsilon), computed for all points in parallel.
+std::shared_ptr<GICPFragmentData> build_fragment_data(const PointCloud::ConstPtr &cloud,
+                                                      int k, double epsilon, int threads) {
+    auto data = std::make_shared<GICPFragmentData>();
+    data->tree = std::make_shared<pcl::search::KdTree<pcl::PointXYZ>>();
+    data->tree->setInputCloud(cloud);
+    data->covariances = std::make_shared<GICPFragmentData::Covariances>(cloud->size());
+
+    const int neighbours = std::min<int>(k, static_cast<int>(cloud->size()));
+
+#pragma omp parallel num_threads(threads)
+    {
+        pcl::Indices indices(neighbours);
+        std::vector<float> distances(neighbours);
+
+#pragma omp for schedule(static)
+        for (long long idx = 0; idx < static_cast<long long>(cloud->size()); ++idx) {
+            data->tree->nearestKSearch((*cloud)[idx], neighbours, indices, distances);
+
+            Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+            Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+            for (const auto neighbour : indices) {
+                const Eigen::Vector3d point = (*cloud)[neighbour].getVector3fMap().cast<double>();
+                mean += point;
+                covariance.noalias() += point * point.transpose();
+            }
+            const double count = static_cast<double>(indices.size());
+            mean /= count;
+            covariance = covariance / count - mean * mean.transpose();
+
+            Eigen::JacobiSVD<Eigen::Matrix3d> svd(covariance, Eigen::ComputeFullU);
+            const Eigen::Matrix3d &u = svd.matrixU();
+            Eigen::Matrix3d regularized = Eigen::Matrix3d::Zero();
+            for (int axis = 0; axis < 3; ++axis) {
+                const double weight = axis == 2 ? epsilon : 1.0;
+                regularized.noalias() += weight * u.col(axis) * u.col(axis).transpose();
+            }
+            (*data->covariances)[idx] = regularized;
+        }
+    }
+
+    return data;
+}
+} // namespace
+
+GICP::GICP(const nlohmann::json &config) {
+    _k = config.value("k", _k);
+    _covariance_epsilon = config.value("covariance_epsilon", _covariance_epsilon);
+    _max_iterations = config.value("max_iterations", _max_iterations);
+    _max_optimizer_iterations = config.value("max_optimizer_iterations", _max_optimizer_iterations);
+    _max_correspondence_distance =
+        config.value("max_correspondence_distance", _max_correspondence_distance);
+    _transformation_epsilon = config.value("transformation_epsilon", _transformation_epsilon);
+    _rotation_epsilon = config.value("rotation_epsilon", _rotation_epsilon);
+    _threads = config.value("threads", _threads);
+
+    if (_k < 3) {
+        throw std::invalid_argument("GICP: 'k' must be at least 3");
+    }
+}
+
+std::string GICP::name() const {
+    return "gicp";
+}
+
+std::shared_ptr<const GICPFragmentData> GICP::fragment_data(const Fragment &fragment) const {
+    return fragment.derived<GICPFragmentData>(
+        std::format("gicp/k={}/eps={}", _k, _covariance_epsilon), [this, &fragment]() {
+            return build_fragment_data(fragment.shared(), _k, _covariance_epsilon,
+                                       omp_team_threads(_threads));
+        });
+}
+
+TransMat GICP::register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                    const TransMat &initial_guess) {
+    return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+}
+
+TransMat GICP::register_fragments(const Fragment &source, const Fragment &target,
+                                  const TransMat &initial_guess) {
+    if (source.cloud.size() < 3 || target.cloud.size() < 3) {
+        throw std::runtime_error("GICP requires point clouds with at least 3 points");
+    }
+
+    log_info("Aligning source ({} points) to target ({} points)",
+        source.cloud.size(), target.cloud.size());
+
+    const auto source_data = fragment_data(source);
+    const auto target_data = fragment_data(target);
+
+    CountedRegistration<pcl::GeneralizedIterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ>> gicp;
+    // Covariances must be set after the clouds, which reset them.
+    gicp.setInputSource(source.shared());
+    gicp.setInputTarget(target.shared());
+    gicp.setSearchMethodSource(source_data->tree, true);
+    gicp.setSearchMethodTarget(target_data->tree, true);
+    gicp.setSourceCovariances(source_data->covariances);
+    gicp.setTargetCovariances(target_data->covariances);
+    gicp.setCorrespondenceRandomness(_k);
+    gicp.setMaximumIterations(_max_iterations);
+    gicp.setMaximumOptimizerIterations(_max_optimizer_iterations);
+    if (_max_correspondence_distance > 0.0) {
+        gicp.setMaxCorrespondenceDistance(_max_correspondence_distance);
+    }
+    if (_transformation_epsilon > 0.0) {
+        gicp.setTransformationEpsilon(_transformation_epsilon);
+    }
+    if (_rotation_epsilon > 0.0) {
+        gicp.setRotationEpsilon(_rotation_epsilon);
+    }
+
+    PointCloud aligned;
+    gicp.align(aligned, initial_guess);
+    record_iterations(gicp.iterations());
+
+    if (!gicp.hasConverged()) {
+        throw std::runtime_error("GICP failed to converge on the provided point clouds");
+    }
+
+    log_info("Converged with score {}", gicp.getFitnessScore());
+
+    return gicp.getFinalTransformation();
+}
+
+std::shared_ptr<AlgorithmBase> GICP::create(const nlohmann::json &config) {
+    return std::make_shared<GICP>(config);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "algorithm_base.hpp"
+#include <pcl/registration/gicp.h>
+#include <pcl/search/kdtree.h>
+
+// Search tree and regularized per-point covariances of one fragment. Built
+// once per fragment and shared between its source and target roles.
+struct GICPFragmentData {
+    using Covariances = pcl::GeneralizedIterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ>::MatricesVector;
+
+    pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+    std::shared_ptr<Covariances> covariances;
+};
+
+// Generalized ICP (plane-to-plane). Covariances and KD-trees come from the
+// sample's fragment cache instead of being recomputed by PCL for every pair.
+class GICP : public AlgorithmBase {
+public:
+    explicit GICP(const nlohmann::json& config);
+    std::string name() const override;
+    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                  const TransMat& initial_guess = TransMat::Identity()) override;
+    TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                const TransMat& initial_guess = TransMat::Identity()) override;
+    static std::shared_ptr<AlgorithmBase> create(const nlohmann::json& config);
+
+private:
+    std::shared_ptr<const GICPFragmentData> fragment_data(const Fragment& fragment) const;
+
+    int _k{20};
+    double _covariance_epsilon{0.001};
+    int _max_iterations{50};
+    int _max_optimizer_iterations{20};
+    double _max_correspondence_distance{0.0};
+    double _transformation_epsilon{0.0};
+    double _rotation_epsilon{0.0};
+    // OpenMP threads for the covariances of one fragment; 0 resolves through
+    // omp_team_threads(), i.e. one on runner workers.
+    unsigned int _threads{0};
+};
@@ -1,41 +1,131 @@
 #include "algorithm/icp.hpp"
+#include "algorithm/counted_registration.hpp"
+#include "algorithm/pair_arena.hpp"
+#include "algorithm/point_to_point_kernel.hpp"
 #include "pcl/registration/icp.h"
+#include <cmath>
+#include <memory_resource>
 #include <stdexcept>
 #include <string_view>
 #include "logger.hpp"
 
 REGISTER_ALGORITHM(icp, ICP);
 ICP::ICP(const nlohmann::json &config) {
+    _max_iterations = config.value("max_iterations", _max_iterations);
+    _max_correspondence_distance =
+        config.value("max_correspondence_distance", _max_correspondence_distance);
+    _transformation_epsilon = config.value("transformation_epsilon", _transformation_epsilon);
+    _euclidean_fitness_epsilon =
+        config.value("euclidean_fitness_epsilon", _euclidean_fitness_epsilon);
+    _backend = CorrespondenceBackend::from_json(config, _max_correspondence_distance);
+    const auto kernel = config.value("kernel", std::string{"native"});
+    if (kernel != "native" && kernel != "pcl") {
+        throw std::invalid_argument("'kernel' must be either \"native\" or \"pcl\"");
+    }
+    _native_kernel = kernel == "native";
+    _index_key = _backend.index_key("cloud");
 }
 
 std::string ICP::name() const {
     return "icp";
 }
 
-TransMat ICP::register_point_cloud(const PointCloud &source, const PointCloud &target) {
-    if (source.empty() || target.empty()) {
+TransMat ICP::register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                   const TransMat &initial_guess) {
+    return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+}
+
+TransMat ICP::register_fragments(const Fragment &source, const Fragment &target,
+                                 const TransMat &initial_guess) {
+    if (source.cloud.empty() || target.cloud.empty()) {
         throw std::runtime_error("ICP::register_point_cloud requires non-empty point clouds");
     }
 
+    // The native path logs at debug level only: formatting a message per
+    // pair would be its only heap allocation.
+    if (_backend.uses_voxel_hash() && _native_kernel) {
+        return register_native(source, target, initial_guess);
+    }
+
     log_info("Aligning source ({} points) to target ({} points)",
-        source.size(), target.size());
+        source.cloud.size(), target.cloud.size());
 
-    pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> icp;
-    icp.setInputSource(source.makeShared());
-    icp.setInputTarget(target.makeShared());
+    CountedRegistration<pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ>> icp;
+    icp.setInputSource(source.shared());
+    icp.setInputTarget(target.shared());
+    if (_max_iterations > 0) {
+        icp.setMaximumIterations(_max_iterations);
+    }
+    if (_transformation_epsilon > 0.0) {
+        icp.setTransformationEpsilon(_transformation_epsilon);
+    }
+    if (_euclidean_fitness_epsilon > 0.0) {
+        icp.setEuclideanFitnessEpsilon(_euclidean_fitness_epsilon);
+    }
+
+    std::shared_ptr<const VoxelHashIndex> index;
+    if (_backend.uses_voxel_hash()) {
+        index = _backend.cached_index(target, _index_key, target.cloud);
+        CorrespondenceBackend::attach(icp, index);
+        icp.setMaxCorrespondenceDistance(_max_correspondence_distance > 0.0
+                                             ? _max_correspondence_distance
+                                             : _backend.voxel_size);
+    } else if (_max_correspondence_distance > 0.0) {
+        icp.setMaxCorrespondenceDistance(_max_correspondence_distance);
+    }
 
     PointCloud aligned;
-    icp.align(aligned);
+    icp.align(aligned, initial_guess);
+    record_iterations(icp.iterations());
 
     if (!icp.hasConverged()) {
         throw std::runtime_error("ICP failed to converge on the provided point clouds");
     }
 
-    log_info("Converged with score {}", icp.getFitnessScore());
+    if (index) {
+        // getFitnessScore() would query the target KD-tree, which is not built.
+        log_info("Converged with score {}", voxel_fitness_score(*index, aligned, _backend.voxel_size));
+    } else {
+        log_info("Converged with score {}", icp.getFitnessScore());
+    }
 
     return icp.getFinalTransformation();
 }
 
+TransMat ICP::register_native(const Fragment &source, const Fragment &target,
+                              const TransMat &initial_guess) const {
+    const auto index = _backend.cached_index(target, _index_key, target.cloud);
+
+    PairArena::Scope scope;
+    std::pmr::vector<Eigen::Vector3f> points(&scope.arena());
+    points.reserve(source.cloud.size());
+    for (const auto &point : source.cloud) {
+        if (std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z)) {
+            points.emplace_back(point.x, point.y, point.z);
+        }
+    }
+
+    IcpKernelSettings settings;
+    if (_max_iterations > 0) {
+        settings.max_iterations = _max_iterations;
+    }
+    settings.max_distance = static_cast<float>(
+        _max_correspondence_distance > 0.0 ? _max_correspondence_distance : _backend.voxel_size);
+    settings.transformation_epsilon = _transformation_epsilon;
+    if (_euclidean_fitness_epsilon > 0.0) {
+        settings.euclidean_fitness_epsilon = _euclidean_fitness_epsilon;
+    }
+
+    const auto result = align_point_to_point<double>(points, target.cloud, *index,
+                                                     initial_guess.cast<double>(), settings);
+    record_iterations(result.iterations);
+    if (!result.converged) {
+        throw std::runtime_error("ICP failed to converge on the provided point clouds");
+    }
+    log_debug("Converged with score {} after {} iteration(s)", result.fitness, result.iterations);
+    return result.transform.cast<float>();
+}
+
 std::shared_ptr<AlgorithmBase> ICP::create(const nlohmann::json &config) {
     return std::make_shared<ICP>(config);
 }
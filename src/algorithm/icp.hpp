@@ -1,10 +1,31 @@
 #pragma once
 #include "algorithm_base.hpp"
+#include "algorithm/voxel_hash_correspondence.hpp"
 
+// Point-to-point ICP. With the voxel-hash backend the registration runs in a
+// native kernel whose temporaries come from the worker's PairArena, so
+// steady-state pairs do not allocate; the KD-tree backend goes through PCL.
 class ICP : public AlgorithmBase {
 public:
     explicit ICP(const nlohmann::json& config);
     std::string name() const override;
-    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target) override;
+    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                  const TransMat& initial_guess = TransMat::Identity()) override;
+    TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                const TransMat& initial_guess = TransMat::Identity()) override;
     static std::shared_ptr<AlgorithmBase> create(const nlohmann::json& config);
+
+private:
+    TransMat register_native(const Fragment& source, const Fragment& target,
+                             const TransMat& initial_guess) const;
+
+    int _max_iterations{0};
+    double _max_correspondence_distance{0.0};
+    double _transformation_epsilon{0.0};
+    double _euclidean_fitness_epsilon{0.0};
+    CorrespondenceBackend _backend;
+    // Voxel-hash runs use the allocation-free point-to-point kernel unless
+    // "kernel" is "pcl".
+    bool _native_kernel{true};
+    std::string _index_key;
 };
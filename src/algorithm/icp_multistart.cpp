@@ -0,0 +1,274 @@
+#include "algorithm/icp_multistart.hpp"
+#include "affinity.hpp"
+#include "algorithm/counted_registration.hpp"
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <numeric>
+#include <pcl/registration/icp.h>
+#include <pcl/search/kdtree.h>
+#include <random>
+#include <stdexcept>
+
+REGISTER_ALGORITHM(icp_multistart, MultiStartICP);
+
+namespace {
+using Search = pcl::search::KdTree<pcl::PointXYZ>;
+
+// Cached KD-tree of a target fragment; PCL takes the tree by mutable pointer.
+struct SharedSearch {
+    Search::Ptr tree;
+};
+
+using StagedICP = CountedRegistration<pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ>>;
+
+bool seed_converged(StagedICP &icp) {
+    using Criteria = pcl::registration::DefaultConvergenceCriteria<float>;
+    const auto criteria = icp.getConvergeCriteria();
+    if (!criteria) {
+        return false;
+    }
+    switch (criteria->getConvergenceState()) {
+    case Criteria::CONVERGENCE_CRITERIA_TRANSFORM:
+    case Criteria::CONVERGENCE_CRITERIA_ABS_MSE:
+    case Criteria::CONVERGENCE_CRITERIA_REL_MSE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Orders seeds best first: more inliers, then lower residual.
+bool better(const SeedStatistics &lhs, const SeedStatistics &rhs) {
+    if (lhs.inlier_ratio != rhs.inlier_ratio) {
+        return lhs.inlier_ratio > rhs.inlier_ratio;
+    }
+    return lhs.rmse < rhs.rmse;
+}
+} // namespace
+
+MultiStartICP::MultiStartICP(const nlohmann::json &config) {
+    _seeds = config.value("seeds", _seeds);
+    _max_rotation_deg = config.value("max_rotation_deg", _max_rotation_deg);
+    _max_translation = config.value("max_translation", _max_translation);
+    _random_seed = config.value("random_seed", _random_seed);
+    _max_iterations = config.value("max_iterations", _max_iterations);
+    _stage_iterations = config.value("stage_iterations", _stage_iterations);
+    _keep_fraction = config.value("keep_fraction", _keep_fraction);
+    _threads = config.value("threads", _threads);
+    _max_correspondence_distance =
+        config.value("max_correspondence_distance", _max_correspondence_distance);
+    _transformation_epsilon = config.value("transformation_epsilon", _transformation_epsilon);
+    _euclidean_fitness_epsilon =
+        config.value("euclidean_fitness_epsilon", _euclidean_fitness_epsilon);
+    _backend = CorrespondenceBackend::from_json(config, _max_correspondence_distance);
+
+    if (_seeds < 1) {
+        throw std::invalid_argument("MultiStartICP: 'seeds' must be at least 1");
+    }
+    if (_max_iterations < 1 || _stage_iterations < 1) {
+        throw std::invalid_argument(
+            "MultiStartICP: 'max_iterations' and 'stage_iterations' must be positive");
+    }
+    if (!(_keep_fraction > 0.0 && _keep_fraction <= 1.0)) {
+        throw std::invalid_argument("MultiStartICP: 'keep_fraction' must be in (0, 1]");
+    }
+    if (!(_max_correspondence_distance > 0.0)) {
+        throw std::invalid_argument(
+            "MultiStartICP: 'max_correspondence_distance' must be positive");
+    }
+}
+
+std::string MultiStartICP::name() const {
+    return "icp_multistart";
+}
+
+TransMat MultiStartICP::register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                             const TransMat &initial_guess) {
+    return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+}
+
+TransMat MultiStartICP::register_fragments(const Fragment &source, const Fragment &target,
+                                           const TransMat &initial_guess) {
+    return register_multi_start(source, target, initial_guess).transform;
+}
+
+std::vector<TransMat> MultiStartICP::make_seeds(const TransMat &initial_guess) const {
+    std::vector<TransMat> seeds{initial_guess};
+    seeds.reserve(_seeds);
+
+    std::mt19937 rng(_random_seed);
+    std::normal_distribution<float> axis_component(0.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float max_angle = static_cast<float>(_max_rotation_deg * std::numbers::pi / 180.0);
+
+    const auto random_direction = [&]() {
+        Eigen::Vector3f direction;
+        do {
+            direction = Eigen::Vector3f(axis_component(rng), axis_component(rng),
+                                        axis_component(rng));
+        } while (direction.squaredNorm() < 1e-12f);
+        return direction.normalized();
+    };
+
+    while (seeds.size() < static_cast<std::size_t>(_seeds)) {
+        Eigen::Affine3f perturbation = Eigen::Affine3f::Identity();
+        perturbation.rotate(Eigen::AngleAxisf(max_angle * unit(rng), random_direction()));
+        perturbation.pretranslate(random_direction() *
+                                  static_cast<float>(_max_translation) * unit(rng));
+        seeds.emplace_back(perturbation.matrix() * initial_guess);
+    }
+    return seeds;
+}
+
+MultiStartResult MultiStartICP::register_multi_start(const Fragment &source,
+                                                     const Fragment &target,
+                                                     const TransMat &initial_guess) const {
+    if (source.cloud.empty() || target.cloud.empty()) {
+        throw std::runtime_error("MultiStartICP requires non-empty point clouds");
+    }
+
+    // The only per-target work; every seed and stage reuses it.
+    std::shared_ptr<const VoxelHashIndex> index;
+    std::shared_ptr<const SharedSearch> search;
+    if (_backend.uses_voxel_hash()) {
+        index = _backend.index_for(target, "cloud", target.cloud);
+    } else {
+        search = target.derived<SharedSearch>("kdtree", [&target]() {
+            auto shared = std::make_shared<SharedSearch>();
+            shared->tree = std::make_shared<Search>();
+            shared->tree->setInputCloud(target.shared());
+            return shared;
+        });
+    }
+
+    const float max_distance = static_cast<float>(_max_correspondence_distance);
+    const auto score = [&](const PointCloud &aligned, SeedStatistics &stats) {
+        pcl::Indices match(1);
+        std::vector<float> squared(1);
+        double total = 0.0;
+        std::size_t inliers = 0;
+        for (const auto &point : aligned) {
+            float squared_distance = 0.0f;
+            bool found = false;
+            if (index) {
+                std::uint32_t neighbour = 0;
+                found = index->nearest(Eigen::Vector3f(point.x, point.y, point.z), max_distance,
+                                       neighbour, squared_distance);
+            } else if (search->tree->nearestKSearch(point, 1, match, squared) == 1) {
+                squared_distance = squared[0];
+                found = squared_distance <= max_distance * max_distance;
+            }
+            if (found) {
+                total += squared_distance;
+                ++inliers;
+            }
+        }
+        stats.inlier_ratio = static_cast<double>(inliers) / static_cast<double>(aligned.size());
+        stats.rmse = inliers > 0 ? std::sqrt(total / static_cast<double>(inliers))
+                                 : std::numeric_limits<double>::infinity();
+    };
+
+    MultiStartResult result;
+    for (const auto &seed : make_seeds(initial_guess)) {
+        auto &stats = result.seeds.emplace_back();
+        stats.initial = seed;
+        stats.transform = seed;
+    }
+
+    std::vector<std::size_t> running(result.seeds.size());
+    std::iota(running.begin(), running.end(), std::size_t{0});
+    const int threads = omp_team_threads(_threads);
+
+    int stage = 0;
+    for (int spent = 0; spent < _max_iterations && !running.empty(); ++stage) {
+        const int budget = std::min(_stage_iterations, _max_iterations - spent);
+        spent += budget;
+
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+        for (long long slot = 0; slot < static_cast<long long>(running.size()); ++slot) {
+            auto &stats = result.seeds[running[slot]];
+            try {
+                StagedICP icp;
+                icp.setInputSource(source.shared());
+                icp.setInputTarget(target.shared());
+                if (index) {
+                    CorrespondenceBackend::attach(icp, index);
+                } else {
+                    icp.setSearchMethodTarget(search->tree, true);
+                }
+                icp.setMaxCorrespondenceDistance(_max_correspondence_distance);
+                icp.setMaximumIterations(budget);
+                if (_transformation_epsilon > 0.0) {
+                    icp.setTransformationEpsilon(_transformation_epsilon);
+                }
+                if (_euclidean_fitness_epsilon > 0.0) {
+                    icp.setEuclideanFitnessEpsilon(_euclidean_fitness_epsilon);
+                }
+
+                PointCloud aligned;
+                icp.align(aligned, stats.transform);
+                stats.transform = icp.getFinalTransformation();
+                stats.iterations += icp.iterations();
+                stats.converged = seed_converged(icp);
+                score(aligned, stats);
+            } catch (const std::exception &) {
+                // A seed that cannot be aligned (e.g. no correspondences) loses.
+                stats.inlier_ratio = 0.0;
+                stats.rmse = std::numeric_limits<double>::infinity();
+            }
+        }
+
+        // Converged seeds stop iterating but stay candidates for the result.
+        std::erase_if(running, [&](std::size_t seed) { return result.seeds[seed].converged; });
+        if (spent >= _max_iterations || running.size() <= 1) {
+            continue;
+        }
+
+        std::sort(running.begin(), running.end(), [&](std::size_t lhs, std::size_t rhs) {
+            return better(result.seeds[lhs], result.seeds[rhs]);
+        });
+        const auto keep = static_cast<std::size_t>(
+            std::ceil(_keep_fraction * static_cast<double>(running.size())));
+        for (std::size_t slot = keep; slot < running.size(); ++slot) {
+            result.seeds[running[slot]].pruned_after_stage = stage;
+        }
+        running.resize(keep);
+    }
+
+    std::size_t best = 0;
+    for (std::size_t seed = 1; seed < result.seeds.size(); ++seed) {
+        const auto &candidate = result.seeds[seed];
+        const auto &current = result.seeds[best];
+        const bool candidate_alive = candidate.pruned_after_stage < 0;
+        const bool current_alive = current.pruned_after_stage < 0;
+        if ((candidate_alive && !current_alive) ||
+            (candidate_alive == current_alive && better(candidate, current))) {
+            best = seed;
+        }
+    }
+    result.best_seed = best;
+    result.transform = result.seeds[best].transform;
+
+    const auto pruned = std::count_if(result.seeds.begin(), result.seeds.end(),
+                                      [](const SeedStatistics &stats) {
+                                          return stats.pruned_after_stage >= 0;
+                                      });
+    const int total_iterations = std::accumulate(
+        result.seeds.begin(), result.seeds.end(), 0,
+        [](int sum, const SeedStatistics &stats) { return sum + stats.iterations; });
+    // Seeds ran on OpenMP threads; count them for the calling one.
+    record_iterations(static_cast<std::size_t>(total_iterations));
+    log_info("Best of {} seeds is #{} (inliers {:.3f}, rmse {:.4f}) after {} stage(s); "
+             "{} pruned, {} iterations in total",
+             result.seeds.size(), best, result.seeds[best].inlier_ratio,
+             result.seeds[best].rmse, stage, pruned, total_iterations);
+
+    return result;
+}
+
+std::shared_ptr<AlgorithmBase> MultiStartICP::create(const nlohmann::json &config) {
+    return std::make_shared<MultiStartICP>(config);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "algorithm_base.hpp"
+#include "algorithm/voxel_hash_correspondence.hpp"
+#include <vector>
+
+struct SeedStatistics {
+    TransMat initial{TransMat::Identity()};
+    TransMat transform{TransMat::Identity()};
+    // Fraction of source points with a target neighbour within the maximum
+    // correspondence distance after alignment, and their RMS distance.
+    double inlier_ratio{0.0};
+    double rmse{0.0};
+    int iterations{0};
+    bool converged{false};
+    // Stage after which the seed was dropped, or -1 if it ran to the end.
+    int pruned_after_stage{-1};
+};
+
+struct MultiStartResult {
+    TransMat transform{TransMat::Identity()};
+    std::size_t best_seed{0};
+    std::vector<SeedStatistics> seeds;
+};
+
+// Point-to-point ICP started from the initial guess and from `seeds - 1`
+// random perturbations of it. The target search structure is built once per
+// fragment and shared by every seed. Seeds advance in stages of
+// `stage_iterations` iterations run in parallel; after each stage only the
+// best `keep_fraction` of the running seeds (by inlier ratio, then RMSE) go
+// on, so most of the budget is spent on the promising starts.
+class MultiStartICP : public AlgorithmBase {
+public:
+    explicit MultiStartICP(const nlohmann::json& config);
+    std::string name() const override;
+    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                  const TransMat& initial_guess = TransMat::Identity()) override;
+    TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                const TransMat& initial_guess = TransMat::Identity()) override;
+    static std::shared_ptr<AlgorithmBase> create(const nlohmann::json& config);
+
+    // Same as register_fragments, with the statistics of every seed.
+    MultiStartResult register_multi_start(const Fragment& source, const Fragment& target,
+                                          const TransMat& initial_guess) const;
+
+private:
+    std::vector<TransMat> make_seeds(const TransMat& initial_guess) const;
+
+    int _seeds{16};
+    double _max_rotation_deg{10.0};
+    double _max_translation{0.5};
+    unsigned int _random_seed{42};
+    int _max_iterations{50};
+    int _stage_iterations{10};
+    double _keep_fraction{0.5};
+    unsigned int _threads{0};
+    double _max_correspondence_distance{1.0};
+    double _transformation_epsilon{0.0};
+    double _euclidean_fitness_epsilon{0.0};
+    CorrespondenceBackend _backend;
+};
@@ -0,0 +1,94 @@
+#include "algorithm/icp_plane.hpp"
+#include "algorithm/counted_registration.hpp"
+#include "pcl/registration/icp.h"
+#include <stdexcept>
+
+REGISTER_ALGORITHM(icp_plane, ICPPointToPlane);
+ICPPointToPlane::ICPPointToPlane(const nlohmann::json &config)
+    : _normals(NormalEstimationParams::from_json(config)) {
+    _max_iterations = config.value("max_iterations", _max_iterations);
+    _max_correspondence_distance =
+        config.value("max_correspondence_distance", _max_correspondence_distance);
+    _transformation_epsilon = config.value("transformation_epsilon", _transformation_epsilon);
+    _euclidean_fitness_epsilon =
+        config.value("euclidean_fitness_epsilon", _euclidean_fitness_epsilon);
+    _symmetric_objective = config.value("symmetric_objective", _symmetric_objective);
+    _backend = CorrespondenceBackend::from_json(config, _max_correspondence_distance);
+}
+
+std::string ICPPointToPlane::name() const {
+    return "icp_plane";
+}
+
+TransMat ICPPointToPlane::register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                               const TransMat &initial_guess) {
+    return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+}
+
+TransMat ICPPointToPlane::register_fragments(const Fragment &source, const Fragment &target,
+                                             const TransMat &initial_guess) {
+    if (source.cloud.empty() || target.cloud.empty()) {
+        throw std::runtime_error("ICPPointToPlane requires non-empty point clouds");
+    }
+
+    log_info("Aligning source ({} points) to target ({} points)",
+        source.cloud.size(), target.cloud.size());
+
+    auto target_normals = fragment_point_normals(target, _normals);
+    std::shared_ptr<const VoxelHashIndex> index;
+    if (_backend.uses_voxel_hash()) {
+        // Indices refer to the normal cloud, so the index is keyed by it.
+        index = _backend.index_for(target, _normals.cache_key(), *target_normals);
+    }
+    return align(fragment_point_normals(source, _normals), target_normals, index, initial_guess);
+}
+
+TransMat ICPPointToPlane::align(const std::shared_ptr<const PointNormalCloud> &source,
+                                const std::shared_ptr<const PointNormalCloud> &target,
+                                const std::shared_ptr<const VoxelHashIndex> &index,
+                                const TransMat &initial_guess) const {
+    if (source->empty() || target->empty()) {
+        throw std::runtime_error("ICPPointToPlane: no point with a valid normal");
+    }
+
+    CountedRegistration<pcl::IterativeClosestPointWithNormals<pcl::PointNormal, pcl::PointNormal>> icp;
+    icp.setInputSource(source);
+    icp.setInputTarget(target);
+    icp.setMaximumIterations(_max_iterations);
+    icp.setUseSymmetricObjective(_symmetric_objective);
+    if (index) {
+        CorrespondenceBackend::attach(icp, index);
+        icp.setMaxCorrespondenceDistance(_max_correspondence_distance > 0.0
+                                             ? _max_correspondence_distance
+                                             : _backend.voxel_size);
+    } else if (_max_correspondence_distance > 0.0) {
+        icp.setMaxCorrespondenceDistance(_max_correspondence_distance);
+    }
+    if (_transformation_epsilon > 0.0) {
+        icp.setTransformationEpsilon(_transformation_epsilon);
+    }
+    if (_euclidean_fitness_epsilon > 0.0) {
+        icp.setEuclideanFitnessEpsilon(_euclidean_fitness_epsilon);
+    }
+
+    PointNormalCloud aligned;
+    icp.align(aligned, initial_guess);
+    record_iterations(icp.iterations());
+
+    if (!icp.hasConverged()) {
+        throw std::runtime_error("Point-to-plane ICP failed to converge on the provided point clouds");
+    }
+
+    if (index) {
+        // getFitnessScore() would query the target KD-tree, which is not built.
+        log_info("Converged with score {}", voxel_fitness_score(*index, aligned, _backend.voxel_size));
+    } else {
+        log_info("Converged with score {}", icp.getFitnessScore());
+    }
+
+    return icp.getFinalTransformation();
+}
+
+std::shared_ptr<AlgorithmBase> ICPPointToPlane::create(const nlohmann::json &config) {
+    return std::make_shared<ICPPointToPlane>(config);
+}
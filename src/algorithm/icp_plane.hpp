@@ -0,0 +1,31 @@
+#pragma once
+#include "algorithm_base.hpp"
+#include "algorithm/normals.hpp"
+#include "algorithm/voxel_hash_correspondence.hpp"
+
+// Point-to-plane ICP. Normals are estimated once per fragment and reused
+// through the sample's fragment cache.
+class ICPPointToPlane : public AlgorithmBase {
+public:
+    explicit ICPPointToPlane(const nlohmann::json& config);
+    std::string name() const override;
+    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                  const TransMat& initial_guess = TransMat::Identity()) override;
+    TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                const TransMat& initial_guess = TransMat::Identity()) override;
+    static std::shared_ptr<AlgorithmBase> create(const nlohmann::json& config);
+
+private:
+    TransMat align(const std::shared_ptr<const PointNormalCloud>& source,
+                   const std::shared_ptr<const PointNormalCloud>& target,
+                   const std::shared_ptr<const VoxelHashIndex>& index,
+                   const TransMat& initial_guess) const;
+
+    NormalEstimationParams _normals;
+    int _max_iterations{50};
+    double _max_correspondence_distance{0.0};
+    double _transformation_epsilon{0.0};
+    double _euclidean_fitness_epsilon{0.0};
+    bool _symmetric_objective{false};
+    CorrespondenceBackend _backend;
+};
@@ -0,0 +1,118 @@
+#include "algorithm/incremental_voxel_map.hpp"
+#include "algorithm/voxel_key.hpp"
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+IncrementalVoxelMap::IncrementalVoxelMap(float voxel_size, std::size_t max_points_per_voxel)
+    : _voxel_size(voxel_size), _inverse_voxel_size(1.0f / voxel_size),
+      _max_points_per_voxel(max_points_per_voxel), _cloud(std::make_shared<PointCloud>()) {
+    if (!(voxel_size > 0.0f)) {
+        throw std::invalid_argument("IncrementalVoxelMap: voxel size must be positive");
+    }
+    if (max_points_per_voxel == 0) {
+        throw std::invalid_argument("IncrementalVoxelMap: max_points_per_voxel must be positive");
+    }
+    _cloud->is_dense = false;
+}
+
+std::uint64_t IncrementalVoxelMap::key_of(const Eigen::Vector3f &point) const {
+    return pack_voxel_key(voxel_coordinates(point, _inverse_voxel_size));
+}
+
+void IncrementalVoxelMap::insert(std::uint64_t frame, const PointCloud &cloud,
+                                 const TransMat &pose) {
+    evict(frame);
+    auto &slots = _frames[frame];
+    const Eigen::Affine3f transform(pose);
+
+    for (const auto &point : cloud) {
+        if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+            continue;
+        }
+        const Eigen::Vector3f position = transform * point.getVector3fMap();
+        auto &voxel = _voxels[key_of(position)];
+        if (voxel.size() >= _max_points_per_voxel) {
+            continue;
+        }
+
+        std::uint32_t slot = 0;
+        if (!_free.empty()) {
+            slot = _free.back();
+            _free.pop_back();
+            (*_cloud)[slot] = pcl::PointXYZ(position.x(), position.y(), position.z());
+        } else {
+            slot = static_cast<std::uint32_t>(_cloud->size());
+            _cloud->push_back(pcl::PointXYZ(position.x(), position.y(), position.z()));
+        }
+        voxel.emplace_back(slot);
+        slots.emplace_back(slot);
+    }
+    _cloud->width = static_cast<std::uint32_t>(_cloud->size());
+    _cloud->height = 1;
+}
+
+void IncrementalVoxelMap::evict(std::uint64_t frame) {
+    const auto it = _frames.find(frame);
+    if (it == _frames.end()) {
+        return;
+    }
+
+    constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+    for (const auto slot : it->second) {
+        auto &point = (*_cloud)[slot];
+        const auto voxel = _voxels.find(key_of(point.getVector3fMap()));
+        if (voxel != _voxels.end()) {
+            auto &members = voxel->second;
+            const auto member = std::find(members.begin(), members.end(), slot);
+            if (member != members.end()) {
+                *member = members.back();
+                members.pop_back();
+            }
+            if (members.empty()) {
+                _voxels.erase(voxel);
+            }
+        }
+        point = pcl::PointXYZ(nan, nan, nan);
+        _free.emplace_back(slot);
+    }
+    _frames.erase(it);
+}
+
+bool IncrementalVoxelMap::nearest(const Eigen::Vector3f &query, float max_distance,
+                                  std::uint32_t &index, float &squared_distance) const {
+    const Eigen::Vector3i center = voxel_coordinates(query, _inverse_voxel_size);
+    float best = max_distance * max_distance;
+    bool found = false;
+
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const auto voxel =
+                    _voxels.find(pack_voxel_key(center + Eigen::Vector3i(dx, dy, dz)));
+                if (voxel == _voxels.end()) {
+                    continue;
+                }
+                for (const auto slot : voxel->second) {
+                    const auto &point = (*_cloud)[slot];
+                    const float ex = point.x - query.x();
+                    const float ey = point.y - query.y();
+                    const float ez = point.z - query.z();
+                    const float distance = ex * ex + ey * ey + ez * ez;
+                    if (distance <= best) {
+                        best = distance;
+                        index = slot;
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+
+    if (found) {
+        squared_distance = best;
+    }
+    return found;
+}
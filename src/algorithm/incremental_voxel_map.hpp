@@ -0,0 +1,47 @@
+#pragma once
+#include "common.hpp"
+#include <Eigen/Core>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Sliding-window map for online registration. Points are grouped by voxel and
+// tagged with the frame that inserted them, so a frame can be added or
+// evicted in time proportional to its own size, without rebuilding anything.
+// Point storage is a PointCloud whose freed slots are set to NaN and reused,
+// so the slot indices handed out by nearest() stay valid as registration
+// target indices until the next insert or evict.
+class IncrementalVoxelMap {
+public:
+    // At most `max_points_per_voxel` points are kept per voxel; further
+    // points falling into a full voxel are dropped, which bounds density.
+    IncrementalVoxelMap(float voxel_size, std::size_t max_points_per_voxel);
+
+    // Adds the points of `cloud` moved by `pose` under the id `frame`.
+    void insert(std::uint64_t frame, const PointCloud &cloud, const TransMat &pose);
+    // Removes every point of `frame`; does nothing for unknown ids.
+    void evict(std::uint64_t frame);
+
+    // Nearest map point within `max_distance`, searching the 27 voxels around
+    // `query` (exact when `max_distance` does not exceed the voxel size).
+    bool nearest(const Eigen::Vector3f &query, float max_distance, std::uint32_t &index,
+                 float &squared_distance) const;
+
+    // Storage indexed by the slots returned from nearest().
+    PointCloud::ConstPtr cloud() const { return _cloud; }
+    std::size_t size() const { return _cloud->size() - _free.size(); }
+    std::size_t voxel_count() const { return _voxels.size(); }
+    std::size_t frame_count() const { return _frames.size(); }
+    float voxel_size() const { return _voxel_size; }
+
+private:
+    std::uint64_t key_of(const Eigen::Vector3f &point) const;
+
+    float _voxel_size;
+    float _inverse_voxel_size;
+    std::size_t _max_points_per_voxel;
+    PointCloud::Ptr _cloud;
+    std::vector<std::uint32_t> _free;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> _voxels;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> _frames;
+};
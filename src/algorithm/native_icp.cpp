@@ -0,0 +1,77 @@
+#include "algorithm/native_icp.hpp"
+#include "algorithm/pair_arena.hpp"
+#include "algorithm/point_to_plane_kernel.hpp"
+#include <cmath>
+#include <memory_resource>
+#include <stdexcept>
+
+REGISTER_TYPED_ALGORITHM(native_icp, NativeICP);
+
+template <typename PointT, typename Scalar>
+NativeICP<PointT, Scalar>::NativeICP(const nlohmann::json &config) : Base(config) {
+    _settings.max_iterations = config.value("max_iterations", 30);
+    const double max_correspondence_distance = config.value("max_correspondence_distance", 0.0);
+    _backend.kind = CorrespondenceBackend::Kind::VoxelHash;
+    _backend.voxel_size = config.value(
+        "voxel_size", max_correspondence_distance > 0.0
+                          ? static_cast<float>(max_correspondence_distance)
+                          : _backend.voxel_size);
+    if (!(_backend.voxel_size > 0.0f)) {
+        throw std::invalid_argument("'voxel_size' must be positive");
+    }
+    _settings.max_distance = max_correspondence_distance > 0.0
+                                 ? static_cast<float>(max_correspondence_distance)
+                                 : _backend.voxel_size;
+    _settings.transformation_epsilon =
+        config.value("transformation_epsilon", _settings.transformation_epsilon);
+    _settings.euclidean_fitness_epsilon =
+        config.value("euclidean_fitness_epsilon", _settings.euclidean_fitness_epsilon);
+    // Index entries refer to the layout's cloud; the xyz index is the one
+    // "icp" and "inlier_ratio" build too.
+    _index_key = _backend.index_key(PointLayout<PointT>::has_normal ? this->normals().cache_key()
+                                                                    : std::string{"cloud"});
+}
+
+template <typename PointT, typename Scalar>
+std::string NativeICP<PointT, Scalar>::name() const {
+    return "native_icp";
+}
+
+template <typename PointT, typename Scalar>
+BasicTransMat<Scalar> NativeICP<PointT, Scalar>::align(const TypedFragment<PointT> &source,
+                                                       const TypedFragment<PointT> &target,
+                                                       const BasicTransMat<Scalar> &initial_guess) {
+    if (source.cloud->empty() || target.cloud->empty()) {
+        throw std::runtime_error("NativeICP: no point with a valid normal");
+    }
+    const auto index = _backend.cached_index(target.fragment, _index_key, *target.cloud);
+
+    IcpKernelResult<Scalar> result;
+    if constexpr (PointLayout<PointT>::has_normal) {
+        result = align_point_to_plane<Scalar>(*source.cloud, *target.cloud, *index, initial_guess,
+                                              _settings);
+    } else {
+        // Raw clouds may hold NaN returns; the target index leaves them out
+        // and the source must too, as ICP::register_native does.
+        PairArena::Scope scope;
+        std::pmr::vector<Eigen::Vector3f> points(&scope.arena());
+        points.reserve(source.cloud->size());
+        for (const auto &point : *source.cloud) {
+            if (std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z)) {
+                points.emplace_back(point.x, point.y, point.z);
+            }
+        }
+        if (points.empty()) {
+            throw std::runtime_error("NativeICP: no finite source point");
+        }
+        result = align_point_to_point<Scalar>(points, *target.cloud, *index, initial_guess,
+                                              _settings);
+    }
+    this->record_iterations(result.iterations);
+    if (!result.converged) {
+        throw std::runtime_error("NativeICP failed to converge on the provided point clouds");
+    }
+    this->log_debug("<{}> converged with score {} after {} iteration(s)", Base::specialization(),
+                    result.fitness, result.iterations);
+    return result.transform;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "algorithm/point_to_point_kernel.hpp"
+#include "algorithm/typed_algorithm.hpp"
+#include "algorithm/voxel_hash_correspondence.hpp"
+
+// ICP specialized at compile time on point layout and scalar (see
+// TypedAlgorithm): point-to-point on "xyz" clouds, point-to-plane on "normal"
+// clouds, whose normals are estimated once per fragment. Correspondences come
+// from a voxel-hash index of the target built once per fragment, and each
+// specialization runs its own instantiation of the kernel.
+template <typename PointT, typename Scalar>
+class NativeICP : public TypedAlgorithm<NativeICP<PointT, Scalar>, PointT, Scalar> {
+public:
+    using Base = TypedAlgorithm<NativeICP<PointT, Scalar>, PointT, Scalar>;
+
+    explicit NativeICP(const nlohmann::json &config);
+    std::string name() const override;
+
+    BasicTransMat<Scalar> align(const TypedFragment<PointT> &source,
+                                const TypedFragment<PointT> &target,
+                                const BasicTransMat<Scalar> &initial_guess);
+
+private:
+    IcpKernelSettings _settings;
+    CorrespondenceBackend _backend;
+    std::string _index_key;
+};
@@ -0,0 +1,359 @@
+#include "algorithm/ndt.hpp"
+#include "affinity.hpp"
+#include "algorithm/voxel_key.hpp"
+#include <Eigen/Eigenvalues>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+REGISTER_ALGORITHM(ndt, NDT);
+
+namespace {
+// Source points per accumulation block. Blocks are reduced in order, so the
+// sums are the same for any number of threads.
+constexpr std::size_t BLOCK_POINTS = 2048;
+
+// Offsets of the voxels searched around a point, the own voxel first.
+constexpr int NEIGHBOR_OFFSETS[7][3] = {
+    {0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+};
+
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+// Applies the increment (translation, rotation vector) on the left.
+Eigen::Matrix4d apply_increment(const Vector6d &step, const Eigen::Matrix4d &transform) {
+    Eigen::Matrix4d increment = Eigen::Matrix4d::Identity();
+    const Eigen::Vector3d rotation = step.tail<3>();
+    const double angle = rotation.norm();
+    if (angle > 0.0) {
+        increment.topLeftCorner<3, 3>() =
+            Eigen::AngleAxisd(angle, rotation / angle).toRotationMatrix();
+    }
+    increment.topRightCorner<3, 1>() = step.head<3>();
+    return increment * transform;
+}
+} // namespace
+
+NdtGrid::NdtGrid(const PointCloud &cloud, float resolution, std::size_t min_points,
+                 double min_eigenvalue_ratio, int threads)
+    : _resolution(resolution), _inverse_resolution(1.0f / resolution) {
+    // Points sorted by voxel key, so every voxel is one contiguous run.
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> keyed(cloud.size());
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (long long idx = 0; idx < static_cast<long long>(cloud.size()); ++idx) {
+        const auto &point = cloud[idx];
+        const bool finite =
+            std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z);
+        keyed[idx] = {finite ? pack_voxel_key(voxel_coordinates(point.getVector3fMap(),
+                                                                _inverse_resolution))
+                             : EMPTY,
+                      static_cast<std::uint32_t>(idx)};
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    for (std::size_t begin = 0; begin < keyed.size() && keyed[begin].first != EMPTY;) {
+        std::size_t end = begin + 1;
+        while (end < keyed.size() && keyed[end].first == keyed[begin].first) {
+            ++end;
+        }
+        if (end - begin >= min_points) {
+            runs.emplace_back(begin, end);
+        }
+        begin = end;
+    }
+
+    std::vector<Cell> cells(runs.size());
+    std::vector<char> valid(runs.size(), 0);
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+    for (long long run = 0; run < static_cast<long long>(runs.size()); ++run) {
+        const auto [begin, end] = runs[run];
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d second = Eigen::Matrix3d::Zero();
+        for (std::size_t idx = begin; idx < end; ++idx) {
+            const Eigen::Vector3d point = cloud[keyed[idx].second].getVector3fMap().cast<double>();
+            mean += point;
+            second.noalias() += point * point.transpose();
+        }
+        const double count = static_cast<double>(end - begin);
+        mean /= count;
+        // Sample covariance, as in pcl::VoxelGridCovariance.
+        const Eigen::Matrix3d covariance =
+            (second - count * mean * mean.transpose()) / (count - 1.0);
+
+        const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+        Eigen::Vector3d eigenvalues = solver.eigenvalues();
+        const double largest = eigenvalues.maxCoeff();
+        if (!(largest > 0.0)) {
+            continue;
+        }
+        eigenvalues = eigenvalues.cwiseMax(min_eigenvalue_ratio * largest);
+        cells[run].mean = mean;
+        cells[run].inverse_covariance = solver.eigenvectors() *
+                                        eigenvalues.cwiseInverse().asDiagonal() *
+                                        solver.eigenvectors().transpose();
+        valid[run] = 1;
+    }
+
+    std::vector<std::uint64_t> keys;
+    for (std::size_t run = 0; run < runs.size(); ++run) {
+        if (valid[run] != 0) {
+            _cells.emplace_back(std::move(cells[run]));
+            keys.emplace_back(keyed[runs[run].first].first);
+        }
+    }
+
+    const auto capacity = std::bit_ceil(std::max<std::size_t>(2 * _cells.size(), 16));
+    _mask = capacity - 1;
+    _slots.assign(capacity, Slot{});
+    for (std::size_t cell = 0; cell < _cells.size(); ++cell) {
+        auto slot = hash_voxel_key(keys[cell]) & _mask;
+        while (_slots[slot].key != EMPTY) {
+            slot = (slot + 1) & _mask;
+        }
+        _slots[slot] = {keys[cell], static_cast<std::uint32_t>(cell)};
+    }
+}
+
+const NdtGrid::Cell *NdtGrid::find(const Eigen::Vector3i &voxel) const {
+    const auto key = pack_voxel_key(voxel);
+    for (auto slot = hash_voxel_key(key) & _mask;; slot = (slot + 1) & _mask) {
+        if (_slots[slot].key == key) {
+            return &_cells[_slots[slot].cell];
+        }
+        if (_slots[slot].key == EMPTY) {
+            return nullptr;
+        }
+    }
+}
+
+struct NDT::Derivatives {
+    Vector6d gradient{Vector6d::Zero()};
+    Matrix6d hessian{Matrix6d::Zero()};
+};
+
+NDT::NDT(const nlohmann::json &config) {
+    _resolution = config.value("resolution", _resolution);
+    _max_iterations = config.value("max_iterations", _max_iterations);
+    _step_size = config.value("step_size", _step_size);
+    _transformation_epsilon = config.value("transformation_epsilon", _transformation_epsilon);
+    _outlier_ratio = config.value("outlier_ratio", _outlier_ratio);
+    _min_points_per_voxel = config.value("min_points_per_voxel", _min_points_per_voxel);
+    _min_eigenvalue_ratio = config.value("min_eigenvalue_ratio", _min_eigenvalue_ratio);
+    _neighborhood = config.value("neighborhood", _neighborhood);
+    _threads = config.value("threads", _threads);
+
+    if (!(_resolution > 0.0)) {
+        throw std::invalid_argument("NDT: 'resolution' must be positive");
+    }
+    if (!(_outlier_ratio > 0.0 && _outlier_ratio < 1.0)) {
+        throw std::invalid_argument("NDT: 'outlier_ratio' must be in (0, 1)");
+    }
+    if (!(_step_size > 0.0)) {
+        throw std::invalid_argument("NDT: 'step_size' must be positive");
+    }
+    if (_min_points_per_voxel < 3) {
+        throw std::invalid_argument("NDT: 'min_points_per_voxel' must be at least 3");
+    }
+    if (_neighborhood != 1 && _neighborhood != 7) {
+        throw std::invalid_argument("NDT: 'neighborhood' must be 1 or 7");
+    }
+
+    // Mixture of a normal distribution and a uniform outlier term,
+    // approximated by a Gaussian.
+    const double c1 = 10.0 * (1.0 - _outlier_ratio);
+    const double c2 = _outlier_ratio / std::pow(_resolution, 3);
+    const double d3 = -std::log(c2);
+    _d1 = -std::log(c1 + c2) - d3;
+    _d2 = -2.0 * std::log((-std::log(c1 * std::exp(-0.5) + c2) - d3) / _d1);
+}
+
+std::string NDT::name() const {
+    return "ndt";
+}
+
+std::shared_ptr<const NdtGrid> NDT::target_grid(const Fragment &fragment) const {
+    return fragment.derived<NdtGrid>(
+        std::format("ndt/res={}/min={}/eig={}", _resolution, _min_points_per_voxel,
+                    _min_eigenvalue_ratio),
+        [this, &fragment]() {
+            return std::make_shared<NdtGrid>(fragment.cloud, static_cast<float>(_resolution),
+                                             _min_points_per_voxel, _min_eigenvalue_ratio,
+                                             omp_team_threads(_threads));
+        });
+}
+
+void NDT::prepare_targets(const std::vector<Fragment> &targets) {
+    const int threads = omp_team_threads(_threads);
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for (long long idx = 0; idx < static_cast<long long>(targets.size()); ++idx) {
+        // A grid that fails to build is not cached, and fails again with
+        // the pair that needs it.
+        try {
+            target_grid(targets[idx]);
+        } catch (const std::exception &) {
+        }
+    }
+}
+
+double NDT::evaluate(const PointCloud &source, const NdtGrid &grid,
+                     const Eigen::Matrix4d &transform, Derivatives *derivatives) const {
+    struct Block {
+        double score{0.0};
+        Derivatives derivatives;
+    };
+    const std::size_t block_count = (source.size() + BLOCK_POINTS - 1) / BLOCK_POINTS;
+    std::vector<Block> blocks(block_count);
+    const Eigen::Matrix3d rotation = transform.topLeftCorner<3, 3>();
+    const Eigen::Vector3d translation = transform.topRightCorner<3, 1>();
+    const int threads = omp_team_threads(_threads);
+
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (long long block = 0; block < static_cast<long long>(block_count); ++block) {
+        auto &sums = blocks[block];
+        const auto begin = static_cast<std::size_t>(block) * BLOCK_POINTS;
+        const std::size_t end = std::min(source.size(), begin + BLOCK_POINTS);
+        for (std::size_t idx = begin; idx < end; ++idx) {
+            const Eigen::Vector3d point =
+                rotation * source[idx].getVector3fMap().cast<double>() + translation;
+            if (!point.allFinite()) {
+                continue;
+            }
+            const Eigen::Vector3i voxel =
+                voxel_coordinates(point.cast<float>(), grid.inverse_resolution());
+            // d point / d (translation, rotation) = [I, -[point]x].
+            Eigen::Matrix<double, 3, 6> jacobian;
+            jacobian.leftCols<3>().setIdentity();
+            jacobian.rightCols<3>() << 0.0, point.z(), -point.y(), -point.z(), 0.0, point.x(),
+                point.y(), -point.x(), 0.0;
+
+            for (int neighbor = 0; neighbor < _neighborhood; ++neighbor) {
+                const auto *cell = grid.find(
+                    voxel + Eigen::Vector3i(NEIGHBOR_OFFSETS[neighbor][0],
+                                            NEIGHBOR_OFFSETS[neighbor][1],
+                                            NEIGHBOR_OFFSETS[neighbor][2]));
+                if (cell == nullptr) {
+                    continue;
+                }
+                const Eigen::Vector3d offset = point - cell->mean;
+                const Eigen::Vector3d weighted = cell->inverse_covariance * offset;
+                const double exponent = std::exp(-0.5 * _d2 * offset.dot(weighted));
+                if (!(exponent > 0.0)) {
+                    continue;
+                }
+                sums.score += -_d1 * exponent;
+                if (derivatives == nullptr) {
+                    continue;
+                }
+
+                const double factor = _d1 * _d2 * exponent;
+                const Vector6d projected = jacobian.transpose() * weighted;
+                sums.derivatives.gradient.noalias() += factor * projected;
+                Matrix6d hessian = jacobian.transpose() * cell->inverse_covariance * jacobian;
+                hessian.noalias() -= _d2 * projected * projected.transpose();
+                // Second derivative of the rotated point, contracted with
+                // the weighted offset.
+                Eigen::Matrix3d curvature =
+                    0.5 * (point * weighted.transpose() + weighted * point.transpose());
+                curvature.diagonal().array() -= weighted.dot(point);
+                hessian.bottomRightCorner<3, 3>() += curvature;
+                sums.derivatives.hessian.noalias() += factor * hessian;
+            }
+        }
+    }
+
+    double score = 0.0;
+    if (derivatives != nullptr) {
+        *derivatives = Derivatives{};
+    }
+    for (const auto &block : blocks) {
+        score += block.score;
+        if (derivatives != nullptr) {
+            derivatives->gradient += block.derivatives.gradient;
+            derivatives->hessian += block.derivatives.hessian;
+        }
+    }
+    return score;
+}
+
+TransMat NDT::register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                   const TransMat &initial_guess) {
+    return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+}
+
+TransMat NDT::register_fragments(const Fragment &source, const Fragment &target,
+                                 const TransMat &initial_guess) {
+    if (source.cloud.empty() || target.cloud.empty()) {
+        throw std::runtime_error("NDT requires non-empty point clouds");
+    }
+
+    log_info("Aligning source ({} points) to target ({} points)",
+        source.cloud.size(), target.cloud.size());
+
+    const auto grid = target_grid(target);
+    if (grid->size() == 0) {
+        throw std::runtime_error(std::format(
+            "NDT: no voxel of the target holds {} points at resolution {}",
+            _min_points_per_voxel, _resolution));
+    }
+
+    // The score is maximized; Newton steps are taken on its negation.
+    Eigen::Matrix4d transform = initial_guess.cast<double>();
+    Derivatives derivatives;
+    double score = evaluate(source.cloud, *grid, transform, &derivatives);
+    if (!(score > 0.0)) {
+        throw std::runtime_error("NDT: no source point falls near a target distribution");
+    }
+
+    int iterations = 0;
+    while (iterations < _max_iterations) {
+        ++iterations;
+        // The negated Hessian is shifted until positive definite, which
+        // bends the step towards steepest ascent away from a maximum.
+        Matrix6d curvature = -derivatives.hessian;
+        const Eigen::SelfAdjointEigenSolver<Matrix6d> solver(curvature, Eigen::EigenvaluesOnly);
+        const double smallest = solver.eigenvalues().minCoeff();
+        const double largest = solver.eigenvalues().cwiseAbs().maxCoeff();
+        if (smallest <= 1e-6 * largest) {
+            curvature.diagonal().array() += 1e-6 * largest - smallest + 1e-12;
+        }
+        Vector6d step = curvature.ldlt().solve(derivatives.gradient);
+        if (!step.allFinite()) {
+            break;
+        }
+        if (step.norm() > _step_size) {
+            step *= _step_size / step.norm();
+        }
+
+        // Backtracks until the score improves.
+        bool improved = false;
+        for (int halving = 0; halving < 10; ++halving) {
+            const auto candidate = apply_increment(step, transform);
+            if (evaluate(source.cloud, *grid, candidate, nullptr) > score) {
+                transform = candidate;
+                improved = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        if (!improved || step.norm() < _transformation_epsilon) {
+            break;
+        }
+        score = evaluate(source.cloud, *grid, transform, &derivatives);
+    }
+    record_iterations(static_cast<std::size_t>(iterations));
+
+    log_info("Finished after {} iterations with score {:.4f} per point", iterations,
+             score / static_cast<double>(source.cloud.size()));
+
+    return transform.cast<float>();
+}
+
+std::shared_ptr<AlgorithmBase> NDT::create(const nlohmann::json &config) {
+    return std::make_shared<NDT>(config);
+}
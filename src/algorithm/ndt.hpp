@@ -0,0 +1,95 @@
+#pragma once
+#include "algorithm_base.hpp"
+#include <Eigen/Core>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Normal distributions of one fragment over a voxel grid: the mean and
+// inverse covariance of the points of every voxel holding enough of them.
+// Built once per (fragment, resolution) and shared by every pair the
+// fragment is the target of. Voxels are found through an open-addressing
+// table over packed voxel keys, as in VoxelHashIndex.
+class NdtGrid {
+public:
+    struct Cell {
+        Eigen::Vector3d mean;
+        Eigen::Matrix3d inverse_covariance;
+    };
+
+    // Voxels with fewer than `min_points` points are left out. Covariance
+    // eigenvalues are raised to at least `min_eigenvalue_ratio` times the
+    // largest, so flat and linear voxels stay invertible. Built on `threads`
+    // OpenMP threads.
+    NdtGrid(const PointCloud &cloud, float resolution, std::size_t min_points,
+            double min_eigenvalue_ratio, int threads);
+
+    // nullptr when voxel `voxel` holds no distribution.
+    const Cell *find(const Eigen::Vector3i &voxel) const;
+
+    float resolution() const { return _resolution; }
+    float inverse_resolution() const { return _inverse_resolution; }
+    std::size_t size() const { return _cells.size(); }
+
+private:
+    struct Slot {
+        std::uint64_t key{EMPTY};
+        std::uint32_t cell{0};
+    };
+
+    static constexpr std::uint64_t EMPTY = std::numeric_limits<std::uint64_t>::max();
+
+    float _resolution;
+    float _inverse_resolution;
+    std::size_t _mask{0};
+    std::vector<Slot> _slots;
+    std::vector<Cell> _cells;
+};
+
+// Normal Distributions Transform (Magnusson): maximizes the likelihood of the
+// source points under the target's voxel distributions with Newton steps on
+// an SE(3) increment. Target grids come from the fragment cache, and
+// prepare_targets() builds those of a whole sequence before its first pair. The score, gradient and Hessian of an iteration are accumulated
+// over blocks of source points on OpenMP threads and reduced in block order,
+// so results do not depend on the thread count. Runner tasks are already
+// spread over the pool, so all of this runs on one thread per task unless the
+// "threads" key asks for more; set it (e.g. to the cores left idle by a
+// small runner pool) for prepare_targets() to build grids in parallel.
+class NDT : public AlgorithmBase {
+public:
+    explicit NDT(const nlohmann::json& config);
+    std::string name() const override;
+    TransMat register_point_cloud(const PointCloud& source, const PointCloud& target,
+                                  const TransMat& initial_guess = TransMat::Identity()) override;
+    TransMat register_fragments(const Fragment& source, const Fragment& target,
+                                const TransMat& initial_guess = TransMat::Identity()) override;
+    void prepare_targets(const std::vector<Fragment>& targets) override;
+    static std::shared_ptr<AlgorithmBase> create(const nlohmann::json& config);
+
+private:
+    struct Derivatives;
+
+    std::shared_ptr<const NdtGrid> target_grid(const Fragment& fragment) const;
+    // Score of `source` under `grid` after `transform`, with its gradient and
+    // Hessian in a left SE(3) increment (translation, rotation) when
+    // `derivatives` is set.
+    double evaluate(const PointCloud& source, const NdtGrid& grid,
+                    const Eigen::Matrix4d& transform, Derivatives* derivatives) const;
+
+    double _resolution{1.0};
+    int _max_iterations{35};
+    double _step_size{0.1};
+    double _transformation_epsilon{1e-4};
+    double _outlier_ratio{0.55};
+    std::size_t _min_points_per_voxel{6};
+    double _min_eigenvalue_ratio{0.01};
+    // 1 searches the voxel a point falls in; 7 adds its face neighbours.
+    int _neighborhood{7};
+    // OpenMP threads for grids, prepare_targets() and iterations
+    // ("threads"); 0 resolves through omp_team_threads(), i.e. one on runner
+    // workers, where target preparation is then serial.
+    unsigned int _threads{0};
+    // Gaussian fitting constants of the score (Magnusson 2009, eq. 6.8).
+    double _d1{0.0};
+    double _d2{0.0};
+};
@@ -0,0 +1,63 @@
+#include "algorithm/normals.hpp"
+#include "affinity.hpp"
+#include <cmath>
+#include <format>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/search/kdtree.h>
+
+NormalEstimationParams NormalEstimationParams::from_json(const nlohmann::json &config) {
+    NormalEstimationParams params;
+    params.k = config.value("normal_k", params.k);
+    params.radius = config.value("normal_radius", params.radius);
+    params.threads = config.value("normal_threads", params.threads);
+    return params;
+}
+
+std::string NormalEstimationParams::cache_key() const {
+    // The thread count does not change the result and is left out.
+    return radius > 0.0 ? std::format("point_normals/r={}", radius)
+                        : std::format("point_normals/k={}", k);
+}
+
+PointNormalCloud::Ptr compute_point_normals(const PointCloud::ConstPtr &cloud,
+                                            const NormalEstimationParams &params) {
+    pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> estimation(
+        static_cast<unsigned int>(omp_team_threads(params.threads)));
+    estimation.setInputCloud(cloud);
+    estimation.setSearchMethod(std::make_shared<pcl::search::KdTree<pcl::PointXYZ>>());
+    if (params.radius > 0.0) {
+        estimation.setRadiusSearch(params.radius);
+    } else {
+        estimation.setKSearch(params.k);
+    }
+
+    pcl::PointCloud<pcl::Normal> normals;
+    estimation.compute(normals);
+
+    auto result = std::make_shared<PointNormalCloud>();
+    result->reserve(cloud->size());
+    for (std::size_t idx = 0; idx < cloud->size(); ++idx) {
+        const auto &normal = normals[idx];
+        if (!std::isfinite(normal.normal_x) || !std::isfinite(normal.normal_y) ||
+            !std::isfinite(normal.normal_z)) {
+            continue;
+        }
+        pcl::PointNormal point;
+        point.x = (*cloud)[idx].x;
+        point.y = (*cloud)[idx].y;
+        point.z = (*cloud)[idx].z;
+        point.normal_x = normal.normal_x;
+        point.normal_y = normal.normal_y;
+        point.normal_z = normal.normal_z;
+        point.curvature = normal.curvature;
+        result->push_back(point);
+    }
+    return result;
+}
+
+std::shared_ptr<const PointNormalCloud> fragment_point_normals(
+    const Fragment &fragment, const NormalEstimationParams &params) {
+    return fragment.derived<PointNormalCloud>(params.cache_key(), [&fragment, &params]() {
+        return compute_point_normals(fragment.shared(), params);
+    });
+}
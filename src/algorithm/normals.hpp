@@ -0,0 +1,31 @@
+#pragma once
+#include "common.hpp"
+#include "fragment_cache.hpp"
+#include <nlohmann/json.hpp>
+#include <pcl/point_types.h>
+#include <string>
+
+using PointNormalCloud = pcl::PointCloud<pcl::PointNormal>;
+
+struct NormalEstimationParams {
+    // Neighbourhood used for the local plane fit: `k` nearest neighbours, or
+    // all neighbours within `radius` when it is positive.
+    int k{20};
+    double radius{0.0};
+    // OpenMP threads for a single fragment; 0 uses one on runner workers,
+    // which already occupy every core, and all hardware threads elsewhere.
+    unsigned int threads{0};
+
+    static NormalEstimationParams from_json(const nlohmann::json &config);
+    std::string cache_key() const;
+};
+
+// Points of `cloud` with their estimated normals; points whose normal cannot
+// be estimated are dropped.
+PointNormalCloud::Ptr compute_point_normals(const PointCloud::ConstPtr &cloud,
+                                            const NormalEstimationParams &params);
+
+// Same as compute_point_normals, computed once per fragment through the
+// sample's cache and shared by every pair and algorithm using `params`.
+std::shared_ptr<const PointNormalCloud> fragment_point_normals(
+    const Fragment &fragment, const NormalEstimationParams &params);
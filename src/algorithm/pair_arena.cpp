@@ -0,0 +1,52 @@
+#include "algorithm/pair_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+PairArena &PairArena::local() {
+    thread_local PairArena arena;
+    return arena;
+}
+
+std::size_t PairArena::capacity() const {
+    std::size_t total = 0;
+    for (const auto &chunk : _chunks) {
+        total += chunk.size;
+    }
+    return total;
+}
+
+void *PairArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    while (_chunk < _chunks.size()) {
+        auto &chunk = _chunks[_chunk];
+        const auto base = reinterpret_cast<std::uintptr_t>(chunk.data.get());
+        const auto aligned = (base + _offset + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+        if (aligned + bytes <= base + chunk.size) {
+            _offset = aligned + bytes - base;
+            return reinterpret_cast<void *>(aligned);
+        }
+        ++_chunk;
+        _offset = 0;
+    }
+
+    // Out of retained memory: add a chunk at least as large as everything so
+    // far, so the number of chunks stays logarithmic in the peak.
+    const auto size = std::max({INITIAL_CHUNK, capacity(), bytes + alignment});
+    _chunks.push_back(Chunk{std::make_unique<std::byte[]>(size), size});
+    ++_chunk_allocations;
+    _chunk = _chunks.size() - 1;
+    _offset = 0;
+    return do_allocate(bytes, alignment);
+}
+
+void PairArena::reset() {
+    // A pair that spilled into several chunks gets one chunk of the combined
+    // size, so the next pair of that size is served without a new chunk.
+    if (_chunk > 0) {
+        const auto size = capacity();
+        _chunks.clear();
+        _chunks.push_back(Chunk{std::make_unique<std::byte[]>(size), size});
+        ++_chunk_allocations;
+    }
+    _chunk = 0;
+    _offset = 0;
+}
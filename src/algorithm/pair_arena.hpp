@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Per-thread bump allocator for the temporaries of one registration. Memory is
+// handed out from retained chunks and only reclaimed when the outermost Scope
+// on the thread ends, so deallocation is free and, once the arena has grown to
+// the largest pair seen, no further heap allocation happens. Use it through
+// std::pmr containers:
+//
+//     PairArena::Scope scope;
+//     std::pmr::vector<Eigen::Vector3f> points(&scope.arena());
+//
+// Memory from the arena must not outlive the scope it was taken in.
+class PairArena : public std::pmr::memory_resource {
+public:
+    class Scope {
+    public:
+        Scope() : _arena(PairArena::local()) { ++_arena._depth; }
+        ~Scope() {
+            if (--_arena._depth == 0) {
+                _arena.reset();
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        PairArena &arena() { return _arena; }
+
+    private:
+        PairArena &_arena;
+    };
+
+    // The calling thread's arena.
+    static PairArena &local();
+
+    // Bytes retained across pairs.
+    std::size_t capacity() const;
+    // Chunks requested from the heap since the thread started.
+    std::size_t chunk_allocations() const { return _chunk_allocations; }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size{0};
+    };
+
+    static constexpr std::size_t INITIAL_CHUNK = std::size_t{1} << 20;
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    void reset();
+
+    std::vector<Chunk> _chunks;
+    std::size_t _chunk{0};
+    std::size_t _offset{0};
+    std::size_t _chunk_allocations{0};
+    int _depth{0};
+};
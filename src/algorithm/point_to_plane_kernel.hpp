@@ -0,0 +1,91 @@
+#pragma once
+#include "algorithm/point_to_point_kernel.hpp"
+#include <Eigen/Cholesky>
+#include <Eigen/Geometry>
+
+// Point-to-plane ICP against a nearest-neighbour `index` of `target`, whose
+// points carry normals (normal_x/y/z). Each iteration streams the source
+// once, accumulating the Gauss-Newton normal equations of the linearized
+// residual n . (R p + t - q) in `Scalar`, and applies the small-angle update
+// through the exponential map; nothing is allocated inside the loop.
+template <typename Scalar = double, typename Source, typename TargetPoint, typename Index>
+IcpKernelResult<Scalar> align_point_to_plane(const Source &source,
+                                             const BasicPointCloud<TargetPoint> &target,
+                                             const Index &index,
+                                             const BasicTransMat<Scalar> &initial_guess,
+                                             const IcpKernelSettings &settings) {
+    using Vector3 = Eigen::Matrix<Scalar, 3, 1>;
+    using Vector6 = Eigen::Matrix<Scalar, 6, 1>;
+    using Matrix3 = Eigen::Matrix<Scalar, 3, 3>;
+    using Matrix6 = Eigen::Matrix<Scalar, 6, 6>;
+
+    IcpKernelResult<Scalar> result;
+    result.transform = initial_guess;
+    double previous_mse = -1.0;
+
+    for (int iteration = 0; iteration < settings.max_iterations; ++iteration) {
+        const Matrix3 rotation = result.transform.template topLeftCorner<3, 3>();
+        const Vector3 translation = result.transform.template topRightCorner<3, 1>();
+
+        Matrix6 hessian = Matrix6::Zero();
+        Vector6 gradient = Vector6::Zero();
+        double squared_error = 0.0;
+        std::size_t matched = 0;
+        for (const auto &point : source) {
+            const Vector3 p = rotation * kernel_position(point).template cast<Scalar>() + translation;
+            std::uint32_t match = 0;
+            float squared_distance = 0.0f;
+            if (!index.nearest(p.template cast<float>(), settings.max_distance, match,
+                               squared_distance)) {
+                continue;
+            }
+            const auto &target_point = target[match];
+            const Vector3 q = kernel_position(target_point).template cast<Scalar>();
+            const Vector3 n(static_cast<Scalar>(target_point.normal_x),
+                            static_cast<Scalar>(target_point.normal_y),
+                            static_cast<Scalar>(target_point.normal_z));
+            const Scalar residual = n.dot(p - q);
+            Vector6 jacobian;
+            jacobian << p.cross(n), n;
+            hessian.template selfadjointView<Eigen::Lower>().rankUpdate(jacobian);
+            gradient.noalias() += jacobian * residual;
+            squared_error += squared_distance;
+            ++matched;
+        }
+
+        result.iterations = iteration + 1;
+        if (matched < 6) {
+            result.converged = false;
+            return result;
+        }
+
+        const Vector6 delta =
+            hessian.template selfadjointView<Eigen::Lower>().ldlt().solve(-gradient);
+        if (!delta.allFinite()) {
+            result.converged = false;
+            return result;
+        }
+        const Vector3 omega = delta.template head<3>();
+        const Scalar angle = omega.norm();
+        const Matrix3 step_rotation =
+            angle > Scalar(0)
+                ? Eigen::AngleAxis<Scalar>(angle, omega / angle).toRotationMatrix()
+                : Matrix3::Identity();
+        const Vector3 step_translation = delta.template tail<3>();
+
+        BasicTransMat<Scalar> step = BasicTransMat<Scalar>::Identity();
+        step.template topLeftCorner<3, 3>() = step_rotation;
+        step.template topRightCorner<3, 1>() = step_translation;
+        result.transform = step * result.transform;
+
+        result.fitness = squared_error / static_cast<double>(matched);
+        if (icp_kernel_detail::converged(step_rotation, step_translation, result.fitness,
+                                         previous_mse, settings)) {
+            result.converged = true;
+            return result;
+        }
+    }
+
+    result.converged = true;
+    return result;
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "common.hpp"
+#include <Eigen/Core>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Convergence settings of the native ICP kernels, mirroring
+// pcl::IterativeClosestPoint's defaults.
+struct IcpKernelSettings {
+    int max_iterations{10};
+    float max_distance{1.0f};
+    // Squared translation change below which the estimate has converged; 0
+    // disables the test.
+    double transformation_epsilon{0.0};
+    // Cosine of the rotation change above which the estimate has converged.
+    double rotation_epsilon{0.99999};
+    // Relative change of the mean squared error below which the estimate has
+    // converged; 0 disables the test, which PCL's default does too. An
+    // absolute change below 1e-12 always counts as converged, as in PCL.
+    double euclidean_fitness_epsilon{0.0};
+};
+
+template <typename Scalar>
+struct IcpKernelResult {
+    BasicTransMat<Scalar> transform{BasicTransMat<Scalar>::Identity()};
+    bool converged{false};
+    int iterations{0};
+    // Mean squared correspondence distance of the last iteration.
+    double fitness{0.0};
+};
+
+// Position of a source element: a bare vector or any PCL point.
+inline Eigen::Vector3f kernel_position(const Eigen::Vector3f &point) { return point; }
+
+template <typename PointT>
+Eigen::Vector3f kernel_position(const PointT &point) {
+    return Eigen::Vector3f(point.x, point.y, point.z);
+}
+
+namespace icp_kernel_detail {
+// Applies the convergence tests shared by the kernels to one update; true
+// when iterating can stop.
+template <typename Scalar>
+bool converged(const Eigen::Matrix<Scalar, 3, 3> &step_rotation,
+               const Eigen::Matrix<Scalar, 3, 1> &step_translation, double mse,
+               double &previous_mse, const IcpKernelSettings &settings) {
+    const double cos_angle =
+        std::clamp((static_cast<double>(step_rotation.trace()) - 1.0) * 0.5, -1.0, 1.0);
+    if (settings.transformation_epsilon > 0.0 &&
+        static_cast<double>(step_translation.squaredNorm()) <= settings.transformation_epsilon &&
+        cos_angle >= settings.rotation_epsilon) {
+        return true;
+    }
+    if (previous_mse >= 0.0) {
+        const double change = std::abs(mse - previous_mse);
+        if (change < 1e-12 || (settings.euclidean_fitness_epsilon > 0.0 &&
+                               change / previous_mse <= settings.euclidean_fitness_epsilon)) {
+            return true;
+        }
+    }
+    previous_mse = mse;
+    return false;
+}
+} // namespace icp_kernel_detail
+
+// Point-to-point ICP against a nearest-neighbour `index` of `target`
+// (VoxelHashIndex or anything with the same nearest()). Each iteration
+// streams the source once, accumulating the matched centroids and
+// cross-covariance in `Scalar` instead of storing correspondences, and solves
+// the rigid update in closed form (Umeyama), so the loop itself never touches
+// the heap. `source` is any range of points or Eigen::Vector3f, instantiated
+// for the exact layout the caller holds.
+template <typename Scalar = double, typename Source, typename TargetPoint, typename Index>
+IcpKernelResult<Scalar> align_point_to_point(const Source &source,
+                                             const BasicPointCloud<TargetPoint> &target,
+                                             const Index &index,
+                                             const BasicTransMat<Scalar> &initial_guess,
+                                             const IcpKernelSettings &settings) {
+    using Vector3 = Eigen::Matrix<Scalar, 3, 1>;
+    using Matrix3 = Eigen::Matrix<Scalar, 3, 3>;
+
+    IcpKernelResult<Scalar> result;
+    result.transform = initial_guess;
+    double previous_mse = -1.0;
+
+    for (int iteration = 0; iteration < settings.max_iterations; ++iteration) {
+        const Matrix3 rotation = result.transform.template topLeftCorner<3, 3>();
+        const Vector3 translation = result.transform.template topRightCorner<3, 1>();
+
+        Vector3 source_sum = Vector3::Zero();
+        Vector3 target_sum = Vector3::Zero();
+        Matrix3 cross = Matrix3::Zero();
+        double squared_error = 0.0;
+        std::size_t matched = 0;
+        for (const auto &point : source) {
+            const Vector3 p = rotation * kernel_position(point).template cast<Scalar>() + translation;
+            std::uint32_t match = 0;
+            float squared_distance = 0.0f;
+            if (!index.nearest(p.template cast<float>(), settings.max_distance, match,
+                               squared_distance)) {
+                continue;
+            }
+            const Vector3 q = kernel_position(target[match]).template cast<Scalar>();
+            source_sum += p;
+            target_sum += q;
+            cross.noalias() += p * q.transpose();
+            squared_error += squared_distance;
+            ++matched;
+        }
+
+        result.iterations = iteration + 1;
+        if (matched < 3) {
+            result.converged = false;
+            return result;
+        }
+
+        const Scalar count = static_cast<Scalar>(matched);
+        const Vector3 source_mean = source_sum / count;
+        const Vector3 target_mean = target_sum / count;
+        const Matrix3 covariance = cross - count * source_mean * target_mean.transpose();
+        const Eigen::JacobiSVD<Matrix3> svd(covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+        Matrix3 step_rotation = svd.matrixV() * svd.matrixU().transpose();
+        if (step_rotation.determinant() < Scalar(0)) {
+            Matrix3 v = svd.matrixV();
+            v.col(2) *= Scalar(-1);
+            step_rotation = v * svd.matrixU().transpose();
+        }
+        const Vector3 step_translation = target_mean - step_rotation * source_mean;
+
+        BasicTransMat<Scalar> step = BasicTransMat<Scalar>::Identity();
+        step.template topLeftCorner<3, 3>() = step_rotation;
+        step.template topRightCorner<3, 1>() = step_translation;
+        result.transform = step * result.transform;
+
+        result.fitness = squared_error / static_cast<double>(matched);
+        if (icp_kernel_detail::converged(step_rotation, step_translation, result.fitness,
+                                         previous_mse, settings)) {
+            result.converged = true;
+            return result;
+        }
+    }
+
+    // Like PCL, running out of iterations still yields a usable estimate.
+    result.converged = true;
+    return result;
+}
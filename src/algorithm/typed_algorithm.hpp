@@ -0,0 +1,139 @@
+#pragma once
+#include "algorithm_base.hpp"
+#include "algorithm/normals.hpp"
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Point layouts a specialized algorithm can be instantiated for, and how a
+// fragment's cloud is obtained in that layout. Fragments are stored as
+// pcl::PointXYZ; other layouts are derived once per fragment through the
+// sample's cache, never per pair.
+template <typename PointT>
+struct PointLayout;
+
+template <>
+struct PointLayout<pcl::PointXYZ> {
+    static constexpr std::string_view name{"xyz"};
+    static constexpr bool has_normal = false;
+
+    // The fragment's own cloud; no copy.
+    static std::shared_ptr<const BasicPointCloud<pcl::PointXYZ>>
+    of(const Fragment &fragment, const NormalEstimationParams &) {
+        return fragment.shared();
+    }
+};
+
+template <>
+struct PointLayout<pcl::PointNormal> {
+    static constexpr std::string_view name{"normal"};
+    static constexpr bool has_normal = true;
+
+    static std::shared_ptr<const BasicPointCloud<pcl::PointNormal>>
+    of(const Fragment &fragment, const NormalEstimationParams &normals) {
+        return fragment_point_normals(fragment, normals);
+    }
+};
+
+template <typename Scalar>
+constexpr std::string_view scalar_name() {
+    return std::is_same_v<Scalar, double> ? "double" : "float";
+}
+
+// A fragment together with its cloud in the layout an algorithm works on.
+template <typename PointT>
+struct TypedFragment {
+    const Fragment &fragment;
+    std::shared_ptr<const BasicPointCloud<PointT>> cloud;
+};
+
+// Base of algorithms specialized at compile time on point layout and scalar.
+// `Derived` provides
+//
+//   BasicTransMat<Scalar> align(const TypedFragment<PointT> &source,
+//                               const TypedFragment<PointT> &target,
+//                               const BasicTransMat<Scalar> &initial_guess);
+//
+// which is called without virtual dispatch on clouds already in `PointT`, so
+// its kernels are instantiated for the exact layout they process. The only
+// virtual call per pair is the runner's register_fragments().
+template <typename Derived, typename PointT, typename Scalar>
+class TypedAlgorithm : public AlgorithmBase {
+public:
+    using Point = PointT;
+    using Cloud = BasicPointCloud<PointT>;
+    using Transform = BasicTransMat<Scalar>;
+
+    explicit TypedAlgorithm(const nlohmann::json &config)
+        : _normals(NormalEstimationParams::from_json(config)) {}
+
+    TransMat register_point_cloud(const PointCloud &source, const PointCloud &target,
+                                  const TransMat &initial_guess = TransMat::Identity()) override {
+        return register_fragments(Fragment{source}, Fragment{target}, initial_guess);
+    }
+
+    TransMat register_fragments(const Fragment &source, const Fragment &target,
+                                const TransMat &initial_guess = TransMat::Identity()) override {
+        if (source.cloud.empty() || target.cloud.empty()) {
+            throw std::runtime_error(name() + " requires non-empty point clouds");
+        }
+        const TypedFragment<PointT> typed_source{source, PointLayout<PointT>::of(source, _normals)};
+        const TypedFragment<PointT> typed_target{target, PointLayout<PointT>::of(target, _normals)};
+        const Transform result = static_cast<Derived &>(*this).align(
+            typed_source, typed_target, initial_guess.template cast<Scalar>());
+        return result.template cast<float>();
+    }
+
+    // "<layout>,<scalar>", e.g. "normal,double", for logs.
+    static std::string specialization() {
+        return std::format("{},{}", PointLayout<PointT>::name, scalar_name<Scalar>());
+    }
+
+protected:
+    const NormalEstimationParams &normals() const { return _normals; }
+
+private:
+    NormalEstimationParams _normals;
+};
+
+// Creates `Engine<PointT, Scalar>` for the config's "point_type" ("xyz" by
+// default, or "normal") and "scalar" ("double" by default, or "float"),
+// the precision of accumulation and of the composed transform. Every
+// combination is instantiated where the engine is registered, so the choice
+// costs one branch at construction and nothing per pair.
+template <template <typename, typename> class Engine>
+std::shared_ptr<AlgorithmBase> create_typed_algorithm(const nlohmann::json &config) {
+    const auto point_type = config.value("point_type", std::string{"xyz"});
+    const auto scalar = config.value("scalar", std::string{"double"});
+    const auto with_point = [&]<typename PointT>() -> std::shared_ptr<AlgorithmBase> {
+        if (scalar == "float") {
+            return std::make_shared<Engine<PointT, float>>(config);
+        }
+        if (scalar == "double") {
+            return std::make_shared<Engine<PointT, double>>(config);
+        }
+        throw std::invalid_argument("'scalar' must be either \"float\" or \"double\"");
+    };
+    if (point_type == "xyz") {
+        return with_point.template operator()<pcl::PointXYZ>();
+    }
+    if (point_type == "normal") {
+        return with_point.template operator()<pcl::PointNormal>();
+    }
+    throw std::invalid_argument("'point_type' must be either \"xyz\" or \"normal\"");
+}
+
+template <template <typename, typename> class Engine>
+struct TypedAlgorithmRegistrar {
+    TypedAlgorithmRegistrar(const std::string &name) {
+        algorithmManager.register_algorithm(name, &create_typed_algorithm<Engine>);
+    }
+};
+
+// Registers `engine`, a class template over (point type, scalar), under
+// `name`; the specialization is picked from the algorithm's config.
+#define REGISTER_TYPED_ALGORITHM(name, engine) \
+  static TypedAlgorithmRegistrar<engine> reg_##name(#name)
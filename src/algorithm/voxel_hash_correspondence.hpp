@@ -0,0 +1,167 @@
+#pragma once
+#include "algorithm/voxel_hash_index.hpp"
+#include "fragment_cache.hpp"
+#include <format>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <pcl/registration/icp.h>
+#include <pcl/search/kdtree.h>
+#include <stdexcept>
+#include <string>
+
+// Correspondence search for PCL registration that answers nearest-neighbour
+// queries from a prebuilt VoxelHashIndex of the target instead of a KD-tree.
+// `Index` may be any structure with the same nearest() member whose indices
+// refer to the registration target, such as IncrementalVoxelMap. Reciprocal
+// correspondences are not supported.
+template <typename PointSource, typename PointTarget, typename Scalar = float,
+          typename Index = VoxelHashIndex>
+class VoxelHashCorrespondenceEstimation
+    : public pcl::registration::CorrespondenceEstimationBase<PointSource, PointTarget, Scalar> {
+public:
+    using Base = pcl::registration::CorrespondenceEstimationBase<PointSource, PointTarget, Scalar>;
+
+    explicit VoxelHashCorrespondenceEstimation(std::shared_ptr<const Index> index)
+        : _index(std::move(index)) {
+        this->corr_name_ = "VoxelHashCorrespondenceEstimation";
+    }
+
+    void determineCorrespondences(pcl::Correspondences &correspondences,
+                                  double max_distance) override {
+        if (!pcl::PCLBase<PointSource>::initCompute()) {
+            return;
+        }
+
+        const auto &source = *this->input_;
+        const auto &indices = *this->indices_;
+        const float max_range = static_cast<float>(
+            std::min<double>(max_distance, std::numeric_limits<float>::max()));
+
+        correspondences.resize(indices.size());
+        std::size_t found = 0;
+        for (const auto source_idx : indices) {
+            const auto &point = source[source_idx];
+            std::uint32_t match = 0;
+            float squared_distance = 0.0f;
+            if (_index->nearest(Eigen::Vector3f(point.x, point.y, point.z), max_range, match,
+                                squared_distance)) {
+                correspondences[found++] = pcl::Correspondence(
+                    static_cast<int>(source_idx), static_cast<int>(match), squared_distance);
+            }
+        }
+        correspondences.resize(found);
+
+        pcl::PCLBase<PointSource>::deinitCompute();
+    }
+
+    void determineReciprocalCorrespondences(pcl::Correspondences &,
+                                            double) override {
+        throw std::logic_error(
+            "VoxelHashCorrespondenceEstimation does not support reciprocal correspondences");
+    }
+
+    typename Base::Ptr clone() const override {
+        return std::make_shared<VoxelHashCorrespondenceEstimation>(*this);
+    }
+
+private:
+    std::shared_ptr<const Index> _index;
+};
+
+// Mean squared distance of the points of `cloud` to their neighbour in
+// `index`, ignoring points without one within `max_distance`; the voxel
+// counterpart of pcl::Registration::getFitnessScore.
+template <typename PointT>
+double voxel_fitness_score(const VoxelHashIndex &index, const pcl::PointCloud<PointT> &cloud,
+                           float max_distance) {
+    double total = 0.0;
+    std::size_t matched = 0;
+    for (const auto &point : cloud) {
+        std::uint32_t match = 0;
+        float squared_distance = 0.0f;
+        if (index.nearest(Eigen::Vector3f(point.x, point.y, point.z), max_distance, match,
+                          squared_distance)) {
+            total += squared_distance;
+            ++matched;
+        }
+    }
+    return matched > 0 ? total / static_cast<double>(matched)
+                       : std::numeric_limits<double>::max();
+}
+
+// Correspondence backend selected by an algorithm's "correspondence" setting:
+// "kdtree" (PCL default) or "voxel_hash" with "voxel_size".
+struct CorrespondenceBackend {
+    enum class Kind { KdTree, VoxelHash };
+
+    Kind kind{Kind::KdTree};
+    float voxel_size{0.1f};
+
+    static CorrespondenceBackend from_json(const nlohmann::json &config,
+                                           double max_correspondence_distance) {
+        CorrespondenceBackend backend;
+        const auto kind = config.value("correspondence", std::string{"kdtree"});
+        if (kind == "voxel_hash") {
+            backend.kind = Kind::VoxelHash;
+        } else if (kind != "kdtree") {
+            throw std::invalid_argument(
+                "'correspondence' must be either \"kdtree\" or \"voxel_hash\"");
+        }
+        backend.voxel_size = config.value(
+            "voxel_size", max_correspondence_distance > 0.0
+                              ? static_cast<float>(max_correspondence_distance)
+                              : backend.voxel_size);
+        if (!(backend.voxel_size > 0.0f)) {
+            throw std::invalid_argument("'voxel_size' must be positive");
+        }
+        return backend;
+    }
+
+    bool uses_voxel_hash() const { return kind == Kind::VoxelHash; }
+
+    // Fragment cache key of the index built over the cloud named `cloud_key`.
+    std::string index_key(const std::string &cloud_key) const {
+        return index_key(cloud_key, voxel_size);
+    }
+
+    // The same key for any voxel size, so that other users of a fragment's
+    // voxel index (overlap filter, inlier metric) share the backend's entry.
+    static std::string index_key(const std::string &cloud_key, float voxel_size) {
+        return std::format("voxel_hash/{}/v={}", cloud_key, voxel_size);
+    }
+
+    // Voxel index of `cloud`, the target representation of `fragment`
+    // identified by `cloud_key`, built once through the fragment cache.
+    template <typename PointT>
+    std::shared_ptr<const VoxelHashIndex>
+    index_for(const Fragment &fragment, const std::string &cloud_key,
+              const pcl::PointCloud<PointT> &cloud) const {
+        return cached_index(fragment, index_key(cloud_key), cloud);
+    }
+
+    // index_for() with a key from index_key(), for callers that keep it to
+    // avoid formatting one per pair.
+    template <typename PointT>
+    std::shared_ptr<const VoxelHashIndex>
+    cached_index(const Fragment &fragment, const std::string &key,
+                 const pcl::PointCloud<PointT> &cloud) const {
+        return fragment.derived<VoxelHashIndex>(key, [this, &cloud]() {
+            return std::make_shared<VoxelHashIndex>(cloud, voxel_size);
+        });
+    }
+
+    // Routes the correspondence search of `registration` through `index`. The
+    // target KD-tree is replaced by an empty one that PCL is told not to
+    // build, so registration never pays for it.
+    template <typename PointSource, typename PointTarget, typename Scalar,
+              typename Index = VoxelHashIndex>
+    static void attach(pcl::Registration<PointSource, PointTarget, Scalar> &registration,
+                       std::shared_ptr<const Index> index) {
+        registration.setCorrespondenceEstimation(
+            std::make_shared<
+                VoxelHashCorrespondenceEstimation<PointSource, PointTarget, Scalar, Index>>(
+                std::move(index)));
+        registration.setSearchMethodTarget(
+            std::make_shared<pcl::search::KdTree<PointTarget>>(), true);
+    }
+};
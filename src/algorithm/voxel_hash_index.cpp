@@ -0,0 +1,110 @@
+#include "algorithm/voxel_hash_index.hpp"
+#include "algorithm/voxel_key.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+void VoxelHashIndex::build(const std::vector<Eigen::Vector3f> &points,
+                           const std::vector<std::uint32_t> &indices, float voxel_size) {
+    if (!(voxel_size > 0.0f)) {
+        throw std::invalid_argument("VoxelHashIndex: voxel size must be positive");
+    }
+    _voxel_size = voxel_size;
+    _inverse_voxel_size = 1.0f / voxel_size;
+
+    // Load factor of at most one half keeps probe sequences short.
+    const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(16, points.size() * 2));
+    _mask = capacity - 1;
+    _slots.assign(capacity, Slot{});
+    _voxel_count = 0;
+
+    // Pass 1: count points per voxel.
+    std::vector<std::uint64_t> keys(points.size());
+    for (std::size_t idx = 0; idx < points.size(); ++idx) {
+        keys[idx] = pack(voxel_of(points[idx]));
+        auto &slot = _slots[probe(keys[idx])];
+        if (slot.key == EMPTY) {
+            slot.key = keys[idx];
+            ++_voxel_count;
+        }
+        ++slot.count;
+    }
+
+    // Pass 2: turn counts into offsets, reusing `count` as the fill cursor.
+    std::uint32_t offset = 0;
+    for (auto &slot : _slots) {
+        if (slot.key != EMPTY) {
+            slot.begin = offset;
+            offset += slot.count;
+            slot.count = 0;
+        }
+    }
+
+    // Pass 3: scatter the points so that every voxel is contiguous.
+    _entries.resize(points.size());
+    for (std::size_t idx = 0; idx < points.size(); ++idx) {
+        auto &slot = _slots[probe(keys[idx])];
+        _entries[slot.begin + slot.count++] =
+            Entry{points[idx].x(), points[idx].y(), points[idx].z(), indices[idx]};
+    }
+}
+
+Eigen::Vector3i VoxelHashIndex::voxel_of(const Eigen::Vector3f &point) const {
+    return voxel_coordinates(point, _inverse_voxel_size);
+}
+
+std::uint64_t VoxelHashIndex::pack(const Eigen::Vector3i &voxel) {
+    return pack_voxel_key(voxel);
+}
+
+std::size_t VoxelHashIndex::probe(std::uint64_t key) const {
+    std::size_t position = static_cast<std::size_t>(hash_voxel_key(key)) & _mask;
+    while (_slots[position].key != EMPTY && _slots[position].key != key) {
+        position = (position + 1) & _mask;
+    }
+    return position;
+}
+
+const VoxelHashIndex::Slot *VoxelHashIndex::find(std::uint64_t key) const {
+    if (_slots.empty()) {
+        return nullptr;
+    }
+    const auto &slot = _slots[probe(key)];
+    return slot.key == EMPTY ? nullptr : &slot;
+}
+
+bool VoxelHashIndex::nearest(const Eigen::Vector3f &query, float max_distance,
+                             std::uint32_t &index, float &squared_distance) const {
+    const Eigen::Vector3i center = voxel_of(query);
+    float best = max_distance * max_distance;
+    bool found = false;
+
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const Slot *slot = find(pack(center + Eigen::Vector3i(dx, dy, dz)));
+                if (slot == nullptr) {
+                    continue;
+                }
+                const Entry *entry = _entries.data() + slot->begin;
+                const Entry *end = entry + slot->count;
+                for (; entry != end; ++entry) {
+                    const float ex = entry->x - query.x();
+                    const float ey = entry->y - query.y();
+                    const float ez = entry->z - query.z();
+                    const float distance = ex * ex + ey * ey + ez * ez;
+                    if (distance <= best) {
+                        best = distance;
+                        index = entry->index;
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+
+    if (found) {
+        squared_distance = best;
+    }
+    return found;
+}
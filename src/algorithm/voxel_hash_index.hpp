@@ -0,0 +1,78 @@
+#pragma once
+#include <Eigen/Core>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <pcl/point_cloud.h>
+#include <vector>
+
+// Approximate nearest-neighbour index over a hashed voxel grid. Points are
+// stored contiguously per voxel and voxels are found through an
+// open-addressing (linear probing) table, so a query touches the 27 voxels
+// around it instead of walking a tree. The result is the exact nearest
+// neighbour whenever it lies within one voxel size of the query; farther
+// neighbours may be missed, which suits correspondence search with a bounded
+// maximum distance.
+class VoxelHashIndex {
+public:
+    struct Entry {
+        float x;
+        float y;
+        float z;
+        // Index of the point in the cloud the index was built from.
+        std::uint32_t index;
+    };
+
+    VoxelHashIndex() = default;
+
+    template <typename PointT>
+    VoxelHashIndex(const pcl::PointCloud<PointT> &cloud, float voxel_size) {
+        std::vector<Eigen::Vector3f> points;
+        std::vector<std::uint32_t> indices;
+        points.reserve(cloud.size());
+        indices.reserve(cloud.size());
+        for (std::size_t idx = 0; idx < cloud.size(); ++idx) {
+            const auto &point = cloud[idx];
+            if (std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z)) {
+                points.emplace_back(point.x, point.y, point.z);
+                indices.emplace_back(static_cast<std::uint32_t>(idx));
+            }
+        }
+        build(points, indices, voxel_size);
+    }
+
+    // Nearest point within `max_distance` of `query`; returns false when none
+    // is found among the neighbouring voxels.
+    bool nearest(const Eigen::Vector3f &query, float max_distance, std::uint32_t &index,
+                 float &squared_distance) const;
+
+    float voxel_size() const { return _voxel_size; }
+    std::size_t size() const { return _entries.size(); }
+    std::size_t voxel_count() const { return _voxel_count; }
+    std::size_t memory_bytes() const {
+        return _entries.capacity() * sizeof(Entry) + _slots.capacity() * sizeof(Slot);
+    }
+
+private:
+    struct Slot {
+        std::uint64_t key{EMPTY};
+        std::uint32_t begin{0};
+        std::uint32_t count{0};
+    };
+
+    static constexpr std::uint64_t EMPTY = std::numeric_limits<std::uint64_t>::max();
+
+    void build(const std::vector<Eigen::Vector3f> &points,
+               const std::vector<std::uint32_t> &indices, float voxel_size);
+    Eigen::Vector3i voxel_of(const Eigen::Vector3f &point) const;
+    static std::uint64_t pack(const Eigen::Vector3i &voxel);
+    std::size_t probe(std::uint64_t key) const;
+    const Slot *find(std::uint64_t key) const;
+
+    float _voxel_size{1.0f};
+    float _inverse_voxel_size{1.0f};
+    std::size_t _mask{0};
+    std::size_t _voxel_count{0};
+    std::vector<Slot> _slots;
+    std::vector<Entry> _entries;
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <Eigen/Core>
+#include <cstdint>
+
+// Integer voxel coordinates folded into one 64-bit key, 21 bits per axis.
+// Coordinates wrap every 2^21 voxels, far beyond any scene at the voxel
+// sizes used for registration. Coordinates are clamped so that the conversion
+// to int stays defined; a non-finite point (a NaN return) gets the clamp value,
+// a voxel it can never match by distance. Indexes drop such points anyway.
+inline Eigen::Vector3i voxel_coordinates(const Eigen::Vector3f &point, float inverse_voxel_size) {
+    constexpr float limit = static_cast<float>(1 << 30);
+    const Eigen::Array3f scaled = (point * inverse_voxel_size).array().floor();
+    if (!scaled.allFinite()) {
+        return Eigen::Vector3i::Constant(1 << 30);
+    }
+    return scaled.max(-limit).min(limit).cast<int>();
+}
+
+inline std::uint64_t pack_voxel_key(const Eigen::Vector3i &voxel) {
+    constexpr int axis_bits = 21;
+    constexpr std::int64_t axis_offset = std::int64_t{1} << (axis_bits - 1);
+    constexpr std::uint64_t axis_mask = (std::uint64_t{1} << axis_bits) - 1;
+    const auto axis = [](int value) {
+        return static_cast<std::uint64_t>(value + axis_offset) & axis_mask;
+    };
+    return axis(voxel.x()) | (axis(voxel.y()) << axis_bits) |
+           (axis(voxel.z()) << (2 * axis_bits));
+}
+
+// Spreads packed keys over the table for open addressing.
+inline std::uint64_t hash_voxel_key(std::uint64_t key) {
+    return (key * 0x9E3779B97F4A7C15ULL) >> 17;
+}
@@ -0,0 +1,80 @@
+#include "allocation_counter.hpp"
+
+#ifdef REGISTRATION_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local std::size_t allocations = 0;
+
+void *counted_allocate(std::size_t size, std::size_t alignment) {
+    ++allocations;
+    if (size == 0) {
+        size = 1;
+    }
+    void *memory = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        memory = std::malloc(size);
+    } else {
+        // aligned_alloc requires the size to be a multiple of the alignment.
+        memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+    return memory;
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *memory = counted_allocate(size, alignof(std::max_align_t))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *memory = counted_allocate(size, static_cast<std::size_t>(alignment))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+std::size_t thread_allocation_count() {
+    return allocations;
+}
+
+bool allocation_counting_enabled() {
+    return true;
+}
+#else
+std::size_t thread_allocation_count() {
+    return 0;
+}
+
+bool allocation_counting_enabled() {
+    return false;
+}
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+// Heap allocations made so far by the calling thread. Counted by replacing the
+// global operator new, which only happens in builds with
+// REGISTRATION_COUNT_ALLOCATIONS (xmake f --alloc_counter=y); otherwise the
+// count stays 0 and allocation_counting_enabled() is false.
+std::size_t thread_allocation_count();
+bool allocation_counting_enabled();
@@ -0,0 +1,307 @@
+#include "baseline.hpp"
+#include "logger.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+constexpr std::string_view ROLE_BASELINE{"baseline"};
+constexpr int SUMMARY_VERSION = 1;
+
+std::string_view status_to_string(BaselineDiff::Status status) {
+    switch (status) {
+    case BaselineDiff::Status::Ok:
+        return "ok";
+    case BaselineDiff::Status::Improved:
+        return "improved";
+    case BaselineDiff::Status::Regressed:
+        return "regressed";
+    case BaselineDiff::Status::Missing:
+        return "missing";
+    default:
+        return "unknown";
+    }
+}
+
+// Classifies `current` against `baseline` where larger values are worse
+// unless `higher_is_better` is set.
+BaselineDiff::Status classify(double baseline, double current, double allowed,
+                              bool higher_is_better) {
+    const double delta = higher_is_better ? baseline - current : current - baseline;
+    if (delta > allowed) {
+        return BaselineDiff::Status::Regressed;
+    }
+    if (delta < -allowed) {
+        return BaselineDiff::Status::Improved;
+    }
+    return BaselineDiff::Status::Ok;
+}
+} // namespace
+
+nlohmann::json RunSummary::to_json() const {
+    nlohmann::json json;
+    json["version"] = SUMMARY_VERSION;
+    json["algorithms"] = nlohmann::json::object();
+    for (const auto &[name, summary] : algorithms) {
+        nlohmann::json entry;
+        entry["samples"] = summary.samples;
+        entry["failed_samples"] = summary.failed_samples;
+        entry["pairs"] = summary.pairs;
+        entry["wall_seconds"] = summary.wall_seconds;
+        entry["samples_per_second"] = summary.samples_per_second;
+        entry["pairs_per_second"] = summary.pairs_per_second;
+        entry["iterations_per_pair"] = summary.iterations_per_pair;
+        entry["latency_seconds"] = summary.latency_seconds;
+        entry["metrics"] = nlohmann::json::object();
+        for (const auto &[metric_name, metric] : summary.metrics) {
+            entry["metrics"][metric_name] = {
+                {"mean", metric.mean}, {"higher_is_better", metric.higher_is_better}};
+        }
+        json["algorithms"][name] = std::move(entry);
+    }
+    return json;
+}
+
+RunSummary RunSummary::from_json(const nlohmann::json &json) {
+    if (json.value("version", 0) != SUMMARY_VERSION) {
+        throw std::runtime_error("Unsupported run summary version");
+    }
+    if (!json.contains("algorithms") || !json["algorithms"].is_object()) {
+        throw std::runtime_error("Run summary must contain an 'algorithms' object");
+    }
+
+    RunSummary summary;
+    for (const auto &[name, entry] : json["algorithms"].items()) {
+        AlgorithmSummary algorithm;
+        algorithm.samples = entry.value("samples", std::size_t{0});
+        algorithm.failed_samples = entry.value("failed_samples", std::size_t{0});
+        algorithm.pairs = entry.value("pairs", std::size_t{0});
+        algorithm.wall_seconds = entry.value("wall_seconds", 0.0);
+        algorithm.samples_per_second = entry.value("samples_per_second", 0.0);
+        algorithm.pairs_per_second = entry.value("pairs_per_second", 0.0);
+        algorithm.iterations_per_pair = entry.value("iterations_per_pair", 0.0);
+        if (entry.contains("latency_seconds")) {
+            algorithm.latency_seconds =
+                entry["latency_seconds"].get<std::map<std::string, double>>();
+        }
+        if (entry.contains("metrics")) {
+            for (const auto &[metric_name, metric] : entry["metrics"].items()) {
+                algorithm.metrics[metric_name] = {metric.value("mean", 0.0),
+                                                  metric.value("higher_is_better", false)};
+            }
+        }
+        summary.algorithms.emplace(name, std::move(algorithm));
+    }
+    return summary;
+}
+
+BaselineTolerances BaselineTolerances::from_json(const nlohmann::json &config) {
+    BaselineTolerances tolerances;
+    tolerances.accuracy = config.value("accuracy_tolerance", tolerances.accuracy);
+    tolerances.accuracy_absolute =
+        config.value("accuracy_absolute_tolerance", tolerances.accuracy_absolute);
+    tolerances.latency = config.value("latency_tolerance", tolerances.latency);
+    tolerances.throughput = config.value("throughput_tolerance", tolerances.throughput);
+    tolerances.iterations = config.value("iterations_tolerance", tolerances.iterations);
+    return tolerances;
+}
+
+nlohmann::json BaselineReport::to_json() const {
+    nlohmann::json json;
+    json["regressed"] = regressed;
+    json["diffs"] = nlohmann::json::array();
+    for (const auto &diff : diffs) {
+        json["diffs"].push_back({{"algorithm", diff.algorithm},
+                                 {"quantity", diff.quantity},
+                                 {"baseline", diff.baseline},
+                                 {"current", diff.current},
+                                 {"status", status_to_string(diff.status)}});
+    }
+    return json;
+}
+
+RunSummary summarize_run(const AlgorithmResults &results,
+                         const AlgorithmTimings &timings,
+                         const std::vector<std::shared_ptr<MetricBase>> &metrics) {
+    RunSummary summary;
+    for (const auto &[algorithm_name, sample_scores] : results) {
+        AlgorithmSummary algorithm;
+        algorithm.samples = sample_scores.size();
+
+        std::vector<double> sums(metrics.size(), 0.0);
+        std::size_t scored = 0;
+        for (const auto &scores : sample_scores) {
+            if (scores.size() != metrics.size()) {
+                ++algorithm.failed_samples;
+                continue;
+            }
+            for (std::size_t idx = 0; idx < scores.size(); ++idx) {
+                sums[idx] += scores[idx];
+            }
+            ++scored;
+        }
+        for (std::size_t idx = 0; idx < metrics.size(); ++idx) {
+            algorithm.metrics[metrics[idx]->name()] = {
+                scored > 0 ? sums[idx] / static_cast<double>(scored) : 0.0,
+                metrics[idx]->higher_is_better()};
+        }
+
+        const auto timing_it = timings.find(algorithm_name);
+        if (timing_it != timings.end()) {
+            const auto &timing = timing_it->second;
+            std::vector<double> latencies;
+            std::size_t iterations = 0;
+            for (std::size_t idx = 0; idx < timing.sample_seconds.size(); ++idx) {
+                if (!std::isnan(timing.sample_seconds[idx])) {
+                    latencies.emplace_back(timing.sample_seconds[idx]);
+                    algorithm.pairs += timing.sample_pairs[idx];
+                    if (idx < timing.sample_iterations.size()) {
+                        iterations += timing.sample_iterations[idx];
+                    }
+                }
+            }
+            if (algorithm.pairs > 0) {
+                algorithm.iterations_per_pair =
+                    static_cast<double>(iterations) / static_cast<double>(algorithm.pairs);
+            }
+            algorithm.wall_seconds = timing.wall_seconds;
+            if (timing.wall_seconds > 0.0) {
+                algorithm.samples_per_second =
+                    static_cast<double>(latencies.size()) / timing.wall_seconds;
+                algorithm.pairs_per_second =
+                    static_cast<double>(algorithm.pairs) / timing.wall_seconds;
+            }
+            algorithm.latency_seconds["p50"] = percentile(latencies, 0.50);
+            algorithm.latency_seconds["p90"] = percentile(latencies, 0.90);
+            algorithm.latency_seconds["p99"] = percentile(latencies, 0.99);
+        }
+
+        summary.algorithms.emplace(algorithm_name, std::move(algorithm));
+    }
+    return summary;
+}
+
+void save_run_summary(const RunSummary &summary, const std::string &path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Failed to open run summary for writing: " + path);
+    }
+    out << summary.to_json().dump(2) << '\n';
+    LOG_INFO(ROLE_BASELINE, "Run summary written to {}", path);
+}
+
+RunSummary load_run_summary(const std::string &path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open run summary: " + path);
+    }
+    nlohmann::json json;
+    in >> json;
+    return RunSummary::from_json(json);
+}
+
+BaselineReport compare_to_baseline(const RunSummary &current,
+                                   const RunSummary &baseline,
+                                   const BaselineTolerances &tolerances) {
+    BaselineReport report;
+    const auto add = [&report](const std::string &algorithm, const std::string &quantity,
+                               double base, double now, BaselineDiff::Status status) {
+        if (status == BaselineDiff::Status::Regressed ||
+            status == BaselineDiff::Status::Missing) {
+            report.regressed = true;
+        }
+        report.diffs.push_back({algorithm, quantity, base, now, status});
+    };
+
+    for (const auto &[name, base] : baseline.algorithms) {
+        const auto it = current.algorithms.find(name);
+        if (it == current.algorithms.end()) {
+            add(name, "algorithm", 0.0, 0.0, BaselineDiff::Status::Missing);
+            continue;
+        }
+        const auto &now = it->second;
+
+        add(name, "failed_samples", static_cast<double>(base.failed_samples),
+            static_cast<double>(now.failed_samples),
+            classify(static_cast<double>(base.failed_samples),
+                     static_cast<double>(now.failed_samples), 0.0, false));
+
+        for (const auto &[metric_name, base_metric] : base.metrics) {
+            const auto metric_it = now.metrics.find(metric_name);
+            if (metric_it == now.metrics.end()) {
+                add(name, "metric:" + metric_name, base_metric.mean, 0.0,
+                    BaselineDiff::Status::Missing);
+                continue;
+            }
+            const double allowed = std::max(tolerances.accuracy_absolute,
+                                            tolerances.accuracy * std::abs(base_metric.mean));
+            add(name, "metric:" + metric_name, base_metric.mean, metric_it->second.mean,
+                classify(base_metric.mean, metric_it->second.mean, allowed,
+                         base_metric.higher_is_better));
+        }
+
+        add(name, "pairs_per_second", base.pairs_per_second, now.pairs_per_second,
+            classify(base.pairs_per_second, now.pairs_per_second,
+                     tolerances.throughput * base.pairs_per_second, true));
+
+        // Only comparable when both runs counted iterations; fewer is better
+        // and shows what e.g. a motion prior saves.
+        if (base.iterations_per_pair > 0.0 && now.iterations_per_pair > 0.0) {
+            add(name, "iterations_per_pair", base.iterations_per_pair, now.iterations_per_pair,
+                classify(base.iterations_per_pair, now.iterations_per_pair,
+                         tolerances.iterations * base.iterations_per_pair, false));
+        }
+
+        for (const auto &[percentile_name, base_latency] : base.latency_seconds) {
+            const auto latency_it = now.latency_seconds.find(percentile_name);
+            if (latency_it == now.latency_seconds.end()) {
+                continue;
+            }
+            add(name, "latency_" + percentile_name, base_latency, latency_it->second,
+                classify(base_latency, latency_it->second,
+                         tolerances.latency * base_latency, false));
+        }
+    }
+
+    for (const auto &[name, summary] : current.algorithms) {
+        if (!baseline.algorithms.contains(name)) {
+            LOG_WARN(ROLE_BASELINE, "Algorithm '{}' has no baseline entry", name);
+        }
+    }
+
+    return report;
+}
+
+void write_baseline_report(const BaselineReport &report, const std::string &path) {
+    for (const auto &diff : report.diffs) {
+        const auto level = diff.status == BaselineDiff::Status::Regressed ||
+                                   diff.status == BaselineDiff::Status::Missing
+                               ? LogLevel::Error
+                               : LogLevel::Info;
+        const double change =
+            diff.baseline != 0.0 ? (diff.current - diff.baseline) / std::abs(diff.baseline) * 100.0
+                                 : 0.0;
+        LOG_LOGGER_CALL(level, ROLE_BASELINE, "{:<24} {:<28} baseline={:<12.6g} current={:<12.6g} ({:+.1f}%) {}",
+                        diff.algorithm, diff.quantity, diff.baseline, diff.current, change,
+                        status_to_string(diff.status));
+    }
+
+    if (!path.empty()) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            LOG_ERROR(ROLE_BASELINE, "Failed to open baseline report {}", path);
+        } else {
+            out << report.to_json().dump(2) << '\n';
+            LOG_INFO(ROLE_BASELINE, "Baseline report written to {}", path);
+        }
+    }
+
+    if (report.regressed) {
+        LOG_ERROR(ROLE_BASELINE, "Regression detected against the baseline");
+    } else {
+        LOG_INFO(ROLE_BASELINE, "No regression against the baseline");
+    }
+}
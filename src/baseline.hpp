@@ -0,0 +1,80 @@
+#pragma once
+
+#include "metric/metric_base.hpp"
+#include "process.h"
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+struct MetricSummary {
+    double mean{0.0};
+    bool higher_is_better{false};
+};
+
+struct AlgorithmSummary {
+    std::size_t samples{0};
+    std::size_t failed_samples{0};
+    std::size_t pairs{0};
+    double wall_seconds{0.0};
+    double samples_per_second{0.0};
+    double pairs_per_second{0.0};
+    // Registration iterations per pair; 0 when the algorithm reports none.
+    double iterations_per_pair{0.0};
+    // Per-sample latency percentiles in seconds, keyed by "p50", "p90", "p99".
+    std::map<std::string, double> latency_seconds;
+    std::map<std::string, MetricSummary> metrics;
+};
+
+struct RunSummary {
+    std::map<std::string, AlgorithmSummary> algorithms;
+
+    nlohmann::json to_json() const;
+    static RunSummary from_json(const nlohmann::json &json);
+};
+
+struct BaselineTolerances {
+    // Relative slack on metric means, with an absolute floor for values near zero.
+    double accuracy{0.05};
+    double accuracy_absolute{1e-6};
+    double latency{0.2};
+    double throughput{0.2};
+    // Relative slack on iterations per pair. Iteration counts do not depend
+    // on machine load, so they get a tighter bound than timings.
+    double iterations{0.1};
+
+    static BaselineTolerances from_json(const nlohmann::json &config);
+};
+
+struct BaselineDiff {
+    enum class Status { Ok, Improved, Regressed, Missing };
+
+    std::string algorithm;
+    std::string quantity;
+    double baseline{0.0};
+    double current{0.0};
+    Status status{Status::Ok};
+};
+
+struct BaselineReport {
+    std::vector<BaselineDiff> diffs;
+    bool regressed{false};
+
+    nlohmann::json to_json() const;
+};
+
+RunSummary summarize_run(const AlgorithmResults &results,
+                         const AlgorithmTimings &timings,
+                         const std::vector<std::shared_ptr<MetricBase>> &metrics);
+
+void save_run_summary(const RunSummary &summary, const std::string &path);
+RunSummary load_run_summary(const std::string &path);
+
+BaselineReport compare_to_baseline(const RunSummary &current,
+                                   const RunSummary &baseline,
+                                   const BaselineTolerances &tolerances);
+
+// Logs every compared quantity and, when `path` is non-empty, writes the
+// report as JSON.
+void write_baseline_report(const BaselineReport &report, const std::string &path);
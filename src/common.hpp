@@ -3,5 +3,13 @@
 #include <pcl/point_cloud.h>
 #include <Eigen/src/Core/Matrix.h>
 
-using PointCloud = pcl::PointCloud<pcl::PointXYZ>;
-using TransMat = Eigen::Matrix4f;
\ No newline at end of file
+// Cloud and transform of a given point layout and scalar, for code that is
+// specialized at compile time (see algorithm/typed_algorithm.hpp). Samples
+// and loaders store pcl::PointXYZ with float transforms.
+template <typename PointT>
+using BasicPointCloud = pcl::PointCloud<PointT>;
+template <typename Scalar>
+using BasicTransMat = Eigen::Matrix<Scalar, 4, 4>;
+
+using PointCloud = BasicPointCloud<pcl::PointXYZ>;
+using TransMat = BasicTransMat<float>;
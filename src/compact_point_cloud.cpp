@@ -0,0 +1,123 @@
+#include "compact_point_cloud.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr int PACKED_BITS = 10;
+
+std::uint32_t quantize(float value, float origin, float inverse_step, std::uint32_t max_level) {
+  const float level = std::round((value - origin) * inverse_step);
+  return static_cast<std::uint32_t>(std::clamp(level, 0.0f, static_cast<float>(max_level)));
+}
+} // namespace
+
+CompactPointCloud::CompactPointCloud(const PointCloud &cloud, int bits) : _bits(bits) {
+  if (bits < 1 || bits > 16) {
+    throw std::invalid_argument("CompactPointCloud: bits must be between 1 and 16");
+  }
+
+  Eigen::Vector3f min = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f max = Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+  std::vector<Eigen::Vector3f> points;
+  points.reserve(cloud.size());
+  for (const auto &point : cloud) {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      continue;
+    }
+    points.emplace_back(point.x, point.y, point.z);
+    min = min.cwiseMin(points.back());
+    max = max.cwiseMax(points.back());
+  }
+  _size = points.size();
+  if (_size == 0) {
+    return;
+  }
+
+  const auto max_level = (std::uint32_t{1} << bits) - 1;
+  _origin = min;
+  _step = (max - min) / static_cast<float>(max_level);
+  Eigen::Vector3f inverse_step;
+  for (int axis = 0; axis < 3; ++axis) {
+    // A flat axis quantizes to level 0 everywhere.
+    inverse_step[axis] = _step[axis] > 0.0f ? 1.0f / _step[axis] : 0.0f;
+  }
+
+  if (bits <= PACKED_BITS) {
+    _packed.resize(_size);
+    for (std::size_t idx = 0; idx < _size; ++idx) {
+      const auto &point = points[idx];
+      _packed[idx] = quantize(point.x(), _origin.x(), inverse_step.x(), max_level) |
+                     quantize(point.y(), _origin.y(), inverse_step.y(), max_level) << PACKED_BITS |
+                     quantize(point.z(), _origin.z(), inverse_step.z(), max_level) << (2 * PACKED_BITS);
+    }
+    return;
+  }
+
+  _x.resize(_size);
+  _y.resize(_size);
+  _z.resize(_size);
+  for (std::size_t idx = 0; idx < _size; ++idx) {
+    const auto &point = points[idx];
+    _x[idx] = static_cast<std::uint16_t>(quantize(point.x(), _origin.x(), inverse_step.x(), max_level));
+    _y[idx] = static_cast<std::uint16_t>(quantize(point.y(), _origin.y(), inverse_step.y(), max_level));
+    _z[idx] = static_cast<std::uint16_t>(quantize(point.z(), _origin.z(), inverse_step.z(), max_level));
+  }
+}
+
+std::size_t CompactPointCloud::memory_bytes() const {
+  return _packed.capacity() * sizeof(std::uint32_t) +
+         (_x.capacity() + _y.capacity() + _z.capacity()) * sizeof(std::uint16_t);
+}
+
+void CompactPointCloud::decode_block(std::size_t block, Block &out) const {
+  const std::size_t begin = block * BLOCK_SIZE;
+  if (begin >= _size) {
+    out.size = 0;
+    return;
+  }
+  out.size = std::min(BLOCK_SIZE, _size - begin);
+
+  const float ox = _origin.x(), oy = _origin.y(), oz = _origin.z();
+  const float sx = _step.x(), sy = _step.y(), sz = _step.z();
+  if (!_packed.empty()) {
+    constexpr std::uint32_t mask = (std::uint32_t{1} << PACKED_BITS) - 1;
+    const std::uint32_t *words = _packed.data() + begin;
+#pragma omp simd
+    for (std::size_t idx = 0; idx < out.size; ++idx) {
+      const std::uint32_t word = words[idx];
+      out.x[idx] = ox + static_cast<float>(word & mask) * sx;
+      out.y[idx] = oy + static_cast<float>((word >> PACKED_BITS) & mask) * sy;
+      out.z[idx] = oz + static_cast<float>(word >> (2 * PACKED_BITS)) * sz;
+    }
+    return;
+  }
+
+  const std::uint16_t *x = _x.data() + begin;
+  const std::uint16_t *y = _y.data() + begin;
+  const std::uint16_t *z = _z.data() + begin;
+#pragma omp simd
+  for (std::size_t idx = 0; idx < out.size; ++idx) {
+    out.x[idx] = ox + static_cast<float>(x[idx]) * sx;
+    out.y[idx] = oy + static_cast<float>(y[idx]) * sy;
+    out.z[idx] = oz + static_cast<float>(z[idx]) * sz;
+  }
+}
+
+PointCloud CompactPointCloud::decode() const {
+  PointCloud cloud;
+  cloud.resize(_size);
+  Block block;
+  for (std::size_t block_idx = 0; block_idx < block_count(); ++block_idx) {
+    decode_block(block_idx, block);
+    auto *points = cloud.points.data() + block_idx * BLOCK_SIZE;
+    for (std::size_t idx = 0; idx < block.size; ++idx) {
+      points[idx] = pcl::PointXYZ(block.x[idx], block.y[idx], block.z[idx]);
+    }
+  }
+  cloud.width = static_cast<std::uint32_t>(_size);
+  cloud.height = 1;
+  cloud.is_dense = true;
+  return cloud;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "common.hpp"
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A fragment kept with its coordinates quantized to `bits` per axis relative to
+// its own bounding box. With up to 10 bits the three coordinates of a point are
+// packed into one 32-bit word (4 bytes per point); with 11 to 16 bits each
+// coordinate is a 16-bit integer (6 bytes per point). A pcl::PointXYZ takes 16.
+// Non-finite points are dropped when encoding.
+class CompactPointCloud {
+public:
+  // Points per decoded block; a multiple of every common SIMD width.
+  static constexpr std::size_t BLOCK_SIZE = 16;
+
+  // Structure-of-arrays batch of decoded points.
+  struct Block {
+    alignas(64) float x[BLOCK_SIZE];
+    alignas(64) float y[BLOCK_SIZE];
+    alignas(64) float z[BLOCK_SIZE];
+    std::size_t size{0};
+  };
+
+  CompactPointCloud() = default;
+  CompactPointCloud(const PointCloud &cloud, int bits);
+
+  std::size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  int bits() const { return _bits; }
+  // Quantization step along each axis.
+  const Eigen::Vector3f &step() const { return _step; }
+  // Largest distance between a point and its decoded position.
+  double max_error() const { return 0.5 * static_cast<double>(_step.norm()); }
+  std::size_t memory_bytes() const;
+
+  std::size_t block_count() const { return (_size + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+  void decode_block(std::size_t block, Block &out) const;
+  PointCloud decode() const;
+
+private:
+  Eigen::Vector3f _origin{Eigen::Vector3f::Zero()};
+  Eigen::Vector3f _step{Eigen::Vector3f::Zero()};
+  int _bits{16};
+  std::size_t _size{0};
+  std::vector<std::uint32_t> _packed;
+  std::vector<std::uint16_t> _x;
+  std::vector<std::uint16_t> _y;
+  std::vector<std::uint16_t> _z;
+};
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <pcl/io/ply_io.h>
 #include <sstream>
@@ -11,6 +12,8 @@
 #include <string_view>
 
 #include "dataset_loader_base.hpp"
+#include "dataset_loader/dataset_manifest.hpp"
+#include "dataset_loader/ply_reader.hpp"
 
 using namespace std::string_literals;
 
@@ -24,6 +27,65 @@ bool register_loader() {
 }
 
 const bool registered = register_loader();
+
+PointCloud read_fragment(const fs::path &path, bool fast_ply) {
+  PointCloud cloud;
+  if (fast_ply && read_ply_points(path, cloud)) {
+    return cloud;
+  }
+
+  const auto ret = pcl::io::loadPLYFile(path.string(), cloud);
+  if (ret != 0) {
+    throw std::runtime_error("Failed to load PLY file: " + path.string() +
+                             " (error code " + std::to_string(ret) + ")");
+  }
+  return cloud;
+}
+
+// What a reader checks fragment i of a sample against; 0 when unknown.
+struct FragmentExpectation {
+  std::size_t points{0};
+  std::uint64_t checksum{0};
+};
+
+// Reads fragment i of a sample from `paths[i]`, when first needed or again
+// after it was released. A fragment that differs from what the manifest
+// recorded is rejected, since its recorded size already went into scheduling
+// and memory estimates.
+std::function<PointCloud(std::size_t)>
+fragment_reader(std::vector<fs::path> paths,
+                std::vector<FragmentExpectation> expected, bool fast_ply) {
+  return [paths = std::move(paths), expected = std::move(expected),
+          fast_ply](std::size_t index) {
+    const auto &path = paths.at(index);
+    const auto &expect = expected.at(index);
+    if (expect.checksum != 0 && file_checksum(path) != expect.checksum) {
+      throw std::runtime_error("Fragment changed since the manifest was built: " +
+                               path.string());
+    }
+    auto cloud = read_fragment(path, fast_ply);
+    if (expect.points != 0 && cloud.size() != expect.points) {
+      throw std::runtime_error(
+          "Fragment " + path.string() + " has " + std::to_string(cloud.size()) +
+          " points, the manifest recorded " + std::to_string(expect.points));
+    }
+    return cloud;
+  };
+}
+
+// Index N of a cloud_bin_N file; nullopt for any other file.
+std::optional<std::size_t> fragment_number(const fs::path &path) {
+  const auto stem = path.stem().string();
+  constexpr std::string_view prefix = "cloud_bin_";
+  if (!stem.starts_with(prefix)) {
+    return std::nullopt;
+  }
+  try {
+    return static_cast<std::size_t>(std::stoul(stem.substr(prefix.size())));
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+}
 } // namespace
 
 DatasetLoader3DMatch::DatasetLoader3DMatch(const nlohmann::json &config) {
@@ -40,6 +102,28 @@ DatasetLoader3DMatch::DatasetLoader3DMatch(const nlohmann::json &config) {
   _max_sequences = config.value("max_sequences", static_cast<std::size_t>(0));
   _max_point_clouds =
       config.value("max_point_clouds", static_cast<std::size_t>(0));
+  _fast_ply = config.value("fast_ply", true);
+  _protocol = config.value("protocol", _protocol);
+  _gt_log = config.value("gt_log", _gt_log);
+  _max_pairs = config.value("max_pairs", _max_pairs);
+  _verify_manifest = config.value("verify_manifest", _verify_manifest);
+  if (config.contains("manifest")) {
+    const auto &manifest = config["manifest"];
+    if (manifest.is_boolean()) {
+      if (!manifest.get<bool>()) {
+        _manifest.clear();
+      }
+    } else if (manifest.is_string()) {
+      _manifest = fs::path(manifest.get<std::string>());
+    } else {
+      throw std::invalid_argument(
+          "'manifest' must be a path or false when provided");
+    }
+  }
+  if (_protocol != "sequential" && _protocol != "pairs") {
+    throw std::invalid_argument(
+        "'protocol' must be either \"sequential\" or \"pairs\"");
+  }
 
   if (config.contains("sequences")) {
     if (!config["sequences"].is_array()) {
@@ -70,24 +154,26 @@ std::vector<Sample> DatasetLoader3DMatch::load_samples() {
 
   log_info("Loading 3DMatch dataset from {}", split_path.string());
 
+  const auto manifest = load_manifest(split_path);
   std::vector<fs::path> sequence_paths;
   if (!_sequences.empty()) {
     for (const auto &sequence_name : _sequences) {
       const auto sequence_path = split_path / sequence_name;
-      if (fs::exists(sequence_path) && fs::is_directory(sequence_path)) {
+      const bool exists = manifest ? manifest->find(sequence_name) != nullptr
+                                   : fs::is_directory(sequence_path);
+      if (exists) {
         sequence_paths.emplace_back(sequence_path);
       } else {
         log_warn("Sequence directory missing: {}",
                   sequence_path.string());
       }
     }
-  } else {
-    for (const auto &entry : fs::directory_iterator(split_path)) {
-      if (entry.is_directory()) {
-        sequence_paths.emplace_back(entry.path());
-      }
+  } else if (manifest) {
+    for (const auto &sequence : manifest->sequences) {
+      sequence_paths.emplace_back(split_path / sequence.name);
     }
-    std::sort(sequence_paths.begin(), sequence_paths.end());
+  } else {
+    sequence_paths = list_sequences(split_path);
   }
 
   std::size_t sequence_count = 0;
@@ -99,9 +185,26 @@ std::vector<Sample> DatasetLoader3DMatch::load_samples() {
     log_info("Loading sequence {}", sequence_path.filename().string());
 
     try {
-      auto sample = load_sequence(sequence_path);
-      if (!sample.point_clouds.empty()) {
-        cloud_count += sample.point_clouds.size();
+      const auto *indexed =
+          manifest ? manifest->find(sequence_path.filename().string()) : nullptr;
+      const auto fragments = indexed != nullptr
+                                 ? manifest_fragments(split_path, *indexed)
+                                 : scan_fragments(sequence_path);
+      Sample sample;
+      if (_protocol == "pairs") {
+        // The manifest records the pair list found under the default name.
+        const bool known_gt_log = indexed != nullptr &&
+                                  !indexed->gt_log.empty() &&
+                                  fs::path(indexed->gt_log).filename() == _gt_log;
+        sample = load_pair_sequence(sequence_path, fragments,
+                                    known_gt_log ? split_path / indexed->gt_log
+                                                 : find_gt_log(sequence_path));
+      } else {
+        sample = load_sequence(sequence_path, fragments);
+      }
+      if (sample.fragment_count() > 0) {
+        cloud_count += sample.fragment_count();
+        finish_sample(sample);
         samples.emplace_back(std::move(sample));
         ++sequence_count;
       }
@@ -115,90 +218,325 @@ std::vector<Sample> DatasetLoader3DMatch::load_samples() {
   return samples;
 }
 
-Sample DatasetLoader3DMatch::load_sequence(const fs::path &sequence_path) const {
-  const fs::path fragments_dir = sequence_path / "fragments";
-  const fs::path poses_dir = sequence_path / "poses";
+fs::path DatasetLoader3DMatch::build_manifest() {
+  const fs::path split_path = _root / _split;
+  if (!fs::exists(split_path)) {
+    throw std::runtime_error("3DMatch split directory does not exist: " +
+                             split_path.string());
+  }
+  if (_manifest.empty()) {
+    throw std::invalid_argument("'manifest' is disabled for this dataset");
+  }
+
+  DatasetManifest manifest;
+  std::size_t fragment_count = 0;
+  for (const auto &sequence_path : list_sequences(split_path)) {
+    ManifestSequence sequence;
+    sequence.name = sequence_path.filename().string();
+    FragmentIndex fragments;
+    try {
+      fragments = scan_fragments(sequence_path);
+    } catch (const std::exception &e) {
+      log_warn("Leaving sequence '{}' out of the manifest: {}", sequence.name,
+               e.what());
+      continue;
+    }
+    try {
+      sequence.gt_log =
+          fs::relative(find_gt_log(sequence_path), split_path).generic_string();
+    } catch (const std::exception &) {
+      // Sequential protocol only.
+    }
+
+    for (const auto &[index, file] : fragments) {
+      const auto cloud = read_fragment(file.path, _fast_ply);
+      ManifestFragment fragment;
+      fragment.index = index;
+      fragment.path = fs::relative(file.path, split_path).generic_string();
+      fragment.file_size = fs::file_size(file.path);
+      fragment.checksum = file_checksum(file.path);
+      fragment.points = cloud.size();
+      if (!cloud.empty()) {
+        fragment.min.setConstant(std::numeric_limits<float>::max());
+        fragment.max.setConstant(std::numeric_limits<float>::lowest());
+        for (const auto &point : cloud) {
+          fragment.min = fragment.min.cwiseMin(point.getVector3fMap());
+          fragment.max = fragment.max.cwiseMax(point.getVector3fMap());
+        }
+      }
+      if (const auto pose = find_pose(sequence_path, index, file)) {
+        fragment.has_pose = true;
+        fragment.pose = *pose;
+      }
+      sequence.fragments.emplace_back(std::move(fragment));
+    }
+    log_info("Indexed sequence '{}' with {} fragments", sequence.name,
+             sequence.fragments.size());
+    fragment_count += sequence.fragments.size();
+    manifest.sequences.emplace_back(std::move(sequence));
+  }
+
+  const auto path = _manifest.is_absolute() ? _manifest : split_path / _manifest;
+  manifest.save(path);
+  log_info("Wrote manifest of {} sequences and {} fragments to {}",
+           manifest.sequences.size(), fragment_count, path.string());
+  return path;
+}
+
+std::optional<DatasetManifest>
+DatasetLoader3DMatch::load_manifest(const fs::path &split_path) const {
+  if (_manifest.empty()) {
+    return std::nullopt;
+  }
+  const auto path = _manifest.is_absolute() ? _manifest : split_path / _manifest;
+  if (!fs::exists(path)) {
+    if (deferred_loading()) {
+      log_info("No manifest at {}; fragments are read up front",
+               path.string());
+    }
+    return std::nullopt;
+  }
+  try {
+    auto manifest = DatasetManifest::load(path);
+    log_info("Using manifest {} ({} sequences)", path.string(),
+             manifest.sequences.size());
+    return manifest;
+  } catch (const std::exception &e) {
+    log_warn("Ignoring stale manifest, rescanning the split: {}", e.what());
+    return std::nullopt;
+  }
+}
+
+std::vector<fs::path>
+DatasetLoader3DMatch::list_sequences(const fs::path &split_path) const {
+  std::vector<fs::path> sequence_paths;
+  for (const auto &entry : fs::directory_iterator(split_path)) {
+    if (entry.is_directory() &&
+        !entry.path().filename().string().ends_with("-evaluation")) {
+      sequence_paths.emplace_back(entry.path());
+    }
+  }
+  std::sort(sequence_paths.begin(), sequence_paths.end());
+  return sequence_paths;
+}
 
+DatasetLoader3DMatch::FragmentIndex
+DatasetLoader3DMatch::scan_fragments(const fs::path &sequence_path) const {
+  const fs::path fragments_dir = sequence_path / "fragments";
   if (!fs::exists(fragments_dir) || !fs::is_directory(fragments_dir)) {
     throw std::runtime_error("Missing fragments directory: " +
                              fragments_dir.string());
   }
-  if (!fs::exists(poses_dir) || !fs::is_directory(poses_dir)) {
-    throw std::runtime_error("Missing poses directory: " +
-                             poses_dir.string());
-  }
 
-  std::map<std::size_t, fs::path> indexed_clouds;
+  FragmentIndex fragments;
   for (const auto &entry : fs::directory_iterator(fragments_dir)) {
     if (!entry.is_regular_file()) {
       continue;
     }
-
-    const auto stem = entry.path().stem().string();
-    constexpr std::string_view prefix = "cloud_bin_";
-    if (!stem.starts_with(prefix)) {
-      continue;
-    }
-
-    try {
-      const auto index = static_cast<std::size_t>(
-          std::stoul(stem.substr(prefix.size())));
-      indexed_clouds.emplace(index, entry.path());
-    } catch (const std::exception &) {
-      continue;
+    if (const auto index = fragment_number(entry.path())) {
+      fragments[*index].path = entry.path();
     }
   }
 
-  if (indexed_clouds.empty()) {
+  if (fragments.empty()) {
     throw std::runtime_error("No cloud_bin_*.ply files found in " +
                              fragments_dir.string());
   }
+  return fragments;
+}
 
-  Sample sample;
+DatasetLoader3DMatch::FragmentIndex DatasetLoader3DMatch::manifest_fragments(
+    const fs::path &split_path, const ManifestSequence &sequence) const {
+  if (sequence.fragments.empty()) {
+    throw std::runtime_error("Manifest lists no fragments for sequence " +
+                             sequence.name);
+  }
+  FragmentIndex fragments;
+  for (const auto &fragment : sequence.fragments) {
+    auto &file = fragments[fragment.index];
+    file.path = split_path / fragment.path;
+    file.points = fragment.points;
+    file.checksum = _verify_manifest ? fragment.checksum : 0;
+    file.indexed = true;
+    if (fragment.has_pose) {
+      file.pose = fragment.pose;
+    }
+  }
+  return fragments;
+}
 
-  std::size_t loaded = 0;
-  for (const auto &[index, cloud_path] : indexed_clouds) {
-    if (_max_point_clouds > 0 && loaded >= _max_point_clouds) {
+std::optional<TransMat>
+DatasetLoader3DMatch::find_pose(const fs::path &sequence_path, std::size_t index,
+                                const FragmentFile &file) const {
+  if (file.indexed) {
+    return file.pose;
+  }
+  const fs::path pose_path = sequence_path / "poses" /
+                             ("cloud_bin_" + std::to_string(index) + ".txt");
+  if (!fs::exists(pose_path)) {
+    return std::nullopt;
+  }
+  return load_pose(pose_path);
+}
+
+void DatasetLoader3DMatch::read_fragments(
+    Sample &sample, const std::vector<const FragmentFile *> &files) const {
+  std::vector<fs::path> paths;
+  std::vector<FragmentExpectation> expected;
+  std::vector<std::size_t> counts;
+  paths.reserve(files.size());
+  expected.reserve(files.size());
+  counts.reserve(files.size());
+  for (const auto *file : files) {
+    paths.emplace_back(file->path);
+    expected.push_back({file->points, file->checksum});
+    counts.emplace_back(file->points);
+  }
+  sample.reload = fragment_reader(std::move(paths), std::move(expected), _fast_ply);
+
+  const bool sizes_known = std::none_of(
+      counts.begin(), counts.end(), [](std::size_t points) { return points == 0; });
+  if (deferred_loading() && sizes_known) {
+    sample.defer(std::move(counts));
+    return;
+  }
+  sample.point_clouds.reserve(files.size());
+  for (std::size_t idx = 0; idx < files.size(); ++idx) {
+    sample.point_clouds.emplace_back(sample.reload(idx));
+  }
+}
+
+Sample DatasetLoader3DMatch::load_sequence(const fs::path &sequence_path,
+                                           const FragmentIndex &fragments) const {
+  const fs::path poses_dir = sequence_path / "poses";
+  const bool indexed = fragments.begin()->second.indexed;
+  if (!indexed && (!fs::exists(poses_dir) || !fs::is_directory(poses_dir))) {
+    throw std::runtime_error("Missing poses directory: " +
+                             poses_dir.string());
+  }
+
+  Sample sample;
+  std::vector<const FragmentFile *> files;
+  for (const auto &[index, file] : fragments) {
+    if (_max_point_clouds > 0 && files.size() >= _max_point_clouds) {
       break;
     }
 
-    const fs::path pose_path =
-        poses_dir / ("cloud_bin_" + std::to_string(index) + ".txt");
-
-    if (!fs::exists(pose_path)) {
-      log_warn("Skipping cloud {} due to missing pose file", cloud_path.string());
+    auto pose = find_pose(sequence_path, index, file);
+    if (!pose) {
+      log_warn("Skipping cloud {} due to missing pose file", file.path.string());
       continue;
     }
 
-    PointCloud cloud = load_point_cloud(cloud_path);
-    TransMat pose = load_pose(pose_path);
-
-    sample.point_clouds.emplace_back(std::move(cloud));
-    sample.world_transforms.emplace_back(std::move(pose));
-    ++loaded;
+    sample.world_transforms.emplace_back(std::move(*pose));
+    files.emplace_back(&file);
   }
+  read_fragments(sample, files);
 
-  if (sample.point_clouds.size() != sample.world_transforms.size()) {
+  if (sample.fragment_count() != sample.world_transforms.size()) {
     throw std::runtime_error(
         "Loaded point clouds and poses count mismatch in sequence " +
         sequence_path.string());
   }
 
-  log_info("Sequence '{}' loaded with {} point clouds",
-           sequence_path.filename().string(), sample.point_clouds.size());
+  log_info("Sequence '{}' loaded with {} point clouds{}",
+           sequence_path.filename().string(), sample.fragment_count(),
+           sample.point_counts.empty() ? "" : " (deferred)");
 
   return sample;
 }
 
-PointCloud
-DatasetLoader3DMatch::load_point_cloud(const fs::path &path) const {
-  PointCloud cloud;
-  const auto ret = pcl::io::loadPLYFile(path.string(), cloud);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to load PLY file: " + path.string() +
-                             " (error code " + std::to_string(ret) + ")");
+fs::path
+DatasetLoader3DMatch::find_gt_log(const fs::path &sequence_path) const {
+  const std::vector<fs::path> candidates = {
+      sequence_path / _gt_log,
+      sequence_path.parent_path() /
+          (sequence_path.filename().string() + "-evaluation") / _gt_log,
+  };
+  for (const auto &candidate : candidates) {
+    if (fs::exists(candidate)) {
+      return candidate;
+    }
   }
-  return cloud;
+  throw std::runtime_error("No " + _gt_log + " found for sequence " +
+                           sequence_path.string());
+}
+
+Sample DatasetLoader3DMatch::load_pair_sequence(
+    const fs::path &sequence_path, const FragmentIndex &fragments,
+    const fs::path &gt_log_path) const {
+  std::ifstream in(gt_log_path);
+  if (!in.is_open()) {
+    throw std::runtime_error("Failed to open " + gt_log_path.string());
+  }
+
+  // Each record is "id1 id2 fragment_count" followed by a 4x4 matrix that
+  // maps fragment id2 into the frame of fragment id1.
+  struct LogEntry {
+    std::size_t target;
+    std::size_t source;
+    TransMat relative;
+  };
+  std::vector<LogEntry> entries;
+  std::size_t id1 = 0;
+  std::size_t id2 = 0;
+  std::size_t fragment_count = 0;
+  while (in >> id1 >> id2 >> fragment_count) {
+    LogEntry entry{id1, id2, TransMat::Identity()};
+    for (int row = 0; row < 4; ++row) {
+      for (int col = 0; col < 4; ++col) {
+        if (!(in >> entry.relative(row, col))) {
+          throw std::runtime_error("Truncated matrix in " + gt_log_path.string());
+        }
+      }
+    }
+    if (!fragments.contains(id1) || !fragments.contains(id2)) {
+      log_warn("Skipping pair ({}, {}) with missing fragment", id1, id2);
+      continue;
+    }
+    entries.emplace_back(std::move(entry));
+    if (_max_pairs > 0 && entries.size() >= _max_pairs) {
+      break;
+    }
+  }
+
+  if (entries.empty()) {
+    throw std::runtime_error("No usable pairs in " + gt_log_path.string());
+  }
+
+  // Every referenced fragment is loaded exactly once however many pairs
+  // share it.
+  std::map<std::size_t, std::size_t> fragment_slots;
+  for (const auto &entry : entries) {
+    fragment_slots.emplace(entry.target, 0);
+    fragment_slots.emplace(entry.source, 0);
+  }
+
+  Sample sample;
+  sample.world_transforms.reserve(fragment_slots.size());
+  std::vector<const FragmentFile *> files;
+  files.reserve(fragment_slots.size());
+  for (auto &[index, slot] : fragment_slots) {
+    slot = files.size();
+    const auto &file = fragments.at(index);
+    files.emplace_back(&file);
+    sample.world_transforms.emplace_back(
+        find_pose(sequence_path, index, file).value_or(TransMat::Identity()));
+  }
+  read_fragments(sample, files);
+
+  sample.pairs.reserve(entries.size());
+  for (const auto &entry : entries) {
+    sample.pairs.push_back({fragment_slots.at(entry.source),
+                            fragment_slots.at(entry.target), entry.relative});
+  }
+
+  log_info("Sequence '{}' loaded with {} pairs over {} point clouds{}",
+           sequence_path.filename().string(), sample.pairs.size(),
+           sample.fragment_count(),
+           sample.point_counts.empty() ? "" : " (deferred)");
+
+  return sample;
 }
 
 TransMat DatasetLoader3DMatch::load_pose(const fs::path &path) const {
@@ -1,25 +1,78 @@
 #pragma once
 
 #include "dataset_loader_base.hpp"
+#include "dataset_loader/dataset_manifest.hpp"
+#include <cstdint>
 #include <filesystem>
+#include <map>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <string>
 #include <vector>
 
+// 3DMatch layout:
+//   <root>/<split>/<sequence>/fragments/cloud_bin_<N>.ply
+//   <root>/<split>/<sequence>/poses/cloud_bin_<N>.txt
+//   <root>/<split>/<sequence>/gt.log or <sequence>-evaluation/gt.log
+// When the split has a manifest (see build_manifest()), sequences, fragments
+// and poses are taken from it instead of listing and probing the directories,
+// and with deferred loading, which the runner always turns on, no fragment is
+// read until a task needs it. A manifest that does not parse is ignored and
+// the split is scanned as if there were none.
 class DatasetLoader3DMatch : public DatasetLoaderBase {
 public:
   explicit DatasetLoader3DMatch(const nlohmann::json &config);
 
   std::vector<Sample> load_samples() override;
 
+  // Reads every fragment of the split once and records its point count,
+  // bounding box, pose, file size and checksum.
+  std::filesystem::path build_manifest() override;
+
   static std::shared_ptr<DatasetLoaderBase>
   create(const nlohmann::json &config);
 
   std::string name() const override { return "3dmatch"; }
 
 private:
-  Sample load_sequence(const std::filesystem::path &sequence_path) const;
-  PointCloud load_point_cloud(const std::filesystem::path &path) const;
+  // A fragment file of a sequence, and what is known about it before it is
+  // read.
+  struct FragmentFile {
+    std::filesystem::path path;
+    // Known from the manifest; 0 otherwise.
+    std::size_t points{0};
+    std::uint64_t checksum{0};
+    // Whether the manifest recorded the fragment, and so whether `pose` is
+    // all there is; otherwise the pose is looked up in poses/.
+    bool indexed{false};
+    std::optional<TransMat> pose;
+  };
+  using FragmentIndex = std::map<std::size_t, FragmentFile>;
+
+  std::vector<std::filesystem::path>
+  list_sequences(const std::filesystem::path &split_path) const;
+  FragmentIndex scan_fragments(const std::filesystem::path &sequence_path) const;
+  FragmentIndex manifest_fragments(const std::filesystem::path &split_path,
+                                   const ManifestSequence &sequence) const;
+  // nullopt when the split has no usable manifest.
+  std::optional<DatasetManifest>
+  load_manifest(const std::filesystem::path &split_path) const;
+
+  Sample load_sequence(const std::filesystem::path &sequence_path,
+                       const FragmentIndex &fragments) const;
+  Sample load_pair_sequence(const std::filesystem::path &sequence_path,
+                            const FragmentIndex &fragments,
+                            const std::filesystem::path &gt_log_path) const;
+  // Reads `files` into the sample's clouds, in order, and sets its reload
+  // source; defers them instead when deferred loading is on and their sizes
+  // are known.
+  void read_fragments(Sample &sample,
+                      const std::vector<const FragmentFile *> &files) const;
+  std::filesystem::path
+  find_gt_log(const std::filesystem::path &sequence_path) const;
+  std::optional<TransMat> find_pose(const std::filesystem::path &sequence_path,
+                                    std::size_t index,
+                                    const FragmentFile &file) const;
   TransMat load_pose(const std::filesystem::path &path) const;
 
   std::filesystem::path _root;
@@ -27,4 +80,14 @@ private:
   std::vector<std::string> _sequences;
   std::size_t _max_sequences{0};
   std::size_t _max_point_clouds{0};
+  bool _fast_ply{true};
+  // "sequential" registers consecutive fragments; "pairs" registers the
+  // pairs listed in the sequence's gt.log.
+  std::string _protocol{"sequential"};
+  std::string _gt_log{"gt.log"};
+  std::size_t _max_pairs{0};
+  // Relative to the split directory unless absolute; empty disables it.
+  std::filesystem::path _manifest{"manifest.bin"};
+  // Compares every fragment read against the manifest's checksum.
+  bool _verify_manifest{false};
 };
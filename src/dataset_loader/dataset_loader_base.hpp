@@ -1,16 +1,155 @@
 #pragma once
 #include "common.hpp"
+#include "compact_point_cloud.hpp"
+#include "fragment_cache.hpp"
 #include "logger.hpp"
 #include "singleton.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <memory>
 #include <map>
+#include <filesystem>
 #include <functional>
 #include <stdexcept>
 
+struct FragmentPair {
+  std::size_t source{0};
+  std::size_t target{0};
+  // Ground truth mapping points of `source` into the frame of `target`.
+  TransMat relative{TransMat::Identity()};
+};
+
 struct Sample {
   std::vector<PointCloud> point_clouds;
   std::vector<TransMat> world_transforms;
+  // Explicit evaluation pairs (e.g. 3DMatch gt.log). When non-empty the
+  // runner registers these pairs instead of consecutive fragments and scores
+  // the relative transforms.
+  std::vector<FragmentPair> pairs;
+  // Per-fragment derived data (normals, search structures, ...) shared by all
+  // pairs and algorithms evaluated on this sample.
+  std::shared_ptr<FragmentCache> cache{std::make_shared<FragmentCache>()};
+  // Quantized fragments. When non-empty they replace `point_clouds`, and
+  // fragment() decodes each one once into `cache`, where the decoded cloud
+  // lives as long as the data derived from it: until the fragment is
+  // released, or the runner clears the cache when done with the sample.
+  std::vector<CompactPointCloud> compact_clouds;
+  // Bits per coordinate of `compact_clouds`; 0 at full precision.
+  int compact_bits{0};
+  // Reads fragment `index` again at full precision after release(). Set by
+  // loaders that read fragments from files, or by MemoryBudget when it spills
+  // a sample to scratch storage.
+  std::function<PointCloud(std::size_t)> reload;
+  // Stored point count of every fragment, recorded by track_residency() so
+  // that it stays known while fragments are released.
+  std::vector<std::size_t> point_counts;
+  // Non-zero for fragments whose cloud was dropped by release(). One byte per
+  // fragment, so that different fragments can be restored concurrently.
+  std::vector<char> released;
+
+  std::size_t fragment_count() const {
+    return compact_clouds.empty() ? point_clouds.size() : compact_clouds.size();
+  }
+
+  std::size_t point_count(std::size_t index) const {
+    if (!point_counts.empty()) {
+      return point_counts.at(index);
+    }
+    return compact_clouds.empty() ? point_clouds.at(index).size() : compact_clouds.at(index).size();
+  }
+
+  bool is_released(std::size_t index) const {
+    return !released.empty() && released.at(index) != 0;
+  }
+
+  // Records the point counts and residency flags release() relies on. Done
+  // up front by whoever will release fragments concurrently, so that those
+  // vectors are never resized while other threads read them.
+  void track_residency() {
+    if (!point_counts.empty()) {
+      return;
+    }
+    std::vector<std::size_t> counts;
+    counts.reserve(fragment_count());
+    for (std::size_t idx = 0; idx < fragment_count(); ++idx) {
+      counts.emplace_back(point_count(idx));
+    }
+    point_counts = std::move(counts);
+    released.assign(fragment_count(), 0);
+  }
+
+  // Sets up `counts.size()` fragments with the given point counts that have
+  // not been read yet, exactly as if they were loaded and then released.
+  // Needs `reload` to bring them in.
+  void defer(std::vector<std::size_t> counts) {
+    if (!reload) {
+      throw std::logic_error("Sample::defer needs a reload source");
+    }
+    point_clouds.assign(counts.size(), PointCloud{});
+    released.assign(counts.size(), 1);
+    point_counts = std::move(counts);
+  }
+
+  // Drops the cloud of fragment `index` and its derived data. Needs `reload`
+  // to bring it back; the caller makes sure no one is using the fragment.
+  void release(std::size_t index) {
+    if (!reload) {
+      throw std::logic_error("Sample::release needs a reload source");
+    }
+    track_residency();
+    if (compact_clouds.empty()) {
+      point_clouds.at(index) = PointCloud{};
+    } else {
+      compact_clouds.at(index) = CompactPointCloud{};
+    }
+    cache->evict(index);
+    released.at(index) = 1;
+  }
+
+  // Reloads a released fragment in the representation it was stored in.
+  void restore(std::size_t index) {
+    if (!is_released(index)) {
+      return;
+    }
+    auto cloud = reload(index);
+    if (compact_clouds.empty()) {
+      point_clouds.at(index) = std::move(cloud);
+    } else {
+      compact_clouds.at(index) = CompactPointCloud(cloud, compact_bits);
+    }
+    released.at(index) = 0;
+  }
+
+  Fragment fragment(std::size_t index) const {
+    if (compact_clouds.empty()) {
+      return Fragment{point_clouds.at(index), cache.get(), index};
+    }
+    auto decoded = cache->get_or_compute<PointCloud>(index, "decoded", [this, index]() {
+      return std::make_shared<PointCloud>(compact_clouds.at(index).decode());
+    });
+    return Fragment{*decoded, cache.get(), index, decoded};
+  }
+
+  // Moves the fragments into quantized storage with `bits` per coordinate.
+  void compact(int bits) {
+    compact_bits = bits;
+    compact_clouds.reserve(point_clouds.size());
+    for (auto &cloud : point_clouds) {
+      compact_clouds.emplace_back(cloud, bits);
+      cloud = PointCloud{};
+    }
+    point_clouds = {};
+  }
+
+  // Largest distance between a point and its decoded position; 0 when the
+  // sample is stored at full precision.
+  double quantization_error() const {
+    double error = 0.0;
+    for (const auto &cloud : compact_clouds) {
+      error = std::max(error, cloud.max_error());
+    }
+    return error;
+  }
 };
 
 class DatasetLoaderBase:public LoggerAble<DatasetLoaderBase> {
@@ -18,6 +157,45 @@ public:
   virtual ~DatasetLoaderBase() = default;
   virtual std::vector<Sample>  load_samples() = 0;
   virtual std::string name() const = 0;
+
+  // Quantization applied by finish_sample(); 0 keeps full precision.
+  void set_compact_bits(int bits) { _compact_bits = bits; }
+  int compact_bits() const { return _compact_bits; }
+
+  // Called by finish_sample() on every sample once it is stored, e.g. for a
+  // memory budget to release fragments while the rest is still loading.
+  void set_sample_hook(std::function<void(Sample &)> hook) { _sample_hook = std::move(hook); }
+
+  // Lets loaders that know every fragment's size up front (e.g. from a
+  // manifest) return samples whose fragments are deferred (Sample::defer) and
+  // only read when first needed. Only for callers that restore fragments
+  // before using them, as MemoryBudget::admit() does; the runner always does.
+  void set_deferred_loading(bool deferred) { _deferred_loading = deferred; }
+  bool deferred_loading() const { return _deferred_loading; }
+
+  // Writes an index of the dataset that later runs start from instead of
+  // scanning it, and returns its path. Throws for loaders without one.
+  virtual std::filesystem::path build_manifest() {
+    throw std::runtime_error("Dataset loader '" + name() + "' has no manifest");
+  }
+
+protected:
+  // Called by loaders on every sample once it is complete (and its `reload`
+  // set, where the loader provides one), so at most one sample is held at
+  // full precision while loading.
+  void finish_sample(Sample &sample) const {
+    if (_compact_bits > 0) {
+      sample.compact(_compact_bits);
+    }
+    if (_sample_hook) {
+      _sample_hook(sample);
+    }
+  }
+
+private:
+  int _compact_bits{0};
+  bool _deferred_loading{false};
+  std::function<void(Sample &)> _sample_hook;
 };
 
 using DatasetLoader = DatasetLoaderBase*;
@@ -0,0 +1,197 @@
+#include "dataset_loader/dataset_manifest.hpp"
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr std::string_view MAGIC{"RGMANIFS"};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+constexpr std::size_t padded(std::size_t bytes) {
+  return (bytes + 7) & ~std::size_t{7};
+}
+
+template <typename T> void put(std::vector<char> &buffer, const T &value) {
+  const auto offset = buffer.size();
+  buffer.resize(offset + sizeof(T));
+  std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+void put_bytes(std::vector<char> &buffer, const void *data, std::size_t bytes) {
+  const auto offset = buffer.size();
+  buffer.resize(offset + bytes);
+  if (bytes > 0) {
+    std::memcpy(buffer.data() + offset, data, bytes);
+  }
+}
+
+void pad(std::vector<char> &buffer) {
+  buffer.resize(padded(buffer.size()), '\0');
+}
+
+// Bounds-checked cursor over a mapped manifest.
+class Cursor {
+public:
+  Cursor(const char *data, std::size_t size, const std::filesystem::path &path)
+      : _data(data), _size(size), _path(path) {}
+
+  template <typename T> T get() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char *take(std::size_t bytes) {
+    if (bytes > _size - _offset) {
+      throw std::runtime_error("Truncated dataset manifest: " + _path.string());
+    }
+    const char *data = _data + _offset;
+    _offset += bytes;
+    return data;
+  }
+
+  std::string string(std::size_t bytes) { return {take(bytes), bytes}; }
+
+  // Reads an element count and checks that that many records of at least
+  // `min_bytes` each fit in what is left, before anything is sized by it.
+  std::size_t count(std::size_t min_bytes) {
+    const auto value = get<std::uint64_t>();
+    if (value > (_size - _offset) / min_bytes) {
+      throw std::runtime_error("Invalid dataset manifest, " +
+                               std::to_string(value) +
+                               " records cannot fit in " + _path.string());
+    }
+    return static_cast<std::size_t>(value);
+  }
+
+  void align() { take(padded(_offset) - _offset); }
+
+private:
+  const char *_data;
+  std::size_t _size;
+  const std::filesystem::path &_path;
+  std::size_t _offset{0};
+};
+
+} // namespace
+
+const ManifestSequence *DatasetManifest::find(std::string_view name) const {
+  const auto it = std::lower_bound(
+      sequences.begin(), sequences.end(), name,
+      [](const ManifestSequence &sequence, std::string_view key) {
+        return sequence.name < key;
+      });
+  return it != sequences.end() && it->name == name ? &*it : nullptr;
+}
+
+void DatasetManifest::save(const std::filesystem::path &path) const {
+  std::vector<char> buffer;
+  put_bytes(buffer, MAGIC.data(), MAGIC.size());
+  put(buffer, VERSION);
+  put(buffer, BYTE_ORDER_MARK);
+  put(buffer, static_cast<std::uint64_t>(sequences.size()));
+  for (const auto &sequence : sequences) {
+    put(buffer, static_cast<std::uint32_t>(sequence.name.size()));
+    put(buffer, static_cast<std::uint32_t>(sequence.gt_log.size()));
+    put_bytes(buffer, sequence.name.data(), sequence.name.size());
+    put_bytes(buffer, sequence.gt_log.data(), sequence.gt_log.size());
+    pad(buffer);
+    put(buffer, static_cast<std::uint64_t>(sequence.fragments.size()));
+    for (const auto &fragment : sequence.fragments) {
+      put(buffer, static_cast<std::uint64_t>(fragment.index));
+      put(buffer, fragment.file_size);
+      put(buffer, fragment.checksum);
+      put(buffer, static_cast<std::uint64_t>(fragment.points));
+      put_bytes(buffer, fragment.min.data(), 3 * sizeof(float));
+      put_bytes(buffer, fragment.max.data(), 3 * sizeof(float));
+      put(buffer, static_cast<std::uint32_t>(fragment.has_pose));
+      put(buffer, static_cast<std::uint32_t>(fragment.path.size()));
+      put_bytes(buffer, fragment.pose.data(), 16 * sizeof(float));
+      put_bytes(buffer, fragment.path.data(), fragment.path.size());
+      pad(buffer);
+    }
+  }
+
+  auto temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!out) {
+      throw std::runtime_error("Failed to write dataset manifest: " +
+                               temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+DatasetManifest DatasetManifest::load(const std::filesystem::path &path) {
+  const MappedFile file(path);
+  Cursor cursor(file.data(), file.size(), path);
+  if (std::string_view(cursor.take(MAGIC.size()), MAGIC.size()) != MAGIC) {
+    throw std::runtime_error("Not a dataset manifest: " + path.string());
+  }
+  if (cursor.get<std::uint32_t>() != VERSION) {
+    throw std::runtime_error("Unsupported dataset manifest version in " +
+                             path.string());
+  }
+  if (cursor.get<std::uint32_t>() != BYTE_ORDER_MARK) {
+    throw std::runtime_error(
+        "Dataset manifest was written with another byte order: " +
+        path.string());
+  }
+
+  // Smallest records the counts may claim: a sequence with empty strings and
+  // no fragments, and a fragment with an empty path.
+  constexpr std::size_t min_sequence_bytes =
+      2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+  constexpr std::size_t min_fragment_bytes = 4 * sizeof(std::uint64_t) +
+                                             6 * sizeof(float) +
+                                             2 * sizeof(std::uint32_t) +
+                                             16 * sizeof(float);
+
+  DatasetManifest manifest;
+  manifest.sequences.resize(cursor.count(min_sequence_bytes));
+  for (auto &sequence : manifest.sequences) {
+    const auto name_size = cursor.get<std::uint32_t>();
+    const auto gt_log_size = cursor.get<std::uint32_t>();
+    sequence.name = cursor.string(name_size);
+    sequence.gt_log = cursor.string(gt_log_size);
+    cursor.align();
+    sequence.fragments.resize(cursor.count(min_fragment_bytes));
+    for (auto &fragment : sequence.fragments) {
+      fragment.index = static_cast<std::size_t>(cursor.get<std::uint64_t>());
+      fragment.file_size = cursor.get<std::uint64_t>();
+      fragment.checksum = cursor.get<std::uint64_t>();
+      fragment.points = static_cast<std::size_t>(cursor.get<std::uint64_t>());
+      std::memcpy(fragment.min.data(), cursor.take(3 * sizeof(float)),
+                  3 * sizeof(float));
+      std::memcpy(fragment.max.data(), cursor.take(3 * sizeof(float)),
+                  3 * sizeof(float));
+      fragment.has_pose = cursor.get<std::uint32_t>() != 0;
+      const auto path_size = cursor.get<std::uint32_t>();
+      std::memcpy(fragment.pose.data(), cursor.take(16 * sizeof(float)),
+                  16 * sizeof(float));
+      fragment.path = cursor.string(path_size);
+      cursor.align();
+    }
+  }
+  return manifest;
+}
+
+std::uint64_t file_checksum(const std::filesystem::path &path) {
+  const MappedFile file(path);
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char c : file.view()) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
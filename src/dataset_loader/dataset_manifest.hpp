@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Precomputed index of a dataset split, so that a loader can start without
+// listing directories or probing for files, and schedulers know the size of
+// every fragment before any of them is read.
+//
+//   header:    "RGMANIFS", u32 version, u32 byte-order mark, u64 sequences
+//   sequence:  u32 name length, u32 gt_log length, name, gt_log (padded to
+//              8 bytes), u64 fragments
+//   fragment:  u64 index, u64 file size, u64 checksum, u64 points,
+//              f32 min[3], f32 max[3], u32 has_pose, u32 path length,
+//              f32 pose[16] (column-major), path (padded to 8 bytes)
+//
+// Paths are relative to the split directory, so a manifest stays valid when
+// the dataset is moved or mounted elsewhere.
+struct ManifestFragment {
+  // N of cloud_bin_N.
+  std::size_t index{0};
+  std::string path;
+  std::uint64_t file_size{0};
+  // FNV-1a of the file's bytes.
+  std::uint64_t checksum{0};
+  std::size_t points{0};
+  Eigen::Vector3f min{Eigen::Vector3f::Zero()};
+  Eigen::Vector3f max{Eigen::Vector3f::Zero()};
+  bool has_pose{false};
+  TransMat pose{TransMat::Identity()};
+};
+
+struct ManifestSequence {
+  std::string name;
+  // Pair list found for the sequence, relative to the split directory; empty
+  // when there is none.
+  std::string gt_log;
+  // Sorted by index.
+  std::vector<ManifestFragment> fragments;
+};
+
+struct DatasetManifest {
+  // Sorted by name.
+  std::vector<ManifestSequence> sequences;
+
+  // nullptr when the split has no sequence `name`.
+  const ManifestSequence *find(std::string_view name) const;
+
+  // Written aside and renamed, so a reader never sees half a manifest.
+  void save(const std::filesystem::path &path) const;
+  // Throws std::runtime_error when `path` is not a readable manifest.
+  static DatasetManifest load(const std::filesystem::path &path);
+};
+
+// FNV-1a over the whole file, as recorded in ManifestFragment::checksum.
+std::uint64_t file_checksum(const std::filesystem::path &path);
@@ -0,0 +1,300 @@
+#include "dataset_loader/kitti_dataset_loader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "mapped_file.hpp"
+
+namespace fs = std::filesystem;
+
+REGISTER_DATASET_LOADER(kitti, DatasetLoaderKitti);
+
+namespace {
+constexpr std::size_t KITTI_POINT_STRIDE = 4 * sizeof(float);
+
+static_assert(sizeof(pcl::PointXYZ) == KITTI_POINT_STRIDE,
+              "velodyne records are copied directly into pcl::PointXYZ");
+
+bool parse_row_major_3x4(std::istringstream &iss, TransMat &matrix) {
+  matrix = TransMat::Identity();
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      if (!(iss >> matrix(row, col))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::string frame_file_name(std::size_t frame) {
+  auto name = std::to_string(frame);
+  if (name.size() < 6) {
+    name.insert(0, 6 - name.size(), '0');
+  }
+  return name + ".bin";
+}
+} // namespace
+
+PointCloud read_kitti_scan(const fs::path &path, float min_range, float max_range) {
+  const MappedFile file(path);
+  if (file.size() % KITTI_POINT_STRIDE != 0) {
+    throw std::runtime_error("Velodyne scan size is not a multiple of 16 bytes: " +
+                             path.string());
+  }
+
+  const std::size_t count = file.size() / KITTI_POINT_STRIDE;
+  PointCloud cloud;
+
+  if (min_range <= 0.0f && max_range <= 0.0f) {
+    // Records already have the PointXYZ layout; the intensity lands in the
+    // padding word, which is reset to 1 as PCL expects.
+    cloud.resize(count);
+    std::memcpy(static_cast<void *>(cloud.points.data()), file.data(), file.size());
+    for (auto &point : cloud.points) {
+      point.data[3] = 1.0f;
+    }
+    return cloud;
+  }
+
+  const float min_sq = min_range * min_range;
+  const float max_sq = max_range > 0.0f ? max_range * max_range
+                                        : std::numeric_limits<float>::max();
+  cloud.reserve(count);
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    float record[4];
+    std::memcpy(record, file.data() + idx * KITTI_POINT_STRIDE, sizeof(record));
+    const float range_sq =
+        record[0] * record[0] + record[1] * record[1] + record[2] * record[2];
+    if (range_sq >= min_sq && range_sq <= max_sq) {
+      cloud.push_back(pcl::PointXYZ(record[0], record[1], record[2]));
+    }
+  }
+  return cloud;
+}
+
+DatasetLoaderKitti::DatasetLoaderKitti(const nlohmann::json &config) {
+  if (config.contains("root")) {
+    if (!config["root"].is_string()) {
+      throw std::invalid_argument(
+          "DatasetLoaderKitti expects 'root' to be a string when provided");
+    }
+    _root = fs::path(config["root"].get<std::string>());
+  } else {
+    _root = fs::path("datasets/kitti");
+  }
+
+  _start = config.value("start", _start);
+  _frames = config.value("frames", _frames);
+  _stride = config.value("stride", _stride);
+  _window = config.value("window", _window);
+  _max_windows = config.value("max_windows", _max_windows);
+  _min_range = config.value("min_range", _min_range);
+  _max_range = config.value("max_range", _max_range);
+
+  if (_stride == 0) {
+    throw std::invalid_argument("'stride' must be positive");
+  }
+  if (_window == 1) {
+    throw std::invalid_argument("'window' must be 0 (whole selection) or at least 2");
+  }
+
+  if (config.contains("sequences")) {
+    if (!config["sequences"].is_array()) {
+      throw std::invalid_argument("'sequences' must be an array of strings");
+    }
+    for (const auto &seq : config["sequences"]) {
+      if (!seq.is_string()) {
+        throw std::invalid_argument(
+            "'sequences' must contain only string elements");
+      }
+      _sequences.emplace_back(seq.get<std::string>());
+    }
+  }
+
+  if (!fs::exists(_root / "sequences")) {
+    throw std::runtime_error("KITTI sequences directory does not exist: " +
+                             (_root / "sequences").string());
+  }
+}
+
+std::vector<Sample> DatasetLoaderKitti::load_samples() {
+  std::vector<std::string> sequences = _sequences;
+  if (sequences.empty()) {
+    for (const auto &entry : fs::directory_iterator(_root / "sequences")) {
+      if (entry.is_directory()) {
+        sequences.emplace_back(entry.path().filename().string());
+      }
+    }
+    std::sort(sequences.begin(), sequences.end());
+  }
+
+  log_info("Loading KITTI odometry from {} ({} sequence(s))", _root.string(),
+           sequences.size());
+
+  std::vector<Sample> samples;
+  for (const auto &sequence : sequences) {
+    try {
+      auto windows = load_sequence(sequence);
+      for (auto &sample : windows) {
+        samples.emplace_back(std::move(sample));
+      }
+    } catch (const std::exception &e) {
+      log_warn("Skipping sequence '{}' due to error: {}", sequence, e.what());
+    }
+  }
+
+  log_info("Loaded {} samples", samples.size());
+  return samples;
+}
+
+std::vector<Sample>
+DatasetLoaderKitti::load_sequence(const std::string &sequence) const {
+  const fs::path sequence_path = _root / "sequences" / sequence;
+  const fs::path velodyne_dir = sequence_path / "velodyne";
+  if (!fs::exists(velodyne_dir) || !fs::is_directory(velodyne_dir)) {
+    throw std::runtime_error("Missing velodyne directory: " +
+                             velodyne_dir.string());
+  }
+
+  const auto camera_poses = load_poses(sequence);
+  const TransMat calibration = load_calibration(sequence_path / "calib.txt");
+  const TransMat calibration_inverse = calibration.inverse();
+
+  std::vector<std::size_t> frames;
+  for (std::size_t frame = _start; frame < camera_poses.size(); frame += _stride) {
+    if (_frames > 0 && frames.size() >= _frames) {
+      break;
+    }
+    frames.emplace_back(frame);
+  }
+  if (frames.empty()) {
+    throw std::runtime_error("No frames selected in sequence " + sequence);
+  }
+
+  // Consecutive windows share their boundary frame so that every selected
+  // pair is registered exactly once.
+  const std::size_t window = _window > 0 ? _window : frames.size();
+  std::vector<Sample> samples;
+  for (std::size_t begin = 0;; begin += window - 1) {
+    if (_max_windows > 0 && samples.size() >= _max_windows) {
+      break;
+    }
+    const std::size_t end = std::min(begin + window, frames.size());
+
+    Sample sample;
+    sample.world_transforms.reserve(end - begin);
+    std::vector<fs::path> scan_paths;
+    scan_paths.reserve(end - begin);
+
+    const TransMat first_inverse =
+        (calibration_inverse * camera_poses[frames[begin]] * calibration).inverse();
+    for (std::size_t idx = begin; idx < end; ++idx) {
+      const auto frame = frames[idx];
+      scan_paths.emplace_back(velodyne_dir / frame_file_name(frame));
+      sample.world_transforms.emplace_back(
+          first_inverse * calibration_inverse * camera_poses[frame] * calibration);
+    }
+    sample.reload = [scan_paths, min_range = _min_range,
+                     max_range = _max_range](std::size_t index) {
+      return read_kitti_scan(scan_paths.at(index), min_range, max_range);
+    };
+
+    if (deferred_loading()) {
+      // The record count bounds the points a scan keeps after range
+      // filtering, which is what memory estimates need.
+      std::vector<std::size_t> counts;
+      counts.reserve(scan_paths.size());
+      for (const auto &path : scan_paths) {
+        counts.emplace_back(fs::file_size(path) / KITTI_POINT_STRIDE);
+      }
+      sample.defer(std::move(counts));
+    } else {
+      sample.point_clouds.reserve(scan_paths.size());
+      for (const auto &path : scan_paths) {
+        sample.point_clouds.emplace_back(load_scan(path));
+      }
+    }
+
+    log_info("Sequence '{}' window of frames {}..{} {} with {} scans", sequence,
+             frames[begin], frames[end - 1],
+             deferred_loading() ? "deferred" : "loaded", sample.fragment_count());
+    finish_sample(sample);
+    samples.emplace_back(std::move(sample));
+
+    if (end == frames.size()) {
+      break;
+    }
+  }
+
+  return samples;
+}
+
+PointCloud DatasetLoaderKitti::load_scan(const fs::path &path) const {
+  return read_kitti_scan(path, _min_range, _max_range);
+}
+
+std::vector<TransMat>
+DatasetLoaderKitti::load_poses(const std::string &sequence) const {
+  fs::path path = _root / "poses" / (sequence + ".txt");
+  if (!fs::exists(path)) {
+    path = _root / "sequences" / sequence / "poses.txt";
+  }
+
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    throw std::runtime_error("Missing ground truth poses for sequence " +
+                             sequence);
+  }
+
+  std::vector<TransMat> poses;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream iss(line);
+    TransMat pose;
+    if (!parse_row_major_3x4(iss, pose)) {
+      throw std::runtime_error("Failed to parse pose line " +
+                               std::to_string(poses.size()) + " in " +
+                               path.string());
+    }
+    poses.emplace_back(pose);
+  }
+  return poses;
+}
+
+TransMat DatasetLoaderKitti::load_calibration(const fs::path &path) const {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    log_warn("Calibration file {} missing, using identity", path.string());
+    return TransMat::Identity();
+  }
+
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.starts_with("Tr:")) {
+      continue;
+    }
+    std::istringstream iss(line.substr(3));
+    TransMat calibration;
+    if (!parse_row_major_3x4(iss, calibration)) {
+      throw std::runtime_error("Failed to parse Tr in " + path.string());
+    }
+    return calibration;
+  }
+
+  log_warn("No 'Tr:' entry in {}, using identity", path.string());
+  return TransMat::Identity();
+}
+
+std::shared_ptr<DatasetLoaderBase>
+DatasetLoaderKitti::create(const nlohmann::json &config) {
+  return std::make_shared<DatasetLoaderKitti>(config);
+}
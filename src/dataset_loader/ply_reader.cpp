@@ -0,0 +1,433 @@
+#include "dataset_loader/ply_reader.hpp"
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t ASCII_CHUNK_LINES = 1 << 16;
+
+enum class PlyFormat { Ascii, BinaryLittleEndian };
+
+struct PlyProperty {
+  std::string name;
+  std::size_t size{0};
+  bool is_float{false};
+  bool is_double{false};
+};
+
+struct PlyHeader {
+  PlyFormat format{PlyFormat::Ascii};
+  std::size_t vertex_count{0};
+  std::size_t body_offset{0};
+  std::vector<PlyProperty> properties;
+  std::array<int, 3> xyz{-1, -1, -1};
+};
+
+std::optional<PlyProperty> make_property(const std::string &type,
+                                         const std::string &name) {
+  PlyProperty property;
+  property.name = name;
+  if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") {
+    property.size = 1;
+  } else if (type == "short" || type == "ushort" || type == "int16" ||
+             type == "uint16") {
+    property.size = 2;
+  } else if (type == "int" || type == "uint" || type == "int32" ||
+             type == "uint32") {
+    property.size = 4;
+  } else if (type == "float" || type == "float32") {
+    property.size = 4;
+    property.is_float = true;
+  } else if (type == "double" || type == "float64") {
+    property.size = 8;
+    property.is_double = true;
+  } else {
+    return std::nullopt;
+  }
+  return property;
+}
+
+// Parses the header and returns std::nullopt for layouts handled by PCL only:
+// big endian bodies, list properties on vertices, or any element before
+// `vertex`.
+std::optional<PlyHeader> parse_header(std::string_view data) {
+  if (!data.starts_with("ply\n") && !data.starts_with("ply\r\n")) {
+    return std::nullopt;
+  }
+
+  PlyHeader header;
+  bool format_seen = false;
+  bool in_vertex = false;
+  bool vertex_seen = false;
+  std::size_t offset = 0;
+
+  while (offset < data.size()) {
+    const auto newline = data.find('\n', offset);
+    if (newline == std::string_view::npos) {
+      return std::nullopt;
+    }
+    auto line = data.substr(offset, newline - offset);
+    offset = newline + 1;
+    if (line.ends_with('\r')) {
+      line.remove_suffix(1);
+    }
+
+    std::istringstream iss{std::string(line)};
+    std::string keyword;
+    iss >> keyword;
+
+    if (keyword == "format") {
+      std::string format;
+      iss >> format;
+      if (format == "ascii") {
+        header.format = PlyFormat::Ascii;
+      } else if (format == "binary_little_endian" &&
+                 std::endian::native == std::endian::little) {
+        header.format = PlyFormat::BinaryLittleEndian;
+      } else {
+        return std::nullopt;
+      }
+      format_seen = true;
+    } else if (keyword == "element") {
+      std::string name;
+      std::size_t count = 0;
+      if (!(iss >> name >> count)) {
+        return std::nullopt;
+      }
+      if (name == "vertex") {
+        if (vertex_seen) {
+          return std::nullopt;
+        }
+        header.vertex_count = count;
+        vertex_seen = true;
+        in_vertex = true;
+      } else if (!vertex_seen) {
+        return std::nullopt;
+      } else {
+        in_vertex = false;
+      }
+    } else if (keyword == "property") {
+      if (!in_vertex) {
+        continue;
+      }
+      std::string type;
+      std::string name;
+      if (!(iss >> type >> name) || type == "list") {
+        return std::nullopt;
+      }
+      auto property = make_property(type, name);
+      if (!property) {
+        return std::nullopt;
+      }
+      const auto index = static_cast<int>(header.properties.size());
+      if (name == "x") {
+        header.xyz[0] = index;
+      } else if (name == "y") {
+        header.xyz[1] = index;
+      } else if (name == "z") {
+        header.xyz[2] = index;
+      }
+      header.properties.emplace_back(std::move(*property));
+    } else if (keyword == "end_header") {
+      header.body_offset = offset;
+      break;
+    }
+  }
+
+  if (!format_seen || !vertex_seen || header.body_offset == 0) {
+    return std::nullopt;
+  }
+  for (const int index : header.xyz) {
+    if (index < 0 || !(header.properties[index].is_float ||
+                       header.properties[index].is_double)) {
+      return std::nullopt;
+    }
+  }
+  return header;
+}
+
+// ---------------------------------------------------------------------------
+// ASCII number parsing. Digit runs are consumed eight at a time with SWAR
+// arithmetic on a 64-bit word; values that do not fit the exact fast path
+// (more than 19 significant digits, large exponents, inf/nan) go through
+// std::from_chars.
+
+bool is_eight_digits(std::uint64_t value) {
+  return ((value & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+std::uint32_t parse_eight_digits(std::uint64_t value) {
+  constexpr std::uint64_t mask = 0x000000FF000000FFULL;
+  constexpr std::uint64_t mul1 = 0x000F424000000064ULL;
+  constexpr std::uint64_t mul2 = 0x0000271000000001ULL;
+  value -= 0x3030303030303030ULL;
+  value = (value * 10) + (value >> 8);
+  value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+  return static_cast<std::uint32_t>(value);
+}
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+int consume_digits(const char *&p, const char *end, std::uint64_t &mantissa) {
+  int count = 0;
+  if constexpr (std::endian::native == std::endian::little) {
+    while (end - p >= 8) {
+      std::uint64_t word;
+      std::memcpy(&word, p, sizeof(word));
+      if (!is_eight_digits(word)) {
+        break;
+      }
+      mantissa = mantissa * 100000000ULL + parse_eight_digits(word);
+      p += 8;
+      count += 8;
+    }
+  }
+  while (p < end && is_digit(*p)) {
+    mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+    ++p;
+    ++count;
+  }
+  return count;
+}
+
+const char *token_end(const char *p, const char *end) {
+  while (p < end && !is_blank(*p) && *p != '\n') {
+    ++p;
+  }
+  return p;
+}
+
+bool parse_float_slow(const char *start, const char *&p, const char *end,
+                      float &out) {
+  if (start < end && *start == '+') {
+    ++start;
+  }
+  const char *stop = token_end(start, end);
+  const auto result = std::from_chars(start, stop, out);
+  p = stop;
+  return result.ec == std::errc{} && result.ptr == stop;
+}
+
+bool parse_float(const char *&p, const char *end, float &out) {
+  static constexpr std::array<double, 23> powers = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  std::uint64_t mantissa = 0;
+  const int integer_digits = consume_digits(p, end, mantissa);
+  int fraction_digits = 0;
+  if (p < end && *p == '.') {
+    ++p;
+    fraction_digits = consume_digits(p, end, mantissa);
+  }
+  if (integer_digits + fraction_digits == 0 ||
+      integer_digits + fraction_digits > 19) {
+    return parse_float_slow(start, p, end, out);
+  }
+
+  int exponent = 0;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool exponent_negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      exponent_negative = *p == '-';
+      ++p;
+    }
+    std::uint64_t value = 0;
+    const int digits = consume_digits(p, end, value);
+    if (digits == 0 || digits > 4) {
+      return parse_float_slow(start, p, end, out);
+    }
+    exponent = exponent_negative ? -static_cast<int>(value) : static_cast<int>(value);
+  }
+  if (p < end && !is_blank(*p) && *p != '\n') {
+    return parse_float_slow(start, p, end, out);
+  }
+
+  const int scale = exponent - fraction_digits;
+  if (mantissa > (1ULL << 53) || scale < -22 || scale > 22) {
+    return parse_float_slow(start, p, end, out);
+  }
+
+  double value = static_cast<double>(mantissa);
+  value = scale < 0 ? value / powers[-scale] : value * powers[scale];
+  out = static_cast<float>(negative ? -value : value);
+  return true;
+}
+
+void skip_blanks(const char *&p, const char *end) {
+  while (p < end && is_blank(*p)) {
+    ++p;
+  }
+}
+
+bool decode_ascii(const PlyHeader &header, const char *body, const char *end,
+                  PointCloud &cloud) {
+  const std::size_t count = header.vertex_count;
+  std::vector<int> slot(header.properties.size(), -1);
+  int last_needed = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    slot[header.xyz[axis]] = axis;
+    last_needed = std::max(last_needed, header.xyz[axis]);
+  }
+
+  // Sequential newline scan to split the body into independently parsable
+  // chunks; memchr runs far faster than number parsing.
+  std::vector<const char *> chunk_starts;
+  chunk_starts.reserve(count / ASCII_CHUNK_LINES + 2);
+  const char *p = body;
+  for (std::size_t line = 0; line < count; ++line) {
+    if (line % ASCII_CHUNK_LINES == 0) {
+      chunk_starts.emplace_back(p);
+    }
+    const auto *newline =
+        static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    if (newline == nullptr) {
+      if (line + 1 != count || p == end) {
+        throw std::runtime_error("PLY ascii body is truncated");
+      }
+      p = end;
+    } else {
+      p = newline + 1;
+    }
+  }
+
+  cloud.resize(count);
+  bool ok = true;
+  bool dense = true;
+
+#pragma omp parallel for schedule(dynamic) reduction(&& : ok, dense)
+  for (long long chunk = 0; chunk < static_cast<long long>(chunk_starts.size()); ++chunk) {
+    const char *cursor = chunk_starts[chunk];
+    const std::size_t first = static_cast<std::size_t>(chunk) * ASCII_CHUNK_LINES;
+    const std::size_t last = std::min(first + ASCII_CHUNK_LINES, count);
+    for (std::size_t idx = first; idx < last && ok; ++idx) {
+      float xyz[3] = {0.0f, 0.0f, 0.0f};
+      for (int property = 0; property <= last_needed; ++property) {
+        skip_blanks(cursor, end);
+        if (slot[property] >= 0) {
+          ok = parse_float(cursor, end, xyz[slot[property]]) && ok;
+        } else {
+          cursor = token_end(cursor, end);
+        }
+      }
+      const auto *newline = static_cast<const char *>(
+          std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+      cursor = newline != nullptr ? newline + 1 : end;
+
+      auto &point = cloud.points[idx];
+      point.x = xyz[0];
+      point.y = xyz[1];
+      point.z = xyz[2];
+      dense = dense && std::isfinite(xyz[0]) && std::isfinite(xyz[1]) &&
+              std::isfinite(xyz[2]);
+    }
+  }
+
+  cloud.is_dense = dense;
+  return ok;
+}
+
+void decode_binary(const PlyHeader &header, const char *body, const char *end,
+                   PointCloud &cloud) {
+  std::size_t stride = 0;
+  std::vector<std::size_t> offsets;
+  offsets.reserve(header.properties.size());
+  for (const auto &property : header.properties) {
+    offsets.emplace_back(stride);
+    stride += property.size;
+  }
+
+  const std::size_t count = header.vertex_count;
+  if (static_cast<std::size_t>(end - body) / stride < count) {
+    throw std::runtime_error("PLY binary body is truncated");
+  }
+
+  std::array<std::size_t, 3> offset{};
+  std::array<bool, 3> is_double{};
+  for (int axis = 0; axis < 3; ++axis) {
+    offset[axis] = offsets[header.xyz[axis]];
+    is_double[axis] = header.properties[header.xyz[axis]].is_double;
+  }
+  const bool all_float = !is_double[0] && !is_double[1] && !is_double[2];
+
+  cloud.resize(count);
+  bool dense = true;
+
+#pragma omp parallel for reduction(&& : dense)
+  for (long long idx = 0; idx < static_cast<long long>(count); ++idx) {
+    const char *record = body + static_cast<std::size_t>(idx) * stride;
+    float xyz[3];
+    if (all_float) {
+      for (int axis = 0; axis < 3; ++axis) {
+        std::memcpy(&xyz[axis], record + offset[axis], sizeof(float));
+      }
+    } else {
+      for (int axis = 0; axis < 3; ++axis) {
+        if (is_double[axis]) {
+          double value;
+          std::memcpy(&value, record + offset[axis], sizeof(double));
+          xyz[axis] = static_cast<float>(value);
+        } else {
+          std::memcpy(&xyz[axis], record + offset[axis], sizeof(float));
+        }
+      }
+    }
+    auto &point = cloud.points[idx];
+    point.x = xyz[0];
+    point.y = xyz[1];
+    point.z = xyz[2];
+    dense = dense && std::isfinite(xyz[0]) && std::isfinite(xyz[1]) &&
+            std::isfinite(xyz[2]);
+  }
+
+  cloud.is_dense = dense;
+}
+
+} // namespace
+
+bool read_ply_points(const std::filesystem::path &path, PointCloud &cloud) {
+  const MappedFile file(path);
+  const auto header = parse_header(file.view());
+  if (!header) {
+    return false;
+  }
+
+  const char *body = file.data() + header->body_offset;
+  const char *end = file.data() + file.size();
+
+  if (header->format == PlyFormat::BinaryLittleEndian) {
+    decode_binary(*header, body, end, cloud);
+    return true;
+  }
+
+  if (!decode_ascii(*header, body, end, cloud)) {
+    throw std::runtime_error("Malformed number in PLY ascii body: " +
+                             path.string());
+  }
+  return true;
+}
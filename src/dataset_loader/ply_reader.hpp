@@ -0,0 +1,15 @@
+#pragma once
+
+#include "common.hpp"
+#include <filesystem>
+
+// Specialized reader for the PLY layouts found in registration datasets: a
+// leading `vertex` element with scalar float/double x, y, z (any other scalar
+// properties such as normals or colors are skipped), stored as ascii or
+// binary_little_endian. The file is memory mapped and decoded straight into
+// `cloud` without an intermediate PCLPointCloud2.
+//
+// Returns false, leaving `cloud` untouched, when the header uses a layout this
+// reader does not handle so that the caller can fall back to PCL. Throws
+// std::runtime_error when a supported file is truncated or malformed.
+bool read_ply_points(const std::filesystem::path &path, PointCloud &cloud);
@@ -0,0 +1,399 @@
+#include "dataset_loader/synthetic_dataset_loader.hpp"
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+REGISTER_DATASET_LOADER(synthetic, SyntheticDatasetLoader);
+
+namespace {
+
+constexpr std::size_t MIN_POINTS = 1000;
+constexpr std::size_t MAX_POINTS = 10'000'000;
+constexpr std::size_t CHUNK_SIZE = 1 << 16;
+constexpr std::size_t MAX_ATTEMPTS_PER_POINT = 1000;
+
+std::uint64_t splitmix64(std::uint64_t &state) {
+  std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+std::uint64_t mix_seed(std::uint64_t seed, std::uint64_t value) {
+  std::uint64_t state = seed ^ (value * 0xd1b54a32d192ed03ULL);
+  return splitmix64(state);
+}
+
+// Small self-contained generator so that the generated data does not depend
+// on the standard library's distribution implementations.
+class Random {
+public:
+  explicit Random(std::uint64_t seed) : _state(seed) {}
+
+  float uniform() {
+    return static_cast<float>(splitmix64(_state) >> 40) * 0x1.0p-24f;
+  }
+
+  float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+
+  float normal() {
+    const double u1 = (static_cast<double>(splitmix64(_state) >> 11) + 1.0) *
+                      0x1.0p-53;
+    const double u2 = static_cast<double>(splitmix64(_state) >> 11) * 0x1.0p-53;
+    return static_cast<float>(std::sqrt(-2.0 * std::log(u1)) *
+                              std::cos(2.0 * std::numbers::pi * u2));
+  }
+
+  Eigen::Vector3f unit_vector() {
+    for (;;) {
+      const Eigen::Vector3f v(normal(), normal(), normal());
+      const float norm = v.norm();
+      if (norm > 1e-6f) {
+        return v / norm;
+      }
+    }
+  }
+
+private:
+  std::uint64_t _state;
+};
+
+struct Primitive {
+  enum class Kind { Rectangle, Sphere, Cylinder };
+
+  Kind kind{Kind::Rectangle};
+  // Rectangle: origin + s * u + t * v. Sphere: origin is the center.
+  // Cylinder: origin is the center of the base, axis is +z.
+  Eigen::Vector3f origin{Eigen::Vector3f::Zero()};
+  Eigen::Vector3f u{Eigen::Vector3f::Zero()};
+  Eigen::Vector3f v{Eigen::Vector3f::Zero()};
+  float radius{0.0f};
+  float height{0.0f};
+
+  float area() const {
+    switch (kind) {
+    case Kind::Rectangle:
+      return u.cross(v).norm();
+    case Kind::Sphere:
+      return 4.0f * std::numbers::pi_v<float> * radius * radius;
+    case Kind::Cylinder:
+      return 2.0f * std::numbers::pi_v<float> * radius * height;
+    }
+    return 0.0f;
+  }
+
+  Eigen::Vector3f sample(Random &rng) const {
+    switch (kind) {
+    case Kind::Rectangle:
+      return origin + rng.uniform() * u + rng.uniform() * v;
+    case Kind::Sphere:
+      return origin + radius * rng.unit_vector();
+    case Kind::Cylinder: {
+      const float angle = rng.uniform(0.0f, 2.0f * std::numbers::pi_v<float>);
+      return origin + Eigen::Vector3f(radius * std::cos(angle),
+                                      radius * std::sin(angle),
+                                      rng.uniform(0.0f, height));
+    }
+    }
+    return origin;
+  }
+};
+
+class Scene {
+public:
+  void add(const Primitive &primitive) {
+    const float area = primitive.area();
+    if (area <= 0.0f) {
+      return;
+    }
+    _primitives.emplace_back(primitive);
+    _cumulative_area.emplace_back(
+        (_cumulative_area.empty() ? 0.0f : _cumulative_area.back()) + area);
+  }
+
+  void add_rectangle(const Eigen::Vector3f &origin, const Eigen::Vector3f &u,
+                     const Eigen::Vector3f &v) {
+    Primitive rect;
+    rect.kind = Primitive::Kind::Rectangle;
+    rect.origin = origin;
+    rect.u = u;
+    rect.v = v;
+    add(rect);
+  }
+
+  void add_box(const Eigen::Vector3f &min, const Eigen::Vector3f &max) {
+    const Eigen::Vector3f size = max - min;
+    const Eigen::Vector3f ex(size.x(), 0.0f, 0.0f);
+    const Eigen::Vector3f ey(0.0f, size.y(), 0.0f);
+    const Eigen::Vector3f ez(0.0f, 0.0f, size.z());
+    add_rectangle(min, ex, ey);
+    add_rectangle(min + ez, ex, ey);
+    add_rectangle(min, ex, ez);
+    add_rectangle(min + ey, ex, ez);
+    add_rectangle(min, ey, ez);
+    add_rectangle(min + ex, ey, ez);
+  }
+
+  Eigen::Vector3f sample(Random &rng) const {
+    const float pick = rng.uniform() * _cumulative_area.back();
+    const auto it = std::upper_bound(_cumulative_area.begin(),
+                                     _cumulative_area.end(), pick);
+    const auto idx = std::min<std::size_t>(
+        static_cast<std::size_t>(it - _cumulative_area.begin()),
+        _primitives.size() - 1);
+    return _primitives[idx].sample(rng);
+  }
+
+  bool empty() const { return _primitives.empty(); }
+
+private:
+  std::vector<Primitive> _primitives;
+  std::vector<float> _cumulative_area;
+};
+
+Scene build_scene(const std::string &kind, std::size_t objects,
+                  float size, float height, Random &rng) {
+  Scene scene;
+  const Eigen::Vector3f ex(size, 0.0f, 0.0f);
+  const Eigen::Vector3f ey(0.0f, size, 0.0f);
+
+  if (kind == "room") {
+    scene.add_box(Eigen::Vector3f::Zero(), Eigen::Vector3f(size, size, height));
+  } else {
+    scene.add_rectangle(Eigen::Vector3f::Zero(), ex, ey);
+  }
+
+  for (std::size_t idx = 0; idx < objects; ++idx) {
+    const float x = rng.uniform(0.1f * size, 0.9f * size);
+    const float y = rng.uniform(0.1f * size, 0.9f * size);
+    Primitive primitive;
+    switch (static_cast<int>(rng.uniform() * 3.0f)) {
+    case 0: {
+      const Eigen::Vector3f extent(rng.uniform(0.3f, 1.2f),
+                                   rng.uniform(0.3f, 1.2f),
+                                   rng.uniform(0.3f, std::min(1.5f, height)));
+      scene.add_box(Eigen::Vector3f(x, y, 0.0f),
+                    Eigen::Vector3f(x, y, 0.0f) + extent);
+      continue;
+    }
+    case 1:
+      primitive.kind = Primitive::Kind::Sphere;
+      primitive.radius = rng.uniform(0.2f, 0.6f);
+      primitive.origin =
+          Eigen::Vector3f(x, y, rng.uniform(primitive.radius, height * 0.8f));
+      break;
+    default:
+      primitive.kind = Primitive::Kind::Cylinder;
+      primitive.radius = rng.uniform(0.1f, 0.4f);
+      primitive.height = rng.uniform(0.5f, std::min(2.0f, height));
+      primitive.origin = Eigen::Vector3f(x, y, 0.0f);
+      break;
+    }
+    scene.add(primitive);
+  }
+
+  return scene;
+}
+
+// Fraction of the volume of a ball of radius r shared with an equal ball
+// whose center is d = x * r away, solved for x by bisection.
+float step_for_overlap(float overlap) {
+  const auto shared = [](float x) { return 1.0f - 0.75f * x + x * x * x / 16.0f; };
+  float lo = 0.0f;
+  float hi = 2.0f;
+  for (int iter = 0; iter < 60; ++iter) {
+    const float mid = 0.5f * (lo + hi);
+    if (shared(mid) > overlap) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5f * (lo + hi);
+}
+
+} // namespace
+
+SyntheticDatasetLoader::SyntheticDatasetLoader(const nlohmann::json &config) {
+  _seed = config.value("seed", _seed);
+  _sequences = config.value("sequences", _sequences);
+  _fragments = config.value("fragments", _fragments);
+  _points = config.value("points", _points);
+  _scene = config.value("scene", _scene);
+  _objects = config.value("objects", _objects);
+  _scene_size = config.value("scene_size", _scene_size);
+  _crop_radius = config.value("crop_radius", _crop_radius);
+  _overlap = config.value("overlap", _overlap);
+  _max_rotation_deg = config.value("max_rotation_deg", _max_rotation_deg);
+  _noise = config.value("noise", _noise);
+  _outlier_ratio = config.value("outlier_ratio", _outlier_ratio);
+
+  if (_scene != "room" && _scene != "primitives") {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'scene' must be \"room\" or \"primitives\"");
+  }
+  if (_points < MIN_POINTS || _points > MAX_POINTS) {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'points' must be between " +
+        std::to_string(MIN_POINTS) + " and " + std::to_string(MAX_POINTS));
+  }
+  if (_fragments == 0 || _sequences == 0) {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'sequences' and 'fragments' must be positive");
+  }
+  if (!(_overlap > 0.0f && _overlap <= 1.0f)) {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'overlap' must be in (0, 1]");
+  }
+  if (!(_outlier_ratio >= 0.0f && _outlier_ratio < 1.0f)) {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'outlier_ratio' must be in [0, 1)");
+  }
+  if (_scene_size <= 0.0f || _crop_radius <= 0.0f || _noise < 0.0f) {
+    throw std::invalid_argument(
+        "SyntheticDatasetLoader: 'scene_size' and 'crop_radius' must be "
+        "positive and 'noise' non-negative");
+  }
+}
+
+std::vector<Sample> SyntheticDatasetLoader::load_samples() {
+  log_info("Generating {} synthetic sequence(s) of {} fragment(s) with {} "
+           "points each (seed={}, scene={}, overlap={})",
+           _sequences, _fragments, _points, _seed, _scene, _overlap);
+
+  std::vector<Sample> samples;
+  samples.reserve(_sequences);
+  for (std::size_t idx = 0; idx < _sequences; ++idx) {
+    auto sample = generate_sequence(idx);
+    finish_sample(sample);
+    samples.emplace_back(std::move(sample));
+  }
+
+  log_info("Generated {} samples", samples.size());
+  return samples;
+}
+
+Sample
+SyntheticDatasetLoader::generate_sequence(std::size_t sequence_index) const {
+  const std::uint64_t sequence_seed = mix_seed(_seed, sequence_index);
+  Random rng(sequence_seed);
+
+  const float height = std::max(2.5f, 0.5f * _scene_size);
+  const Scene scene = build_scene(_scene, _objects, _scene_size, height, rng);
+
+  // Smooth random walk through the interior, reflected at the margins.
+  const float step = step_for_overlap(_overlap) * _crop_radius;
+  const float margin = std::min(0.25f * _scene_size, _crop_radius * 0.5f);
+  const float max_angle =
+      _max_rotation_deg * std::numbers::pi_v<float> / 180.0f;
+
+  std::vector<TransMat> poses;
+  poses.reserve(_fragments);
+  Eigen::Vector3f center(0.5f * _scene_size, 0.5f * _scene_size, 0.5f * height);
+  const float heading = rng.uniform(0.0f, 2.0f * std::numbers::pi_v<float>);
+  Eigen::Vector3f direction(std::cos(heading), std::sin(heading), 0.0f);
+  Eigen::Matrix3f rotation =
+      Eigen::AngleAxisf(heading, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+
+  for (std::size_t frag = 0; frag < _fragments; ++frag) {
+    if (frag > 0) {
+      const float turn = rng.uniform(-0.5f, 0.5f);
+      direction = Eigen::AngleAxisf(turn, Eigen::Vector3f::UnitZ()) * direction;
+      Eigen::Vector3f next = center + step * direction;
+      for (int axis = 0; axis < 2; ++axis) {
+        if (next[axis] < margin || next[axis] > _scene_size - margin) {
+          direction[axis] = -direction[axis];
+          next[axis] = center[axis] + step * direction[axis];
+        }
+      }
+      center = next;
+      rotation = rotation * Eigen::AngleAxisf(rng.uniform(-max_angle, max_angle),
+                                              rng.unit_vector())
+                                .toRotationMatrix();
+    }
+    TransMat pose = TransMat::Identity();
+    pose.block<3, 3>(0, 0) = rotation;
+    pose.block<3, 1>(0, 3) = center;
+    poses.emplace_back(pose);
+  }
+
+  Sample sample;
+  sample.point_clouds.resize(_fragments);
+  sample.world_transforms.reserve(_fragments);
+  const TransMat first_inverse = poses.front().inverse();
+  for (const auto &pose : poses) {
+    sample.world_transforms.emplace_back(first_inverse * pose);
+  }
+
+  // Points are produced in fixed-size chunks with their own seeds, so the
+  // result is identical regardless of how the chunks are scheduled.
+  const std::size_t chunks_per_fragment = (_points + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  const std::size_t total_chunks = chunks_per_fragment * _fragments;
+  const float radius_sq = _crop_radius * _crop_radius;
+  std::atomic<bool> exhausted{false};
+
+  for (auto &cloud : sample.point_clouds) {
+    cloud.resize(_points);
+    cloud.is_dense = true;
+  }
+
+#pragma omp parallel for schedule(dynamic)
+  for (long long chunk = 0; chunk < static_cast<long long>(total_chunks); ++chunk) {
+    const auto frag = static_cast<std::size_t>(chunk) / chunks_per_fragment;
+    const auto begin = (static_cast<std::size_t>(chunk) % chunks_per_fragment) * CHUNK_SIZE;
+    const auto end = std::min(begin + CHUNK_SIZE, _points);
+
+    Random chunk_rng(mix_seed(sequence_seed, static_cast<std::uint64_t>(chunk) + 1));
+    const Eigen::Matrix3f rotation_t = poses[frag].block<3, 3>(0, 0).transpose();
+    const Eigen::Vector3f origin = poses[frag].block<3, 1>(0, 3);
+    auto &cloud = sample.point_clouds[frag];
+
+    std::size_t attempts = 0;
+    const std::size_t max_attempts = (end - begin) * MAX_ATTEMPTS_PER_POINT;
+    for (std::size_t idx = begin; idx < end; ++idx) {
+      Eigen::Vector3f local;
+      if (chunk_rng.uniform() < _outlier_ratio) {
+        local = _crop_radius * std::cbrt(chunk_rng.uniform()) *
+                chunk_rng.unit_vector();
+      } else {
+        Eigen::Vector3f world;
+        do {
+          if (++attempts > max_attempts) {
+            exhausted = true;
+            break;
+          }
+          world = scene.sample(chunk_rng);
+        } while ((world - origin).squaredNorm() > radius_sq);
+        if (exhausted) {
+          break;
+        }
+        local = rotation_t * (world - origin);
+        if (_noise > 0.0f) {
+          local += _noise * Eigen::Vector3f(chunk_rng.normal(), chunk_rng.normal(),
+                                            chunk_rng.normal());
+        }
+      }
+      cloud.points[idx].getVector3fMap() = local;
+    }
+  }
+
+  if (exhausted) {
+    throw std::runtime_error(
+        "SyntheticDatasetLoader: crop_radius is too small to sample the scene");
+  }
+
+  log_info("Sequence {} generated with {} point clouds", sequence_index,
+           sample.point_clouds.size());
+
+  return sample;
+}
+
+std::shared_ptr<DatasetLoaderBase>
+SyntheticDatasetLoader::create(const nlohmann::json &config) {
+  return std::make_shared<SyntheticDatasetLoader>(config);
+}
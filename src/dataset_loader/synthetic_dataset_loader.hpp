@@ -0,0 +1,40 @@
+#pragma once
+
+#include "dataset_loader_base.hpp"
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Procedurally generated sequences with known ground truth. Every fragment is
+// a spherical crop of a random primitive scene seen from a pose on a smooth
+// random trajectory; the crop radius and step length are chosen so that
+// consecutive fragments share roughly `overlap` of their volume. Generation is
+// fully determined by `seed`, independent of the number of threads.
+class SyntheticDatasetLoader : public DatasetLoaderBase {
+public:
+  explicit SyntheticDatasetLoader(const nlohmann::json &config);
+
+  std::vector<Sample> load_samples() override;
+
+  static std::shared_ptr<DatasetLoaderBase>
+  create(const nlohmann::json &config);
+
+  std::string name() const override { return "synthetic"; }
+
+private:
+  Sample generate_sequence(std::size_t sequence_index) const;
+
+  std::uint64_t _seed{42};
+  std::size_t _sequences{1};
+  std::size_t _fragments{10};
+  std::size_t _points{10000};
+  std::string _scene{"room"};
+  std::size_t _objects{12};
+  float _scene_size{6.0f};
+  float _crop_radius{2.0f};
+  float _overlap{0.7f};
+  float _max_rotation_deg{5.0f};
+  float _noise{0.005f};
+  float _outlier_ratio{0.0f};
+};
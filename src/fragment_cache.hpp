@@ -0,0 +1,138 @@
+#pragma once
+#include "common.hpp"
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <utility>
+
+// Data derived from the fragments of one sample (normals, covariances, search
+// structures, ...), computed at most once per (fragment, key) and shared by
+// every pair and algorithm that needs it for the lifetime of the sample.
+// Concurrent requests for an entry under construction wait for the first
+// caller instead of recomputing it.
+class FragmentCache {
+public:
+  // `key` must identify both the kind of data and the parameters it was built
+  // with, e.g. "normals/k=20". `compute` must not request the same entry.
+  template <typename T, typename Compute>
+  std::shared_ptr<const T> get_or_compute(std::size_t fragment,
+                                          const std::string &key,
+                                          Compute &&compute) {
+    // Hits only copy the shared future, so steady-state lookups do not
+    // allocate.
+    {
+      std::scoped_lock lock(_mutex);
+      const auto it = _entries.find(KeyView{fragment, key});
+      if (it != _entries.end()) {
+        if (it->second.type != std::type_index(typeid(T))) {
+          throw std::logic_error("FragmentCache entry '" + key +
+                                 "' requested with a different type");
+        }
+        auto future = it->second.value;
+        return std::static_pointer_cast<const T>(future.get());
+      }
+    }
+
+    std::promise<Value> promise;
+    std::shared_future<Value> future;
+    bool owner = false;
+    {
+      std::scoped_lock lock(_mutex);
+      auto [it, inserted] = _entries.try_emplace({fragment, key});
+      if (inserted) {
+        it->second.type = std::type_index(typeid(T));
+        it->second.value = promise.get_future().share();
+        owner = true;
+      } else if (it->second.type != std::type_index(typeid(T))) {
+        throw std::logic_error("FragmentCache entry '" + key +
+                               "' requested with a different type");
+      }
+      future = it->second.value;
+    }
+
+    if (owner) {
+      try {
+        promise.set_value(std::shared_ptr<const T>(compute()));
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::scoped_lock lock(_mutex);
+        _entries.erase({fragment, key});
+      }
+    }
+
+    return std::static_pointer_cast<const T>(future.get());
+  }
+
+  // Drops every entry of `fragment`; callers holding results keep them alive.
+  void evict(std::size_t fragment) {
+    std::scoped_lock lock(_mutex);
+    auto it = _entries.lower_bound({fragment, std::string{}});
+    while (it != _entries.end() && it->first.first == fragment) {
+      it = _entries.erase(it);
+    }
+  }
+
+  void clear() {
+    std::scoped_lock lock(_mutex);
+    _entries.clear();
+  }
+
+  std::size_t size() const {
+    std::scoped_lock lock(_mutex);
+    return _entries.size();
+  }
+
+private:
+  using Value = std::shared_ptr<const void>;
+  using Key = std::pair<std::size_t, std::string>;
+  using KeyView = std::pair<std::size_t, std::string_view>;
+
+  // Lets lookups use a string_view key without building a std::string.
+  struct KeyLess {
+    using is_transparent = void;
+
+    template <typename Lhs, typename Rhs>
+    bool operator()(const Lhs &lhs, const Rhs &rhs) const {
+      return KeyView{lhs.first, lhs.second} < KeyView{rhs.first, rhs.second};
+    }
+  };
+
+  struct Entry {
+    std::type_index type{typeid(void)};
+    std::shared_future<Value> value;
+  };
+
+  mutable std::mutex _mutex;
+  std::map<Key, Entry, KeyLess> _entries;
+};
+
+// A fragment as handed to the algorithms: the cloud together with its index in
+// the sample and the sample's cache. `cache` is null when the cloud does not
+// belong to a sample, in which case derived data is simply not shared.
+struct Fragment {
+  const PointCloud &cloud;
+  FragmentCache *cache{nullptr};
+  std::size_t index{0};
+  // Set when `cloud` is a decoded copy (compact samples) that must outlive
+  // whatever keeps a pointer to it.
+  PointCloud::ConstPtr owner{};
+
+  // Pointer for PCL interfaces. Non-owning, and valid as long as the sample
+  // is, unless the fragment owns a decoded cloud.
+  PointCloud::ConstPtr shared() const {
+    return owner ? owner : PointCloud::ConstPtr(PointCloud::ConstPtr{}, &cloud);
+  }
+
+  template <typename T, typename Compute>
+  std::shared_ptr<const T> derived(const std::string &key, Compute &&compute) const {
+    if (cache == nullptr) {
+      return std::shared_ptr<const T>(compute());
+    }
+    return cache->get_or_compute<T>(index, key, std::forward<Compute>(compute));
+  }
+};
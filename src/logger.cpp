@@ -40,6 +40,10 @@ LogLevel Logger::level() const {
 
 void Logger::log_impl(LogLevel level, std::string_view role, std::string_view message) {
     std::scoped_lock lock(_mutex);
+    if (_status_width > 0) {
+        std::cout << '\r' << std::string(_status_width, ' ') << '\r';
+        _status_width = 0;
+    }
     auto &stream = (level == LogLevel::Error) ? std::cerr : std::cout;
     const auto role_view = role.empty() ? std::string_view{"-"} : role;
     stream << std::format("[{}] [{}] [{}] {}", current_timestamp(),
@@ -68,6 +72,20 @@ void Logger::progress(double ratio, std::size_t completed, std::size_t total) {
     }
 }
 
+void Logger::status(std::string_view line, bool last) {
+    std::scoped_lock lock(_mutex);
+    // Pad over the rest of a longer previous line.
+    const auto padding = _status_width > line.size() ? _status_width - line.size() : 0;
+    std::cout << '\r' << line << std::string(padding, ' ');
+    if (last) {
+        std::cout << '\n';
+        _status_width = 0;
+    } else {
+        _status_width = line.size();
+    }
+    std::cout << std::flush;
+}
+
 std::string_view Logger::level_to_string(LogLevel level) {
     switch (level) {
     case LogLevel::Debug:
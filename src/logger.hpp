@@ -45,6 +45,10 @@ public:
 
     void progress(double ratio, std::size_t completed, std::size_t total);
 
+    // Redraws a single status line in place; log lines printed meanwhile
+    // clear it first. `last` ends it with a newline.
+    void status(std::string_view line, bool last = false);
+
 private:
     Logger() = default;
 
@@ -53,6 +57,8 @@ private:
 
     mutable std::mutex _mutex;
     std::atomic<LogLevel> _level{LogLevel::Info};
+    // Width of the status line currently on screen.
+    std::size_t _status_width{0};
 };
 
 #define LOG_LOGGER_CALL(level, role, fmt, ...)                                                   \
@@ -71,6 +77,11 @@ protected:
         Logger::instance().log(level, reinterpret_cast<const T*>(this)->name(), fmt, std::forward<Args>(args)...);
     }
 
+    template <typename... Args>
+    void log_debug(std::format_string<Args...> fmt, Args &&...args) const {
+        log(LogLevel::Debug, fmt, std::forward<Args>(args)...);
+    }
+
     template <typename... Args>
     void log_info(std::format_string<Args...> fmt, Args &&...args) const {
         log(LogLevel::Info, fmt, std::forward<Args>(args)...);
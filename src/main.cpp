@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
 #include <fstream>
+#include <iterator>
+#include <iostream>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -10,10 +15,17 @@
 #include <nlohmann/json.hpp>
 
 #include "algorithm/algorithm_base.hpp"
+#include "baseline.hpp"
 #include "dataset_loader/dataset_loader_base.hpp"
+#include "memory_budget.hpp"
 #include "metric/metric_base.hpp"
 #include "pcl/console/print.h"
 #include "process.h"
+#include "result_store.hpp"
+#include "registration_engine.hpp"
+#include "server/registration_server.hpp"
+#include "streaming.hpp"
+#include "sweep.hpp"
 #include "logger.hpp"
 
 namespace {
@@ -46,6 +58,80 @@ bool validate_config(const nlohmann::json &config) {
     return true;
 }
 
+// Logs the memory saved by compact storage and the worst quantization error,
+// warning when it reaches a tenth of a metric's distance tolerance.
+void report_quantization(const std::vector<Sample> &samples,
+                         const std::vector<std::shared_ptr<MetricBase>> &metrics) {
+    std::size_t points = 0;
+    std::size_t bytes = 0;
+    double error = 0.0;
+    for (const auto &sample : samples) {
+        for (const auto &cloud : sample.compact_clouds) {
+            points += cloud.size();
+            bytes += cloud.memory_bytes();
+        }
+        error = std::max(error, sample.quantization_error());
+    }
+    const auto full_bytes = points * sizeof(pcl::PointXYZ);
+    LOG_INFO(ROLE_MAIN, "Compact storage: {:.1f} MiB for {:.1f} MiB of clouds ({:.2f}x) plus decoded copies "
+             "of the samples in flight, max quantization error {:.3g} m",
+             static_cast<double>(bytes) / (1 << 20), static_cast<double>(full_bytes) / (1 << 20),
+             bytes > 0 ? static_cast<double>(full_bytes) / static_cast<double>(bytes) : 1.0, error);
+    for (const auto &metric : metrics) {
+        const auto tolerance = metric->distance_tolerance();
+        if (tolerance <= 0.0) {
+            continue;
+        }
+        if (error > 0.1 * tolerance) {
+            LOG_WARN(ROLE_MAIN, "Quantization error {:.3g} m is {:.1f}% of the '{}' tolerance of {} m",
+                     error, 100.0 * error / tolerance, metric->name(), tolerance);
+        } else {
+            LOG_INFO(ROLE_MAIN, "Quantization error is {:.2f}% of the '{}' tolerance of {} m",
+                     100.0 * error / tolerance, metric->name(), tolerance);
+        }
+    }
+}
+
+// `--query`: aggregates or exports a results store; needs no config.
+int run_query(const cxxopts::ParseResult &parsed_options) {
+    const auto store_path = parsed_options["query"].as<std::string>();
+    std::ofstream output_file;
+    if (parsed_options.count("output")) {
+        output_file.open(parsed_options["output"].as<std::string>());
+        if (!output_file.is_open()) {
+            LOG_ERROR(ROLE_MAIN, "Could not open {}", parsed_options["output"].as<std::string>());
+            return -1;
+        }
+    }
+    std::ostream &out = output_file.is_open() ? output_file : std::cout;
+
+    try {
+        const ResultStoreReader store(store_path);
+        if (parsed_options.count("export-csv")) {
+            std::ofstream csv_file(parsed_options["export-csv"].as<std::string>());
+            if (!csv_file.is_open()) {
+                LOG_ERROR(ROLE_MAIN, "Could not open {}",
+                          parsed_options["export-csv"].as<std::string>());
+                return -1;
+            }
+            export_results_csv(store, csv_file);
+            return 0;
+        }
+
+        ResultQuery query;
+        query.group_by = parsed_options["group-by"].as<std::vector<std::string>>();
+        if (parsed_options.count("values")) {
+            query.values = parsed_options["values"].as<std::vector<std::string>>();
+        }
+        query.percentiles = parsed_options["percentiles"].as<std::vector<double>>();
+        write_query_csv(query_results(store, query), out);
+    } catch (const std::exception &e) {
+        LOG_ERROR(ROLE_MAIN, "Query on {} failed: {}", store_path, e.what());
+        return -1;
+    }
+    return 0;
+}
+
 } // namespace
 
 std::string join_names(const std::vector<std::string> &names) {
@@ -65,6 +151,27 @@ int main(int argc, char **argv) {
     
     options.add_options()("c,config", "Path to config file",
                           cxxopts::value<std::string>()->default_value("config.json"))
+                        ("save-baseline", "Write the run summary to this JSON file",
+                          cxxopts::value<std::string>())
+                        ("baseline", "Compare the run against this run summary; exit code 2 on regression",
+                          cxxopts::value<std::string>())
+                        ("baseline-report", "Write the baseline comparison to this JSON file",
+                          cxxopts::value<std::string>()->default_value(""))
+                        ("stream", "Run online odometry on frames arriving as configured in config.streaming")
+                        ("serve", "Serve registration requests on the Unix socket configured in config.server")
+                        ("query", "Aggregate the results store at this path instead of running; see --group-by",
+                          cxxopts::value<std::string>())
+                        ("group-by", "Columns the query groups rows by",
+                          cxxopts::value<std::vector<std::string>>()->default_value("algorithm"))
+                        ("values", "Numeric columns the query summarizes (default: all others)",
+                          cxxopts::value<std::vector<std::string>>())
+                        ("percentiles", "Percentiles the query reports",
+                          cxxopts::value<std::vector<double>>()->default_value("50,90,99"))
+                        ("export-csv", "With --query, write the whole store as CSV instead of aggregating",
+                          cxxopts::value<std::string>())
+                        ("o,output", "With --query, write the CSV here instead of to stdout",
+                          cxxopts::value<std::string>())
+                        ("build-manifest", "Index the configured dataset for fast startup instead of running")
                         ("h,help", "Print help");
     
     auto parsed_options = options.parse(argc, argv);
@@ -73,6 +180,10 @@ int main(int argc, char **argv) {
         return 0;
     }
     
+    if (parsed_options.count("query")) {
+        return run_query(parsed_options);
+    }
+
     auto config_path = parsed_options["config"].as<std::string>();
 
 
@@ -92,29 +203,69 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    if (parsed_options.count("stream")) {
+        try {
+            const auto options = StreamingOptions::from_json(
+                config.value("streaming", nlohmann::json::object()));
+            run_streaming(options);
+            return 0;
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Streaming failed: {}", e.what());
+            return -1;
+        }
+    }
+
+    if (parsed_options.count("serve")) {
+        try {
+            run_server(config);
+            return 0;
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Server failed: {}", e.what());
+            return -1;
+        }
+    }
+
+    if (parsed_options.count("build-manifest")) {
+        try {
+            const auto loader =
+                create_dataset_loader(config.value("dataset_loader", nlohmann::json::object()));
+            loader->build_manifest();
+            return 0;
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Building the dataset manifest failed: {}", e.what());
+            return -1;
+        }
+    }
+
     if (!validate_config(config)) {
         return -1;
     }
     LOG_INFO(ROLE_MAIN, "Configuration validated");
 
-    std::vector<std::shared_ptr<AlgorithmBase>> algorithms;
-    algorithms.reserve(config["algorithms"].size());
-
+    std::vector<AlgorithmVariant> variants;
     for (const auto &algorithm_config : config["algorithms"]) {
-        if (!algorithm_config.contains("name") ||
-            !algorithm_config["name"].is_string()) {
-            LOG_ERROR(ROLE_MAIN, "Each algorithm config must have a string 'name'");
+        try {
+            auto expanded = expand_sweep(algorithm_config);
+            variants.insert(variants.end(), std::make_move_iterator(expanded.begin()),
+                            std::make_move_iterator(expanded.end()));
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Invalid algorithm sweep: {}", e.what());
             return -1;
         }
+    }
+
+    std::vector<std::shared_ptr<AlgorithmBase>> algorithms;
+    algorithms.reserve(variants.size());
 
-        const auto algorithm_name = algorithm_config["name"].get<std::string>();
+    for (const auto &variant : variants) {
         try {
-            auto algorithm =
-                algorithmManager.create(algorithm_name, algorithm_config);
-            algorithms.emplace_back(std::move(algorithm));
-            LOG_INFO(ROLE_MAIN, "Initialized algorithm '{}'", algorithm_name);
+            algorithms.emplace_back(create_algorithm(variant.config));
+            if (!variant.label.empty()) {
+                algorithms.back()->set_label(variant.label);
+            }
+            LOG_INFO(ROLE_MAIN, "Initialized algorithm '{}'", algorithms.back()->label());
         } catch (const std::exception &e) {
-            LOG_ERROR(ROLE_MAIN, "Error creating algorithm '{}': {}", algorithm_name, e.what());
+            LOG_ERROR(ROLE_MAIN, "Error creating algorithm: {}", e.what());
             return -1;
         }
     }
@@ -123,26 +274,18 @@ int main(int argc, char **argv) {
     metrics.reserve(config["metrics"].size());
 
     for (const auto &metric_config : config["metrics"]) {
-        if (!metric_config.contains("name") || !metric_config["name"].is_string()) {
-            LOG_ERROR(ROLE_MAIN, "Each metric config must have a string 'name'");
-            return -1;
-        }
-
-        const auto metric_name = metric_config["name"].get<std::string>();
         try {
-            auto metric = metricManager.create(metric_name, metric_config);
-            metrics.emplace_back(std::move(metric));
-            LOG_INFO(ROLE_MAIN, "Initialized metric '{}'", metric_name);
+            metrics.emplace_back(create_metric(metric_config));
+            LOG_INFO(ROLE_MAIN, "Initialized metric '{}'", metrics.back()->name());
         } catch (const std::exception &e) {
-            LOG_ERROR(ROLE_MAIN, "Error creating metric '{}': {}", metric_name, e.what());
+            LOG_ERROR(ROLE_MAIN, "Error creating metric: {}", e.what());
             return -1;
         }
     }
 
     std::shared_ptr<DatasetLoaderBase> dataset_loader;
     try {
-        dataset_loader = datasetLoaderManager.create(
-            config["dataset_loader"]["name"], config["dataset_loader"]);
+        dataset_loader = create_dataset_loader(config["dataset_loader"]);
         LOG_INFO(ROLE_MAIN, "Dataset loader '{}' ready",
                  config["dataset_loader"]["name"].get<std::string>());
     } catch (const std::exception &e) {
@@ -151,10 +294,16 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    // Results are keyed by label, so two entries reporting under the same one
+    // would overwrite each other.
     std::vector<std::string> algorithm_names;
     algorithm_names.reserve(algorithms.size());
     for (const auto &algorithm : algorithms) {
-        algorithm_names.emplace_back(algorithm->name());
+        algorithm_names.emplace_back(algorithm->label());
+    }
+    make_labels_unique(algorithm_names);
+    for (std::size_t idx = 0; idx < algorithms.size(); ++idx) {
+        algorithms[idx]->set_label(algorithm_names[idx]);
     }
 
     std::vector<std::string> metric_names;
@@ -175,19 +324,13 @@ int main(int argc, char **argv) {
     LOG_INFO(ROLE_MAIN, "Algorithms: {}", join_names(algorithm_names));
     LOG_INFO(ROLE_MAIN, "Metrics: {}", join_names(metric_names));
 
-    std::size_t thread_count_hint = 0;
+    RunnerOptions runner_options;
     if (config.contains("runner") && config["runner"].is_object()) {
-        const auto &runner_config = config["runner"];
-        if (runner_config.contains("threads")) {
-            const auto &threads_value = runner_config["threads"];
-            if (threads_value.is_number_unsigned()) {
-                thread_count_hint = threads_value.get<std::size_t>();
-            } else if (threads_value.is_number_integer()) {
-                const auto threads_signed = threads_value.get<long long>();
-                if (threads_signed > 0) {
-                    thread_count_hint = static_cast<std::size_t>(threads_signed);
-                }
-            }
+        try {
+            runner_options = RunnerOptions::from_json(config["runner"]);
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Invalid runner config: {}", e.what());
+            return -1;
         }
     }
 
@@ -195,20 +338,85 @@ int main(int argc, char **argv) {
     if (default_threads == 0) {
         default_threads = 1;
     }
-    const std::size_t effective_threads =
-        thread_count_hint > 0 ? thread_count_hint : default_threads;
-    LOG_INFO(ROLE_MAIN, "Threads: {}", effective_threads);
-
-    const auto samples = dataset_loader->load_samples();
+    if (runner_options.threads == 0) {
+        runner_options.threads = default_threads;
+    }
+    LOG_INFO(ROLE_MAIN, "Threads: {}", runner_options.threads);
+
+    // Admission reads fragments on demand, so loaders that know their sizes
+    // read none up front and a sample's fragments are only read once its
+    // tasks are scheduled. With a budget, fragments beyond it are also
+    // released as samples finish loading; without one nothing is evicted.
+    auto memory_options = runner_options.memory;
+    if (memory_options.budget_bytes == 0) {
+        memory_options.budget_bytes = MemoryBudget::unbounded;
+    }
+    auto memory_budget = std::make_unique<MemoryBudget>(memory_options);
+    dataset_loader->set_sample_hook(
+        [budget = memory_budget.get()](Sample &sample) { budget->on_sample_loaded(sample); });
+    dataset_loader->set_deferred_loading(true);
+
+    auto samples = dataset_loader->load_samples();
+    place_samples(samples, runner_options);
+    memory_budget->attach(samples);
     std::size_t total_point_clouds = 0;
     for (const auto &sample : samples) {
-        total_point_clouds += sample.point_clouds.size();
+        total_point_clouds += sample.fragment_count();
     }
     LOG_INFO(ROLE_MAIN, "Loaded {} samples totaling {} point clouds",
              samples.size(), total_point_clouds);
+    if (dataset_loader->compact_bits() > 0) {
+        report_quantization(samples, metrics);
+    }
+    // Rows appended to the results store are tagged with the run's start.
+    if (runner_options.run.empty()) {
+        runner_options.run = std::format(
+            "{:%FT%TZ}", std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
+    }
+    AlgorithmTimings timings;
     const auto results =
-        run_evaluation(algorithms, samples, metrics, effective_threads);
+        run_evaluation(algorithms, samples, metrics, runner_options, &timings, memory_budget.get());
     write_results_to_csv(results, metrics);
+    write_combined_results(runner_options.results_path, results, algorithm_names, variants, metrics);
+    if (!runner_options.results_store.empty()) {
+        try {
+            write_results_store(runner_options.results_store, runner_options.run, results, timings,
+                                algorithm_names, variants, metrics);
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Failed to write results store {}: {}",
+                      runner_options.results_store, e.what());
+        }
+    }
+
+    const auto summary = summarize_run(results, timings, metrics);
+    if (parsed_options.count("save-baseline")) {
+        try {
+            save_run_summary(summary, parsed_options["save-baseline"].as<std::string>());
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Failed to save baseline: {}", e.what());
+            return -1;
+        }
+    }
+
+    if (parsed_options.count("baseline")) {
+        const auto baseline_path = parsed_options["baseline"].as<std::string>();
+        BaselineTolerances tolerances;
+        if (config.contains("baseline") && config["baseline"].is_object()) {
+            tolerances = BaselineTolerances::from_json(config["baseline"]);
+        }
+
+        BaselineReport report;
+        try {
+            report = compare_to_baseline(summary, load_run_summary(baseline_path), tolerances);
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_MAIN, "Failed to load baseline {}: {}", baseline_path, e.what());
+            return -1;
+        }
+        write_baseline_report(report, parsed_options["baseline-report"].as<std::string>());
+        if (report.regressed) {
+            return 2;
+        }
+    }
 
     LOG_INFO(ROLE_MAIN, "Evaluation completed successfully");
 
@@ -0,0 +1,95 @@
+#include "mapped_file.hpp"
+#include "logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::string_view ROLE_MAPPED_FILE{"mapped_file"};
+} // namespace
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+#if !defined(_WIN32)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open file: " + path.string());
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Failed to stat file: " + path.string());
+  }
+
+  _size = static_cast<std::size_t>(info.st_size);
+  if (_size > 0) {
+    void *address = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Failed to map file: " + path.string());
+    }
+    // Advice values are not flags, so each takes its own call. Both are
+    // hints: a kernel that rejects one still maps the file correctly.
+    for (const int advice : {MADV_SEQUENTIAL, MADV_WILLNEED}) {
+      if (::madvise(address, _size, advice) != 0) {
+        LOG_DEBUG(ROLE_MAPPED_FILE, "madvise({}) failed on {}: {}", advice,
+                  path.string(), std::strerror(errno));
+      }
+    }
+    _data = static_cast<const char *>(address);
+    _mapped = true;
+  }
+  ::close(fd);
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) {
+    throw std::runtime_error("Failed to open file: " + path.string());
+  }
+  _buffer.resize(static_cast<std::size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+  _data = _buffer.data();
+  _size = _buffer.size();
+#endif
+}
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : _data(std::exchange(other._data, nullptr)),
+      _size(std::exchange(other._size, 0)),
+      _mapped(std::exchange(other._mapped, false)),
+      _buffer(std::move(other._buffer)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    release();
+    _data = std::exchange(other._data, nullptr);
+    _size = std::exchange(other._size, 0);
+    _mapped = std::exchange(other._mapped, false);
+    _buffer = std::move(other._buffer);
+  }
+  return *this;
+}
+
+void MappedFile::release() {
+#if !defined(_WIN32)
+  if (_mapped && _data != nullptr) {
+    ::munmap(const_cast<char *>(_data), _size);
+  }
+#endif
+  _data = nullptr;
+  _size = 0;
+  _mapped = false;
+  _buffer.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Read-only view of a whole file. Uses mmap on POSIX systems and falls back to
+// reading the file into memory elsewhere.
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  const char *data() const { return _data; }
+  std::size_t size() const { return _size; }
+  std::string_view view() const { return {_data, _size}; }
+
+private:
+  void release();
+
+  const char *_data{nullptr};
+  std::size_t _size{0};
+  bool _mapped{false};
+  std::vector<char> _buffer;
+};
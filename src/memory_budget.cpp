@@ -0,0 +1,427 @@
+#include "memory_budget.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr std::string_view ROLE_MEMORY{"memory"};
+
+double mebibytes(std::size_t bytes) {
+    return static_cast<double>(bytes) / (1 << 20);
+}
+
+long process_id() {
+#if defined(__unix__)
+    return static_cast<long>(::getpid());
+#else
+    return 0;
+#endif
+}
+
+void write_spill_file(const fs::path &path, const PointCloud &cloud) {
+    std::ofstream out(path, std::ios::binary);
+    for (const auto &point : cloud.points) {
+        const float xyz[3] = {point.x, point.y, point.z};
+        out.write(reinterpret_cast<const char *>(xyz), sizeof(xyz));
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write spill file " + path.string());
+    }
+}
+
+PointCloud read_spill_file(const fs::path &path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open spill file " + path.string());
+    }
+    const auto bytes = static_cast<std::size_t>(in.tellg());
+    in.seekg(0);
+    PointCloud cloud;
+    cloud.resize(bytes / (3 * sizeof(float)));
+    for (auto &point : cloud.points) {
+        float xyz[3];
+        in.read(reinterpret_cast<char *>(xyz), sizeof(xyz));
+        point = pcl::PointXYZ(xyz[0], xyz[1], xyz[2]);
+    }
+    if (!in) {
+        throw std::runtime_error("Truncated spill file " + path.string());
+    }
+    return cloud;
+}
+} // namespace
+
+std::size_t parse_byte_size(const std::string &text) {
+    std::size_t consumed = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &consumed);
+    } catch (const std::exception &) {
+        throw std::invalid_argument("Invalid byte size '" + text + "'");
+    }
+    std::string unit;
+    for (const auto c : text.substr(consumed)) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            unit += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+    }
+    if (unit.ends_with("IB")) {
+        unit.erase(unit.size() - 2);
+    } else if (unit.size() > 1 && unit.ends_with('B')) {
+        unit.pop_back();
+    }
+
+    double scale = 1.0;
+    if (unit == "K") {
+        scale = 1024.0;
+    } else if (unit == "M") {
+        scale = 1024.0 * 1024.0;
+    } else if (unit == "G") {
+        scale = 1024.0 * 1024.0 * 1024.0;
+    } else if (unit == "T") {
+        scale = 1024.0 * 1024.0 * 1024.0 * 1024.0;
+    } else if (!unit.empty() && unit != "B") {
+        throw std::invalid_argument("Unknown unit in byte size '" + text + "'");
+    }
+    if (!(value >= 0.0) || value * scale >= static_cast<double>(std::numeric_limits<std::size_t>::max())) {
+        throw std::invalid_argument("Byte size out of range: '" + text + "'");
+    }
+    return static_cast<std::size_t>(std::llround(value * scale));
+}
+
+MemoryBudget::Lease::Lease(Lease &&other) noexcept { *this = std::move(other); }
+
+MemoryBudget::Lease &MemoryBudget::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        release();
+        _budget = std::exchange(other._budget, nullptr);
+        _sample = other._sample;
+        _fragments = std::move(other._fragments);
+        _task_bytes = other._task_bytes;
+        _wait_seconds = other._wait_seconds;
+    }
+    return *this;
+}
+
+MemoryBudget::Lease::~Lease() { release(); }
+
+void MemoryBudget::Lease::release() {
+    if (_budget != nullptr) {
+        std::exchange(_budget, nullptr)->finish(*this);
+    }
+}
+
+MemoryBudget::MemoryBudget(Options options) : _options(std::move(options)) {
+    if (_options.budget_bytes == 0) {
+        throw std::invalid_argument("MemoryBudget needs a non-zero budget");
+    }
+}
+
+std::size_t MemoryBudget::fragment_bytes(const Sample &sample, std::size_t fragment) const {
+    const auto points = sample.point_count(fragment);
+    std::size_t stored = points * sizeof(pcl::PointXYZ);
+    if (sample.compact_bits > 0) {
+        // The encoded cloud, plus the decoded one fragment() caches.
+        stored = points * (sample.compact_bits <= 10 ? 4 : 6) + points * sizeof(pcl::PointXYZ);
+    }
+    return stored + points * _options.cache_bytes_per_point;
+}
+
+std::size_t MemoryBudget::task_bytes(std::size_t sample_idx,
+                                     const std::vector<std::size_t> &fragments) const {
+    std::size_t bytes = 0;
+    for (const auto fragment : fragments) {
+        bytes += _fragments[sample_idx].at(fragment).points * _options.task_bytes_per_point;
+    }
+    return bytes;
+}
+
+void MemoryBudget::spill(Sample &sample) {
+    if (!_spill_root) {
+        const auto base = _options.spill_dir.empty() ? fs::temp_directory_path() : _options.spill_dir;
+        const auto root = base / std::format("registration-spill-{}", process_id());
+        fs::create_directories(root);
+        // Samples keep the directory alive through their reload source, and
+        // the last one to go removes it.
+        _spill_root = std::shared_ptr<const fs::path>(new fs::path(root), [](const fs::path *path) {
+            std::error_code error;
+            fs::remove_all(*path, error);
+            delete path;
+        });
+        LOG_INFO(ROLE_MEMORY, "Spilling generated fragments to {}", root.string());
+    }
+
+    // Compact fragments are written decoded and re-encoded on reload, which
+    // lands on the grid they were decoded from.
+    const auto sample_id = _spilled_samples++;
+    // Decoded here rather than through fragment(), which would keep every
+    // decoded cloud in the sample's cache.
+    for (std::size_t fragment = 0; fragment < sample.fragment_count(); ++fragment) {
+        const auto path = *_spill_root / std::format("{}-{}.xyz", sample_id, fragment);
+        if (sample.compact_clouds.empty()) {
+            write_spill_file(path, sample.point_clouds[fragment]);
+        } else {
+            write_spill_file(path, sample.compact_clouds[fragment].decode());
+        }
+    }
+    _stats.spilled_fragments += sample.fragment_count();
+    sample.reload = [root = _spill_root, sample_id](std::size_t fragment) {
+        return read_spill_file(*root / std::format("{}-{}.xyz", sample_id, fragment));
+    };
+}
+
+void MemoryBudget::release_fragment(Sample &sample, std::size_t fragment) {
+    if (!sample.reload) {
+        spill(sample);
+    }
+    sample.release(fragment);
+    ++_stats.evictions;
+}
+
+void MemoryBudget::on_sample_loaded(Sample &sample) {
+    std::scoped_lock lock(_mutex);
+    // Deferred fragments (Sample::defer) are not loaded yet and cost nothing.
+    std::size_t bytes = 0;
+    for (std::size_t fragment = 0; fragment < sample.fragment_count(); ++fragment) {
+        if (!sample.is_released(fragment)) {
+            bytes += fragment_bytes(sample, fragment);
+        }
+    }
+    if (_loaded_bytes + bytes <= _options.budget_bytes) {
+        _loaded_bytes += bytes;
+        return;
+    }
+    for (std::size_t fragment = 0; fragment < sample.fragment_count(); ++fragment) {
+        if (!sample.is_released(fragment)) {
+            release_fragment(sample, fragment);
+        }
+    }
+}
+
+void MemoryBudget::attach(std::vector<Sample> &samples) {
+    std::scoped_lock lock(_mutex);
+    _samples = &samples;
+    _fragments.assign(samples.size(), {});
+    _loaded_bytes = 0;
+    std::size_t released = 0;
+    for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
+        auto &sample = samples[sample_idx];
+        sample.track_residency();
+        auto &states = _fragments[sample_idx];
+        states.resize(sample.fragment_count());
+        for (std::size_t fragment = 0; fragment < states.size(); ++fragment) {
+            states[fragment].points = sample.point_count(fragment);
+            states[fragment].bytes = fragment_bytes(sample, fragment);
+            states[fragment].loaded = !sample.is_released(fragment);
+            if (states[fragment].loaded) {
+                _loaded_bytes += states[fragment].bytes;
+            } else {
+                ++released;
+            }
+        }
+    }
+    while (_loaded_bytes > _options.budget_bytes && evict_one(samples.size(), {})) {
+        ++released;
+    }
+    _stats.peak_bytes = std::max(_stats.peak_bytes, _loaded_bytes);
+    if (bounded()) {
+        LOG_INFO(ROLE_MEMORY, "Memory budget {:.1f} MiB: {:.1f} MiB of fragments loaded, {} fragment(s) released",
+                 mebibytes(_options.budget_bytes), mebibytes(_loaded_bytes), released);
+    } else {
+        LOG_INFO(ROLE_MEMORY, "{:.1f} MiB of fragments loaded, {} fragment(s) read when first needed",
+                 mebibytes(_loaded_bytes), released);
+    }
+}
+
+bool MemoryBudget::evict_one(std::size_t keep_sample, const std::vector<std::size_t> &keep) {
+    std::size_t best_sample = 0;
+    std::size_t best_fragment = 0;
+    FragmentState *best = nullptr;
+    for (std::size_t sample_idx = 0; sample_idx < _fragments.size(); ++sample_idx) {
+        auto &states = _fragments[sample_idx];
+        for (std::size_t fragment = 0; fragment < states.size(); ++fragment) {
+            auto &state = states[fragment];
+            if (state.loaded && state.pins == 0 &&
+                (best == nullptr || state.last_use < best->last_use) &&
+                !(sample_idx == keep_sample &&
+                  std::binary_search(keep.begin(), keep.end(), fragment))) {
+                best = &state;
+                best_sample = sample_idx;
+                best_fragment = fragment;
+            }
+        }
+    }
+    if (best == nullptr) {
+        return false;
+    }
+    // Spilling a sample writes it out under the lock; that happens once per
+    // generated sample, later evictions only drop the cloud.
+    release_fragment((*_samples)[best_sample], best_fragment);
+    best->loaded = false;
+    _loaded_bytes -= best->bytes;
+    return true;
+}
+
+MemoryBudget::Lease MemoryBudget::admit(std::size_t sample_idx, std::vector<std::size_t> fragments) {
+    if (_samples == nullptr) {
+        throw std::logic_error("MemoryBudget::admit called before attach");
+    }
+    std::sort(fragments.begin(), fragments.end());
+    fragments.erase(std::unique(fragments.begin(), fragments.end()), fragments.end());
+
+    auto &sample = (*_samples)[sample_idx];
+    auto &states = _fragments.at(sample_idx);
+    const auto start = Clock::now();
+    const auto needed_task_bytes = task_bytes(sample_idx, fragments);
+
+    Lease lease;
+    std::vector<std::size_t> to_load;
+    bool waited = false;
+    {
+        std::unique_lock lock(_mutex);
+        while (true) {
+            std::size_t missing = 0;
+            for (const auto fragment : fragments) {
+                const auto &state = states[fragment];
+                missing += state.loaded || state.loading ? 0 : state.bytes;
+            }
+            if (_loaded_bytes + _task_bytes + missing + needed_task_bytes <= _options.budget_bytes) {
+                break;
+            }
+            if (evict_one(sample_idx, fragments)) {
+                continue;
+            }
+            if (_running == 0) {
+                if (_stats.oversized_tasks++ == 0) {
+                    LOG_WARN(ROLE_MEMORY, "A task on sample index {} needs {:.1f} MiB, more than the {:.1f} MiB budget; "
+                             "tasks like it run alone", sample_idx, mebibytes(missing + needed_task_bytes),
+                             mebibytes(_options.budget_bytes));
+                }
+                break;
+            }
+            waited = true;
+            _changed.wait(lock);
+        }
+
+        for (const auto fragment : fragments) {
+            auto &state = states[fragment];
+            ++state.pins;
+            if (!state.loaded && !state.loading) {
+                state.loading = true;
+                _loaded_bytes += state.bytes;
+                to_load.emplace_back(fragment);
+            }
+        }
+        lease._budget = this;
+        lease._sample = sample_idx;
+        lease._fragments = fragments;
+        lease._task_bytes = needed_task_bytes;
+        _task_bytes += needed_task_bytes;
+        ++_running;
+        ++_stats.tasks;
+        _stats.peak_bytes = std::max(_stats.peak_bytes, _loaded_bytes + _task_bytes);
+        if (waited) {
+            lease._wait_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            ++_stats.waited_tasks;
+            _stats.wait_seconds += lease._wait_seconds;
+        }
+    }
+
+    // Fragments are read outside the lock; pinned and not loaded, nobody else
+    // touches them meanwhile.
+    while (true) {
+        for (std::size_t idx = 0; idx < to_load.size(); ++idx) {
+            const auto fragment = to_load[idx];
+            try {
+                sample.restore(fragment);
+            } catch (...) {
+                // Hands back this fragment and every one not read yet, so
+                // that other tasks can claim and retry them.
+                std::scoped_lock lock(_mutex);
+                for (auto pending = idx; pending < to_load.size(); ++pending) {
+                    states[to_load[pending]].loading = false;
+                    _loaded_bytes -= states[to_load[pending]].bytes;
+                }
+                _changed.notify_all();
+                throw;
+            }
+            std::scoped_lock lock(_mutex);
+            states[fragment].loading = false;
+            states[fragment].loaded = true;
+            ++_stats.reloads;
+            _changed.notify_all();
+        }
+        to_load.clear();
+
+        // Waits for fragments other tasks are loading; one whose load failed
+        // is claimed and retried here.
+        std::unique_lock lock(_mutex);
+        _changed.wait(lock, [&]() {
+            return std::none_of(fragments.begin(), fragments.end(),
+                                [&](std::size_t fragment) { return states[fragment].loading; });
+        });
+        for (const auto fragment : fragments) {
+            auto &state = states[fragment];
+            if (!state.loaded) {
+                state.loading = true;
+                _loaded_bytes += state.bytes;
+                to_load.emplace_back(fragment);
+            }
+        }
+        if (to_load.empty()) {
+            break;
+        }
+    }
+    return lease;
+}
+
+void MemoryBudget::retire(std::size_t sample_idx) {
+    if (_samples == nullptr) {
+        throw std::logic_error("MemoryBudget::retire called before attach");
+    }
+    std::scoped_lock lock(_mutex);
+    auto &sample = (*_samples)[sample_idx];
+    if (!sample.reload) {
+        // Only spilling would bring such a sample back.
+        return;
+    }
+    auto &states = _fragments.at(sample_idx);
+    for (std::size_t fragment = 0; fragment < states.size(); ++fragment) {
+        auto &state = states[fragment];
+        if (state.loaded && state.pins == 0) {
+            release_fragment(sample, fragment);
+            state.loaded = false;
+            _loaded_bytes -= state.bytes;
+        }
+    }
+}
+
+void MemoryBudget::finish(Lease &lease) {
+    std::scoped_lock lock(_mutex);
+    auto &states = _fragments[lease._sample];
+    for (const auto fragment : lease._fragments) {
+        --states[fragment].pins;
+        states[fragment].last_use = ++_tick;
+    }
+    _task_bytes -= lease._task_bytes;
+    --_running;
+    _changed.notify_all();
+}
+
+MemoryBudget::Stats MemoryBudget::stats() const {
+    std::scoped_lock lock(_mutex);
+    return _stats;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "dataset_loader/dataset_loader_base.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Parses a byte count: a plain number, or one with a K, M, G or T suffix
+// (binary multiples; "KiB", "MB", "G" and the like are all accepted).
+std::size_t parse_byte_size(const std::string &text);
+
+// Admission control that keeps the estimated memory of the loaded fragments,
+// their derived data and the running tasks under a fixed budget.
+//
+// Footprints are estimated from point counts: a loaded fragment costs its
+// stored cloud (and the decoded copy of a compact one) plus
+// `cache_bytes_per_point` for the search structures and normals the
+// algorithms derive from it, and a running task additionally needs
+// `task_bytes_per_point` for every point of the fragments it touches. A task is only admitted once its
+// fragments are loaded and everything fits; to make room, fragments no
+// running task uses are released, least recently used first, and reloaded
+// from the dataset (or from a scratch spill file for generated samples) when
+// needed again. A task that does not fit even on its own is admitted once
+// nothing else is running, so an undersized budget degrades to serial
+// execution instead of stalling. With an `unbounded` budget nothing is
+// evicted, and the object only reads deferred fragments when a task needs
+// them and drops them again through retire().
+class MemoryBudget {
+public:
+    static constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+    struct Options {
+        std::size_t budget_bytes{0};
+        std::size_t cache_bytes_per_point{64};
+        std::size_t task_bytes_per_point{64};
+        // Where samples without a reload source are spilled; empty uses the
+        // system temporary directory.
+        std::filesystem::path spill_dir;
+    };
+
+    struct Stats {
+        std::size_t tasks{0};
+        // Tasks that had to wait for memory, and for how long in total.
+        std::size_t waited_tasks{0};
+        double wait_seconds{0.0};
+        std::size_t evictions{0};
+        std::size_t reloads{0};
+        std::size_t spilled_fragments{0};
+        // Tasks admitted over budget because they did not fit on their own.
+        std::size_t oversized_tasks{0};
+        std::size_t peak_bytes{0};
+    };
+
+    // Keeps `fragments` of one sample loaded while the task holding it runs.
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+
+        // Seconds the task waited for memory before it was admitted.
+        double wait_seconds() const { return _wait_seconds; }
+
+    private:
+        friend class MemoryBudget;
+        void release();
+
+        MemoryBudget *_budget{nullptr};
+        std::size_t _sample{0};
+        std::vector<std::size_t> _fragments;
+        std::size_t _task_bytes{0};
+        double _wait_seconds{0.0};
+    };
+
+    explicit MemoryBudget(Options options);
+    MemoryBudget(const MemoryBudget &) = delete;
+    MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+    const Options &options() const { return _options; }
+    bool bounded() const { return _options.budget_bytes != unbounded; }
+
+    // Loader hook (DatasetLoaderBase::set_sample_hook): once the samples
+    // loaded so far fill the budget, releases the fragments of every further
+    // sample as soon as it is complete, so loading stays under budget too.
+    void on_sample_loaded(Sample &sample);
+
+    // Starts tracking `samples` for admit(). They must stay at their address
+    // and are only released or restored through this object from now on.
+    void attach(std::vector<Sample> &samples);
+
+    // Blocks until `fragments` of sample `sample` are loaded and the task fits
+    // the budget, then pins them for the lifetime of the returned lease.
+    Lease admit(std::size_t sample, std::vector<std::size_t> fragments);
+
+    // Releases the loaded fragments of sample `sample` that no lease pins and
+    // that can be read again from the dataset, once the caller is done with
+    // the sample.
+    void retire(std::size_t sample);
+
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct FragmentState {
+        std::size_t points{0};
+        std::size_t bytes{0};
+        std::size_t pins{0};
+        bool loaded{false};
+        bool loading{false};
+        std::uint64_t last_use{0};
+    };
+
+    std::size_t fragment_bytes(const Sample &sample, std::size_t fragment) const;
+    std::size_t task_bytes(std::size_t sample_idx, const std::vector<std::size_t> &fragments) const;
+    // Releases the least recently used unpinned fragment other than `keep`
+    // (sorted) of sample `keep_sample`; false when there is none. Called with
+    // `_mutex` held.
+    bool evict_one(std::size_t keep_sample, const std::vector<std::size_t> &keep);
+    void release_fragment(Sample &sample, std::size_t fragment);
+    // Gives `sample` a reload source backed by a scratch file per fragment.
+    void spill(Sample &sample);
+    void finish(Lease &lease);
+
+    Options _options;
+    std::vector<Sample> *_samples{nullptr};
+    std::vector<std::vector<FragmentState>> _fragments;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _changed;
+    std::size_t _loaded_bytes{0};
+    std::size_t _task_bytes{0};
+    std::size_t _running{0};
+    std::uint64_t _tick{0};
+    std::shared_ptr<const std::filesystem::path> _spill_root;
+    std::size_t _spilled_samples{0};
+    Stats _stats;
+};
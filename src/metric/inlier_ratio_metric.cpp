@@ -0,0 +1,62 @@
+#include "metric/inlier_ratio_metric.hpp"
+
+#include "algorithm/voxel_hash_correspondence.hpp"
+#include "algorithm/voxel_hash_index.hpp"
+#include "dataset_loader/dataset_loader_base.hpp"
+#include <cmath>
+#include <stdexcept>
+
+REGISTER_METRIC(inlier_ratio, InlierRatioMetric);
+
+InlierRatioMetric::InlierRatioMetric(const nlohmann::json &config)
+    : _settings(PointMetricSettings::from_json(config)) {
+  _inlier_threshold = config.value("inlier_threshold", _inlier_threshold);
+  if (!(_inlier_threshold > 0.0f)) {
+    throw std::invalid_argument("inlier_threshold must be positive");
+  }
+}
+
+double InlierRatioMetric::evaluate(const std::vector<TransMat> &,
+                                   const std::vector<TransMat> &) {
+  throw std::logic_error("inlier_ratio needs the sample's clouds");
+}
+
+double InlierRatioMetric::evaluate(const std::vector<TransMat> &estimated,
+                                   const std::vector<TransMat> &ground_truth,
+                                   const MetricContext &context) {
+  if (estimated.size() != ground_truth.size()) {
+    throw std::invalid_argument(
+        "InlierRatioMetric: estimated and ground truth transform counts must match");
+  }
+
+  // An index built by voxel-hash ICP with this voxel size is reused.
+  const auto key = CorrespondenceBackend::index_key("cloud", _inlier_threshold);
+  double total = 0.0;
+  std::size_t evaluated = 0;
+  for (const auto &pair : scored_pairs(estimated, ground_truth, context)) {
+    const auto source = context.sample->fragment(pair.source);
+    const auto target = context.sample->fragment(pair.target);
+    const auto index = target.derived<VoxelHashIndex>(key, [this, &target]() {
+      return std::make_shared<VoxelHashIndex>(target.cloud, _inlier_threshold);
+    });
+
+    std::size_t count = 0;
+    const auto inliers = count_inliers(source.cloud, pair.estimated, *index, _inlier_threshold,
+                                       _settings.stride(source.cloud.size()), _settings.threads,
+                                       count);
+    if (count > 0) {
+      total += static_cast<double>(inliers) / static_cast<double>(count);
+      ++evaluated;
+    }
+  }
+  return evaluated > 0 ? total / static_cast<double>(evaluated) : 0.0;
+}
+
+std::string InlierRatioMetric::name() const {
+  return "inlier_ratio";
+}
+
+std::shared_ptr<MetricBase>
+InlierRatioMetric::create(const nlohmann::json &config) {
+  return std::make_shared<InlierRatioMetric>(config);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "metric/metric_base.hpp"
+#include "metric/point_metric_kernels.hpp"
+#include <nlohmann/json.hpp>
+
+// Mean over the registered pairs of the fraction of source points that, moved
+// by the estimated transform, have a target point within `inlier_threshold`
+// meters. Target voxel indices come from the sample's fragment cache and are
+// shared with voxel-hash ICP when the sizes match. Needs the clouds.
+class InlierRatioMetric : public MetricBase {
+public:
+  explicit InlierRatioMetric(const nlohmann::json &config);
+
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth) override;
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth,
+                  const MetricContext &context) override;
+
+  std::string name() const override;
+  bool higher_is_better() const override { return true; }
+  double distance_tolerance() const override { return _inlier_threshold; }
+  bool needs_clouds() const override { return true; }
+
+  static std::shared_ptr<MetricBase> create(const nlohmann::json &config);
+
+private:
+  PointMetricSettings _settings;
+  float _inlier_threshold{0.1f};
+};
@@ -8,12 +8,60 @@
 #include <stdexcept>
 #include <vector>
 
+struct Sample;
+
+// What the evaluated transforms refer to. With `pairwise`, transform i is the
+// estimate for `sample->pairs[i]`; otherwise transform i is the pose of
+// fragment i in the frame of fragment 0.
+struct MetricContext {
+  const Sample *sample{nullptr};
+  bool pairwise{false};
+  // Pairs the overlap filter skipped, whose estimate is only the initial
+  // guess: entry i stands for `sample->pairs[i]`, or for fragment i + 1
+  // against fragment i on a trajectory. nullptr when none was skipped.
+  const std::vector<bool> *skipped{nullptr};
+
+  bool is_skipped(std::size_t pair) const {
+    return skipped != nullptr && pair < skipped->size() && (*skipped)[pair];
+  }
+};
+
 class MetricBase {
 public:
   virtual ~MetricBase() = default;
   virtual double evaluate(const std::vector<TransMat>& estimated,
                           const std::vector<TransMat>& ground_truth) = 0;
+  // Entry point used by the runner. Metrics that need the sample's clouds
+  // override this; the default scores the transforms alone, leaving skipped
+  // pairs out. Poses of a trajectory cannot be left out one at a time, so
+  // there every pose is scored and skipped pairs only show in the runner's
+  // log.
+  virtual double evaluate(const std::vector<TransMat>& estimated,
+                          const std::vector<TransMat>& ground_truth,
+                          const MetricContext& context) {
+    if (!context.pairwise || context.skipped == nullptr ||
+        estimated.size() != ground_truth.size()) {
+      return evaluate(estimated, ground_truth);
+    }
+    std::vector<TransMat> scored_estimated;
+    std::vector<TransMat> scored_ground_truth;
+    for (std::size_t idx = 0; idx < estimated.size(); ++idx) {
+      if (!context.is_skipped(idx)) {
+        scored_estimated.emplace_back(estimated[idx]);
+        scored_ground_truth.emplace_back(ground_truth[idx]);
+      }
+    }
+    return evaluate(scored_estimated, scored_ground_truth);
+  }
   virtual std::string name() const = 0;
+  // Direction used when comparing runs; error metrics keep the default.
+  virtual bool higher_is_better() const { return false; }
+  // Translation (meters) below which the metric cannot tell estimates apart;
+  // 0 when it has no such threshold. Used to judge quantization error.
+  virtual double distance_tolerance() const { return 0.0; }
+  // Whether evaluate() reads the sample's clouds, which the runner then has
+  // to keep loaded under a memory budget.
+  virtual bool needs_clouds() const { return false; }
 };
 
 using Metric = MetricBase*;
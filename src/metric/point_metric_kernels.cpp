@@ -0,0 +1,125 @@
+#include "metric/point_metric_kernels.hpp"
+
+#include "affinity.hpp"
+#include "algorithm/voxel_hash_index.hpp"
+#include "dataset_loader/dataset_loader_base.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+std::vector<ScoredPair> scored_pairs(const std::vector<TransMat> &estimated,
+                                     const std::vector<TransMat> &ground_truth,
+                                     const MetricContext &context) {
+  if (context.sample == nullptr) {
+    throw std::invalid_argument("cloud-based metrics need the sample's clouds");
+  }
+  const auto &sample = *context.sample;
+
+  std::vector<ScoredPair> pairs;
+  if (context.pairwise) {
+    pairs.reserve(sample.pairs.size());
+    for (std::size_t idx = 0; idx < sample.pairs.size(); ++idx) {
+      if (context.is_skipped(idx)) {
+        continue;
+      }
+      pairs.push_back({sample.pairs[idx].source, sample.pairs[idx].target, estimated[idx],
+                       ground_truth[idx]});
+    }
+    return pairs;
+  }
+
+  const auto count = std::min(estimated.size(), sample.fragment_count());
+  pairs.reserve(count > 0 ? count - 1 : 0);
+  for (std::size_t idx = 1; idx < count; ++idx) {
+    if (context.is_skipped(idx - 1)) {
+      continue;
+    }
+    pairs.push_back({idx, idx - 1, estimated[idx - 1].inverse() * estimated[idx],
+                     ground_truth[idx - 1].inverse() * ground_truth[idx]});
+  }
+  return pairs;
+}
+
+PointMetricSettings PointMetricSettings::from_json(const nlohmann::json &config) {
+  PointMetricSettings settings;
+  settings.max_points = config.value("max_points", settings.max_points);
+  settings.threads = config.value("threads", settings.threads);
+  return settings;
+}
+
+double squared_displacement_sum(const PointCloud &cloud, const TransMat &estimated,
+                                const TransMat &ground_truth, std::size_t stride,
+                                int threads, std::size_t &count) {
+  // (E - G) p is a single affine map, so each point costs one 3x4 product.
+  const Eigen::Matrix<float, 3, 4> delta = (estimated - ground_truth).topRows<3>();
+  const float d00 = delta(0, 0), d01 = delta(0, 1), d02 = delta(0, 2), d03 = delta(0, 3);
+  const float d10 = delta(1, 0), d11 = delta(1, 1), d12 = delta(1, 2), d13 = delta(1, 3);
+  const float d20 = delta(2, 0), d21 = delta(2, 1), d22 = delta(2, 2), d23 = delta(2, 3);
+
+  const auto *points = cloud.points.data();
+  const auto samples = static_cast<std::ptrdiff_t>((cloud.size() + stride - 1) / stride);
+  const auto step = static_cast<std::ptrdiff_t>(stride);
+  // One thread on runner workers unless `threads` asks for more.
+  [[maybe_unused]] const int team = omp_team_threads(static_cast<unsigned int>(std::max(threads, 0)));
+  double sum = 0.0;
+  std::size_t visited = 0;
+#pragma omp parallel for simd num_threads(team) schedule(static) \
+    reduction(+ : sum, visited)
+  for (std::ptrdiff_t idx = 0; idx < samples; ++idx) {
+    const auto &point = points[idx * step];
+    const float dx = d00 * point.x + d01 * point.y + d02 * point.z + d03;
+    const float dy = d10 * point.x + d11 * point.y + d12 * point.z + d13;
+    const float dz = d20 * point.x + d21 * point.y + d22 * point.z + d23;
+    const float squared = dx * dx + dy * dy + dz * dz;
+    // Non-finite coordinates propagate into `squared`; masking instead of
+    // branching keeps the loop vectorizable.
+    const bool finite = std::isfinite(squared);
+    sum += finite ? static_cast<double>(squared) : 0.0;
+    visited += finite ? 1 : 0;
+  }
+  count = visited;
+  return sum;
+}
+
+double pair_point_rmse(const Sample &sample, const ScoredPair &pair,
+                       const PointMetricSettings &settings) {
+  const auto source = sample.fragment(pair.source);
+  std::size_t count = 0;
+  const double sum = squared_displacement_sum(source.cloud, pair.estimated, pair.ground_truth,
+                                              settings.stride(source.cloud.size()),
+                                              settings.threads, count);
+  return count > 0 ? std::sqrt(sum / static_cast<double>(count))
+                   : std::numeric_limits<double>::quiet_NaN();
+}
+
+std::size_t count_inliers(const PointCloud &cloud, const TransMat &transform,
+                          const VoxelHashIndex &index, float threshold, std::size_t stride,
+                          int threads, std::size_t &count) {
+  const Eigen::Matrix3f rotation = transform.topLeftCorner<3, 3>();
+  const Eigen::Vector3f translation = transform.topRightCorner<3, 1>();
+
+  const auto *points = cloud.points.data();
+  const auto samples = static_cast<std::ptrdiff_t>((cloud.size() + stride - 1) / stride);
+  const auto step = static_cast<std::ptrdiff_t>(stride);
+  [[maybe_unused]] const int team = omp_team_threads(static_cast<unsigned int>(std::max(threads, 0)));
+  std::size_t inliers = 0;
+  std::size_t visited = 0;
+#pragma omp parallel for num_threads(team) schedule(static) \
+    reduction(+ : inliers, visited)
+  for (std::ptrdiff_t idx = 0; idx < samples; ++idx) {
+    const auto &point = points[idx * step];
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+      continue;
+    }
+    const Eigen::Vector3f moved = rotation * point.getVector3fMap() + translation;
+    std::uint32_t match = 0;
+    float squared_distance = 0.0f;
+    if (index.nearest(moved, threshold, match, squared_distance)) {
+      ++inliers;
+    }
+    ++visited;
+  }
+  count = visited;
+  return inliers;
+}
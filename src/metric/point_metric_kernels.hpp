@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.hpp"
+#include "metric/metric_base.hpp"
+#include <Eigen/Core>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+class VoxelHashIndex;
+
+// One registered pair as seen by a cloud-based metric: `estimated` and
+// `ground_truth` map fragment `source` into the frame of fragment `target`.
+struct ScoredPair {
+  std::size_t source{0};
+  std::size_t target{0};
+  TransMat estimated{TransMat::Identity()};
+  TransMat ground_truth{TransMat::Identity()};
+};
+
+// The pairs behind the transforms of a sample: the explicit pairs of a
+// pairwise sample, or each fragment against its predecessor for a trajectory
+// (relative transforms taken from consecutive poses). Pairs the context marks
+// as skipped are left out.
+std::vector<ScoredPair> scored_pairs(const std::vector<TransMat> &estimated,
+                                     const std::vector<TransMat> &ground_truth,
+                                     const MetricContext &context);
+
+// Settings shared by the cloud-based metrics: {"max_points": N} evaluates at
+// most N evenly strided points per fragment (0 = all), {"threads": T} caps the
+// OpenMP threads of the kernels (0 = omp_team_threads(), i.e. one on runner
+// workers).
+struct PointMetricSettings {
+  std::size_t max_points{20000};
+  int threads{0};
+
+  static PointMetricSettings from_json(const nlohmann::json &config);
+
+  std::size_t stride(std::size_t points) const {
+    return max_points == 0 || points <= max_points ? 1 : (points + max_points - 1) / max_points;
+  }
+};
+
+// Sum of ||(estimated - ground_truth) * p||^2 over every `stride`-th point p of
+// `cloud`, i.e. the squared displacement between the two placements; `count`
+// receives the number of points visited.
+double squared_displacement_sum(const PointCloud &cloud, const TransMat &estimated,
+                                const TransMat &ground_truth, std::size_t stride,
+                                int threads, std::size_t &count);
+
+// Ground-truth-aligned point RMSE of one pair over the (strided) source
+// points; NaN when the source has no finite point.
+double pair_point_rmse(const Sample &sample, const ScoredPair &pair,
+                       const PointMetricSettings &settings);
+
+// Number of every `stride`-th point of `cloud` that, moved by `transform`, has
+// a neighbour in `index` within `threshold`; `count` receives the number of
+// points visited.
+std::size_t count_inliers(const PointCloud &cloud, const TransMat &transform,
+                          const VoxelHashIndex &index, float threshold, std::size_t stride,
+                          int threads, std::size_t &count);
@@ -0,0 +1,47 @@
+#include "metric/point_recall_metric.hpp"
+
+#include "dataset_loader/dataset_loader_base.hpp"
+#include <cmath>
+#include <stdexcept>
+
+REGISTER_METRIC(point_recall, PointRecallMetric);
+
+PointRecallMetric::PointRecallMetric(const nlohmann::json &config)
+    : _settings(PointMetricSettings::from_json(config)) {
+  _rmse_threshold = config.value("rmse_threshold", _rmse_threshold);
+}
+
+double PointRecallMetric::evaluate(const std::vector<TransMat> &,
+                                   const std::vector<TransMat> &) {
+  throw std::logic_error("point_recall needs the sample's clouds");
+}
+
+double PointRecallMetric::evaluate(const std::vector<TransMat> &estimated,
+                                   const std::vector<TransMat> &ground_truth,
+                                   const MetricContext &context) {
+  if (estimated.size() != ground_truth.size()) {
+    throw std::invalid_argument(
+        "PointRecallMetric: estimated and ground truth transform counts must match");
+  }
+
+  const auto pairs = scored_pairs(estimated, ground_truth, context);
+  if (pairs.empty()) {
+    return 0.0;
+  }
+  std::size_t recalled = 0;
+  for (const auto &pair : pairs) {
+    if (pair_point_rmse(*context.sample, pair, _settings) <= _rmse_threshold) {
+      ++recalled;
+    }
+  }
+  return static_cast<double>(recalled) / static_cast<double>(pairs.size());
+}
+
+std::string PointRecallMetric::name() const {
+  return "point_recall";
+}
+
+std::shared_ptr<MetricBase>
+PointRecallMetric::create(const nlohmann::json &config) {
+  return std::make_shared<PointRecallMetric>(config);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "metric/metric_base.hpp"
+#include "metric/point_metric_kernels.hpp"
+#include <nlohmann/json.hpp>
+
+// Fraction of registered pairs whose ground-truth-aligned point RMSE (see
+// PointRmseMetric) is at most `rmse_threshold` meters, the 3DMatch recall
+// criterion. Needs the clouds.
+class PointRecallMetric : public MetricBase {
+public:
+  explicit PointRecallMetric(const nlohmann::json &config);
+
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth) override;
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth,
+                  const MetricContext &context) override;
+
+  std::string name() const override;
+  bool higher_is_better() const override { return true; }
+  double distance_tolerance() const override { return _rmse_threshold; }
+  bool needs_clouds() const override { return true; }
+
+  static std::shared_ptr<MetricBase> create(const nlohmann::json &config);
+
+private:
+  PointMetricSettings _settings;
+  double _rmse_threshold{0.2};
+};
@@ -0,0 +1,44 @@
+#include "metric/point_rmse_metric.hpp"
+
+#include "dataset_loader/dataset_loader_base.hpp"
+#include <cmath>
+#include <stdexcept>
+
+REGISTER_METRIC(point_rmse, PointRmseMetric);
+
+PointRmseMetric::PointRmseMetric(const nlohmann::json &config)
+    : _settings(PointMetricSettings::from_json(config)) {}
+
+double PointRmseMetric::evaluate(const std::vector<TransMat> &,
+                                 const std::vector<TransMat> &) {
+  throw std::logic_error("point_rmse needs the sample's clouds");
+}
+
+double PointRmseMetric::evaluate(const std::vector<TransMat> &estimated,
+                                 const std::vector<TransMat> &ground_truth,
+                                 const MetricContext &context) {
+  if (estimated.size() != ground_truth.size()) {
+    throw std::invalid_argument(
+        "PointRmseMetric: estimated and ground truth transform counts must match");
+  }
+
+  double total = 0.0;
+  std::size_t evaluated = 0;
+  for (const auto &pair : scored_pairs(estimated, ground_truth, context)) {
+    const double rmse = pair_point_rmse(*context.sample, pair, _settings);
+    if (std::isfinite(rmse)) {
+      total += rmse;
+      ++evaluated;
+    }
+  }
+  return evaluated > 0 ? total / static_cast<double>(evaluated) : 0.0;
+}
+
+std::string PointRmseMetric::name() const {
+  return "point_rmse";
+}
+
+std::shared_ptr<MetricBase>
+PointRmseMetric::create(const nlohmann::json &config) {
+  return std::make_shared<PointRmseMetric>(config);
+}
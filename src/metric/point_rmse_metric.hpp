@@ -0,0 +1,26 @@
+#pragma once
+
+#include "metric/metric_base.hpp"
+#include "metric/point_metric_kernels.hpp"
+#include <nlohmann/json.hpp>
+
+// Mean over the registered pairs of the RMSE between each source point placed
+// by the estimated and by the ground-truth transform. Needs the clouds.
+class PointRmseMetric : public MetricBase {
+public:
+  explicit PointRmseMetric(const nlohmann::json &config);
+
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth) override;
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth,
+                  const MetricContext &context) override;
+
+  std::string name() const override;
+  bool needs_clouds() const override { return true; }
+
+  static std::shared_ptr<MetricBase> create(const nlohmann::json &config);
+
+private:
+  PointMetricSettings _settings;
+};
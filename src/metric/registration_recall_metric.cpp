@@ -0,0 +1,56 @@
+#include "metric/registration_recall_metric.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+REGISTER_METRIC(registration_recall, RegistrationRecallMetric);
+
+RegistrationRecallMetric::RegistrationRecallMetric(const nlohmann::json &config) {
+  _rotation_threshold_deg =
+      config.value("rotation_threshold", _rotation_threshold_deg);
+  _translation_threshold =
+      config.value("translation_threshold", _translation_threshold);
+}
+
+double RegistrationRecallMetric::evaluate(
+    const std::vector<TransMat> &estimated,
+    const std::vector<TransMat> &ground_truth) {
+  if (estimated.size() != ground_truth.size()) {
+    throw std::invalid_argument(
+        "RegistrationRecallMetric: estimated and ground truth transform counts must match");
+  }
+
+  if (estimated.empty()) {
+    return 0.0;
+  }
+
+  const double cos_threshold =
+      std::cos(_rotation_threshold_deg * std::numbers::pi / 180.0);
+
+  std::size_t recalled = 0;
+  for (size_t idx = 0; idx < estimated.size(); ++idx) {
+    const Eigen::Matrix3f delta = ground_truth[idx].block<3, 3>(0, 0).transpose() *
+                                  estimated[idx].block<3, 3>(0, 0);
+    const double cos_theta =
+        std::clamp((static_cast<double>(delta.trace()) - 1.0) * 0.5, -1.0, 1.0);
+    const double translation_error = static_cast<double>(
+        (estimated[idx].block<3, 1>(0, 3) - ground_truth[idx].block<3, 1>(0, 3)).norm());
+
+    if (cos_theta >= cos_threshold && translation_error <= _translation_threshold) {
+      ++recalled;
+    }
+  }
+
+  return static_cast<double>(recalled) / static_cast<double>(estimated.size());
+}
+
+std::string RegistrationRecallMetric::name() const {
+  return "registration_recall";
+}
+
+std::shared_ptr<MetricBase>
+RegistrationRecallMetric::create(const nlohmann::json &config) {
+  return std::make_shared<RegistrationRecallMetric>(config);
+}
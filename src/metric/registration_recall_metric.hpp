@@ -0,0 +1,24 @@
+#pragma once
+
+#include "metric_base.hpp"
+#include <nlohmann/json.hpp>
+
+// Fraction of transforms whose rotation error is below `rotation_threshold`
+// (degrees) and translation error below `translation_threshold` (meters).
+class RegistrationRecallMetric : public MetricBase {
+public:
+  explicit RegistrationRecallMetric(const nlohmann::json &config);
+
+  double evaluate(const std::vector<TransMat> &estimated,
+                  const std::vector<TransMat> &ground_truth) override;
+
+  std::string name() const override;
+  bool higher_is_better() const override { return true; }
+  double distance_tolerance() const override { return _translation_threshold; }
+
+  static std::shared_ptr<MetricBase> create(const nlohmann::json &config);
+
+private:
+  double _rotation_threshold_deg{15.0};
+  double _translation_threshold{0.3};
+};
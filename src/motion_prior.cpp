@@ -0,0 +1,67 @@
+#include "motion_prior.hpp"
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+MotionPrior MotionPrior::from_json(const nlohmann::json &config) {
+    MotionPrior prior;
+    const auto model = config.is_object() ? config.value("model", std::string{"none"})
+                                          : config.get<std::string>();
+    if (model == "previous") {
+        prior.model = Model::Previous;
+    } else if (model == "constant_velocity") {
+        prior.model = Model::ConstantVelocity;
+    } else if (model != "none") {
+        throw std::invalid_argument(
+            "motion_prior must be \"none\", \"previous\" or \"constant_velocity\"");
+    }
+    if (config.is_object()) {
+        prior.window = config.value("window", prior.window);
+    }
+    if (prior.window == 0) {
+        throw std::invalid_argument("motion_prior.window must be positive");
+    }
+    return prior;
+}
+
+std::string_view MotionPrior::name() const {
+    switch (model) {
+    case Model::Previous:
+        return "previous";
+    case Model::ConstantVelocity:
+        return "constant_velocity";
+    default:
+        return "none";
+    }
+}
+
+TransMat MotionPrior::predict(const std::vector<TransMat> &relatives) const {
+    if (model == Model::None || relatives.empty()) {
+        return TransMat::Identity();
+    }
+    if (model == Model::Previous) {
+        return relatives.back();
+    }
+
+    // Inter-fragment motions are small, so averaging their rotation vectors
+    // and translations is a good estimate of the mean motion.
+    const auto count = std::min(window, relatives.size());
+    Eigen::Vector3f rotation = Eigen::Vector3f::Zero();
+    Eigen::Vector3f translation = Eigen::Vector3f::Zero();
+    for (auto it = relatives.end() - static_cast<std::ptrdiff_t>(count); it != relatives.end(); ++it) {
+        const Eigen::AngleAxisf step(Eigen::Matrix3f(it->topLeftCorner<3, 3>()));
+        rotation += step.angle() * step.axis();
+        translation += it->topRightCorner<3, 1>();
+    }
+    rotation /= static_cast<float>(count);
+    translation /= static_cast<float>(count);
+
+    TransMat guess = TransMat::Identity();
+    const float angle = rotation.norm();
+    if (angle > 0.0f) {
+        guess.topLeftCorner<3, 3>() = Eigen::AngleAxisf(angle, rotation / angle).toRotationMatrix();
+    }
+    guess.topRightCorner<3, 1>() = translation;
+    return guess;
+}
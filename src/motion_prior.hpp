@@ -0,0 +1,36 @@
+#pragma once
+#include "common.hpp"
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <string_view>
+#include <vector>
+
+// Initial guesses for the consecutive pairs of a sequential sample, predicted
+// from the relative transforms estimated for the pairs before them. Adjacent
+// fragments of a trajectory move alike, so a registration seeded this way
+// starts near its answer instead of at identity.
+struct MotionPrior {
+    enum class Model {
+        // Identity, as without a prior.
+        None,
+        // The previous pair's relative transform.
+        Previous,
+        // The mean motion of the last `window` pairs, so that one poor
+        // estimate does not derail the next pair.
+        ConstantVelocity
+    };
+
+    Model model{Model::None};
+    std::size_t window{3};
+
+    // Reads "none", "previous" or "constant_velocity", or an object
+    // {"model", "window"}.
+    static MotionPrior from_json(const nlohmann::json &config);
+
+    bool enabled() const { return model != Model::None; }
+    std::string_view name() const;
+
+    // Guess for the next pair given the relative transforms of the previous
+    // pairs of the sequence, oldest first.
+    TransMat predict(const std::vector<TransMat> &relatives) const;
+};
@@ -0,0 +1,139 @@
+#include "overlap.hpp"
+#include "algorithm/voxel_hash_correspondence.hpp"
+#include "algorithm/voxel_hash_index.hpp"
+#include "algorithm/voxel_key.hpp"
+#include <Eigen/Geometry>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct VoxelCentroids {
+    std::vector<Eigen::Vector3f> centers;
+    Eigen::AlignedBox3f bounds;
+};
+
+std::shared_ptr<VoxelCentroids> compute_centroids(const PointCloud &cloud, float voxel_size) {
+    struct Accumulator {
+        Eigen::Vector3f sum{Eigen::Vector3f::Zero()};
+        std::uint32_t count{0};
+    };
+
+    const float inverse_voxel_size = 1.0f / voxel_size;
+
+    std::unordered_map<std::uint64_t, Accumulator> voxels;
+    voxels.reserve(cloud.size() / 4 + 1);
+    for (const auto &point : cloud) {
+        if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+            continue;
+        }
+        const Eigen::Vector3f position(point.x, point.y, point.z);
+        auto &accumulator = voxels[pack_voxel_key(voxel_coordinates(position, inverse_voxel_size))];
+        accumulator.sum += position;
+        ++accumulator.count;
+    }
+
+    auto centroids = std::make_shared<VoxelCentroids>();
+    centroids->centers.reserve(voxels.size());
+    for (const auto &[key, accumulator] : voxels) {
+        const Eigen::Vector3f center = accumulator.sum / static_cast<float>(accumulator.count);
+        centroids->centers.emplace_back(center);
+        centroids->bounds.extend(center);
+    }
+    return centroids;
+}
+
+std::shared_ptr<const VoxelCentroids> fragment_centroids(const Fragment &fragment,
+                                                         float voxel_size) {
+    return fragment.derived<VoxelCentroids>(
+        std::format("overlap/centroids/v={}", voxel_size),
+        [&fragment, voxel_size]() { return compute_centroids(fragment.cloud, voxel_size); });
+}
+} // namespace
+
+double estimate_overlap(const Fragment &source, const Fragment &target,
+                        const TransMat &initial_guess, double voxel_size) {
+    const auto size = static_cast<float>(voxel_size);
+    const auto source_centroids = fragment_centroids(source, size);
+    const auto target_centroids = fragment_centroids(target, size);
+    if (source_centroids->centers.empty() || target_centroids->centers.empty()) {
+        return 0.0;
+    }
+
+    const Eigen::Affine3f guess(initial_guess);
+    Eigen::AlignedBox3f moved_bounds;
+    for (int corner = 0; corner < 8; ++corner) {
+        moved_bounds.extend(guess * source_centroids->bounds.corner(
+                                        static_cast<Eigen::AlignedBox3f::CornerType>(corner)));
+    }
+    Eigen::AlignedBox3f target_bounds = target_centroids->bounds;
+    target_bounds.min().array() -= size;
+    target_bounds.max().array() += size;
+    if (!moved_bounds.intersects(target_bounds)) {
+        return 0.0;
+    }
+
+    // Shares its cache entry with the voxel-hash correspondence backend when
+    // the voxel sizes agree.
+    const auto index = target.derived<VoxelHashIndex>(
+        CorrespondenceBackend::index_key("cloud", size),
+        [&target, size]() { return std::make_shared<VoxelHashIndex>(target.cloud, size); });
+
+    std::size_t overlapping = 0;
+    for (const auto &center : source_centroids->centers) {
+        std::uint32_t match = 0;
+        float squared_distance = 0.0f;
+        if (index->nearest(guess * center, size, match, squared_distance)) {
+            ++overlapping;
+        }
+    }
+    return static_cast<double>(overlapping) /
+           static_cast<double>(source_centroids->centers.size());
+}
+
+OverlapFilter OverlapFilter::from_json(const nlohmann::json &config) {
+    OverlapFilter filter;
+    filter.min_overlap = config.value("min_overlap", filter.min_overlap);
+    filter.voxel_size = config.value("voxel_size", filter.voxel_size);
+    if (filter.min_overlap < 0.0 || filter.min_overlap > 1.0) {
+        throw std::invalid_argument("overlap.min_overlap must be in [0, 1]");
+    }
+    if (!(filter.voxel_size > 0.0)) {
+        throw std::invalid_argument("overlap.voxel_size must be positive");
+    }
+
+    if (config.contains("fallback")) {
+        const auto &fallback = config["fallback"];
+        if (fallback.is_string()) {
+            const auto name = fallback.get<std::string>();
+            if (name != "skip") {
+                filter.fallback = algorithmManager.create(name, nlohmann::json::object());
+            }
+        } else if (fallback.is_object() && fallback.contains("name") &&
+                   fallback["name"].is_string()) {
+            filter.fallback = algorithmManager.create(fallback["name"].get<std::string>(), fallback);
+        } else {
+            throw std::invalid_argument(
+                "overlap.fallback must be \"skip\", an algorithm name or an algorithm config");
+        }
+    }
+    return filter;
+}
+
+TransMat OverlapFilter::register_pair(AlgorithmBase &algorithm, const Fragment &source,
+                                      const Fragment &target, PairRoute &route,
+                                      const TransMat &initial_guess) const {
+    if (enabled() && estimate_overlap(source, target, initial_guess, voxel_size) < min_overlap) {
+        if (!fallback) {
+            route = PairRoute::Skipped;
+            return initial_guess;
+        }
+        route = PairRoute::Fallback;
+        return fallback->register_fragments(source, target, initial_guess);
+    }
+    route = PairRoute::Registered;
+    return algorithm.register_fragments(source, target, initial_guess);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "algorithm/algorithm_base.hpp"
+#include "common.hpp"
+#include "fragment_cache.hpp"
+#include <memory>
+#include <nlohmann/json.hpp>
+
+// Fraction of the source's occupied voxels (of size `voxel_size`) that land
+// within one voxel of a target point once the source is moved by
+// `initial_guess`. Source voxel centroids and the target's VoxelHashIndex are
+// built once per fragment through the sample's cache; pairs whose bounding
+// boxes do not meet are answered without touching either.
+double estimate_overlap(const Fragment &source, const Fragment &target,
+                        const TransMat &initial_guess, double voxel_size);
+
+// How a pair was handled by the overlap pre-filter.
+enum class PairRoute { Registered, Fallback, Skipped };
+
+// Pre-registration filter: pairs whose estimated overlap is below
+// `min_overlap` are handed to `fallback` (e.g. an algorithm with a wider basin
+// of convergence) or, without one, skipped and reported as the initial guess,
+// which the runner hands to metrics as skipped (MetricContext::skipped) rather
+// than scoring it. A `min_overlap` of 0 disables the filter.
+struct OverlapFilter {
+    double min_overlap{0.0};
+    double voxel_size{0.05};
+    std::shared_ptr<AlgorithmBase> fallback;
+
+    // Reads {"min_overlap", "voxel_size", "fallback"}; "fallback" is "skip",
+    // an algorithm name or an algorithm config object.
+    static OverlapFilter from_json(const nlohmann::json &config);
+
+    bool enabled() const { return min_overlap > 0.0; }
+
+    // Registers the pair with `algorithm` or routes it as described above.
+    TransMat register_pair(AlgorithmBase &algorithm, const Fragment &source,
+                           const Fragment &target, PairRoute &route,
+                           const TransMat &initial_guess = TransMat::Identity()) const;
+};
@@ -1,41 +1,127 @@
 #include "process.h"
+#include "affinity.hpp"
 #include "algorithm/algorithm_base.hpp"
 #include "common.hpp"
 #include "logger.hpp"
+#include "result_store.hpp"
+#include "sweep.hpp"
 #include <BS_thread_pool.hpp>
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <chrono>
+#include <exception>
 #include <fstream>
 #include <future>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <tuple>
 
-std::vector<TransMat> register_sample(AlgorithmBase &algorithm,
-                                      const std::vector<PointCloud> &point_clouds) {
+std::vector<TransMat> register_sample(AlgorithmBase &algorithm, const Sample &sample,
+                                      const OverlapFilter &filter, PairRouteCounts *counts,
+                                      const MotionPrior &prior) {
     std::vector<TransMat> transforms;
-    transforms.reserve(point_clouds.size());
+    transforms.reserve(sample.fragment_count());
 
-    if (point_clouds.empty()) {
+    if (sample.fragment_count() == 0) {
         return transforms;
     }
 
     transforms.emplace_back(TransMat::Identity());
 
-    for (size_t idx = 1; idx < point_clouds.size(); ++idx) {
-        const auto &source = point_clouds[idx];
-        const auto &target = point_clouds[idx - 1];
-        const auto relative = algorithm.register_point_cloud(source, target);
+    // Every fragment but the last is a target exactly once. Compact samples
+    // are left to derive on first use, since handing out all their fragments
+    // at once would decode the whole sequence up front.
+    if (sample.compact_clouds.empty()) {
+        std::vector<Fragment> targets;
+        targets.reserve(sample.fragment_count() - 1);
+        for (size_t idx = 0; idx + 1 < sample.fragment_count(); ++idx) {
+            targets.emplace_back(sample.fragment(idx));
+        }
+        algorithm.prepare_targets(targets);
+    }
+
+    std::vector<TransMat> relatives;
+    if (prior.enabled()) {
+        relatives.reserve(sample.fragment_count() - 1);
+    }
+    for (size_t idx = 1; idx < sample.fragment_count(); ++idx) {
+        const auto source = sample.fragment(idx);
+        const auto target = sample.fragment(idx - 1);
+        PairRoute route = PairRoute::Registered;
+        const auto relative =
+            filter.register_pair(algorithm, source, target, route, prior.predict(relatives));
+        if (counts != nullptr) {
+            counts->add(route);
+        }
+        if (prior.enabled()) {
+            relatives.emplace_back(relative);
+        }
         transforms.emplace_back(transforms.back() * relative);
     }
 
     return transforms;
 }
 
+std::vector<std::vector<std::size_t>> schedule_pairs(const std::vector<FragmentPair> &pairs) {
+    std::vector<std::size_t> order(pairs.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [&pairs](std::size_t lhs, std::size_t rhs) {
+        return std::tie(pairs[lhs].target, pairs[lhs].source) <
+               std::tie(pairs[rhs].target, pairs[rhs].source);
+    });
+
+    std::vector<std::vector<std::size_t>> groups;
+    for (const auto pair_idx : order) {
+        if (groups.empty() || pairs[groups.back().front()].target != pairs[pair_idx].target) {
+            groups.emplace_back();
+        }
+        groups.back().emplace_back(pair_idx);
+    }
+    return groups;
+}
+
+std::vector<TransMat> register_pairs(AlgorithmBase &algorithm,
+                                     const Sample &sample,
+                                     const std::vector<std::size_t> &pair_indices,
+                                     const OverlapFilter &filter,
+                                     PairRouteCounts *counts) {
+    std::vector<TransMat> transforms;
+    transforms.reserve(pair_indices.size());
+
+    for (const auto pair_idx : pair_indices) {
+        transforms.emplace_back(register_pair(algorithm, sample, pair_idx, filter, counts));
+    }
+
+    return transforms;
+}
+
+TransMat register_pair(AlgorithmBase &algorithm,
+                       const Sample &sample,
+                       std::size_t pair_idx,
+                       const OverlapFilter &filter,
+                       PairRouteCounts *counts) {
+    const auto &pair = sample.pairs.at(pair_idx);
+    PairRoute route = PairRoute::Registered;
+    auto transform = filter.register_pair(algorithm, sample.fragment(pair.source),
+                                          sample.fragment(pair.target), route);
+    if (counts != nullptr) {
+        counts->add(route);
+    }
+    return transform;
+}
+
 std::vector<double> evaluate_sample(
     const std::vector<std::shared_ptr<MetricBase>> &metrics,
     const std::vector<TransMat> &estimated_transforms,
-    const std::vector<TransMat> &ground_truth_transforms) {
+    const std::vector<TransMat> &ground_truth_transforms,
+    const MetricContext &context) {
     if (estimated_transforms.size() != ground_truth_transforms.size()) {
         throw std::invalid_argument(
             "evaluate_sample requires estimated and ground truth transforms to have equal length");
@@ -46,7 +132,7 @@ std::vector<double> evaluate_sample(
 
     for (const auto &metric : metrics) {
         scores.emplace_back(
-            metric->evaluate(estimated_transforms, ground_truth_transforms));
+            metric->evaluate(estimated_transforms, ground_truth_transforms, context));
     }
 
     return scores;
@@ -54,13 +140,276 @@ std::vector<double> evaluate_sample(
 
 namespace {
 constexpr std::string_view ROLE_PROCESS{"process"};
+
+using Clock = std::chrono::steady_clock;
+
+// A unit of scheduled work: a whole sequential sample, or one target group of
+// a pair sample.
+struct WorkUnit {
+    std::size_t sample{0};
+    const std::vector<std::size_t> *group{nullptr};
+};
+
+// Result of one algorithm on one work unit. For a sequential sample
+// `transforms` is the trajectory; for a pair group, one transform per pair.
+struct UnitOutcome {
+    std::vector<TransMat> transforms;
+    std::size_t failures{0};
+    PairRouteCounts routes;
+    // Iterations reported by the algorithm (see AlgorithmBase::thread_iterations).
+    std::size_t iterations{0};
+    Clock::time_point start;
+    Clock::time_point end;
+    std::exception_ptr error;
+};
+
+double seconds_between(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+UnitOutcome run_unit(AlgorithmBase &algorithm, const Sample &sample, const WorkUnit &unit,
+                     const OverlapFilter &filter, const MotionPrior &prior,
+                     const std::string &label) {
+    UnitOutcome outcome;
+    const auto iterations_before = AlgorithmBase::thread_iterations();
+    outcome.start = Clock::now();
+    if (unit.group == nullptr) {
+        try {
+            outcome.transforms =
+                register_sample(algorithm, sample, filter, &outcome.routes, prior);
+        } catch (...) {
+            outcome.error = std::current_exception();
+        }
+    } else {
+        outcome.transforms.reserve(unit.group->size());
+        for (const auto pair_idx : *unit.group) {
+            // A failed pair counts as not recalled instead of discarding
+            // every other pair of the scene.
+            try {
+                outcome.transforms.emplace_back(
+                    register_pair(algorithm, sample, pair_idx, filter, &outcome.routes));
+            } catch (const std::exception &e) {
+                LOG_WARN(ROLE_PROCESS, "Pair {} failed with algorithm '{}': {}", pair_idx, label,
+                         e.what());
+                outcome.transforms.emplace_back(TransMat::Identity());
+                // Scored as a failure, not left out like a skipped pair.
+                outcome.routes.add(PairRoute::Registered);
+                ++outcome.failures;
+            }
+        }
+    }
+    outcome.end = Clock::now();
+    outcome.iterations = AlgorithmBase::thread_iterations() - iterations_before;
+    return outcome;
+}
+
+// Fragments a unit reads: every fragment of a sequential sample, or the
+// target and sources of a pair group.
+std::vector<std::size_t> unit_fragments(const Sample &sample, const WorkUnit &unit) {
+    std::vector<std::size_t> fragments;
+    if (unit.group == nullptr) {
+        fragments.resize(sample.fragment_count());
+        std::iota(fragments.begin(), fragments.end(), std::size_t{0});
+        return fragments;
+    }
+    fragments.reserve(unit.group->size() + 1);
+    fragments.emplace_back(sample.pairs.at(unit.group->front()).target);
+    for (const auto pair_idx : *unit.group) {
+        fragments.emplace_back(sample.pairs.at(pair_idx).source);
+    }
+    return fragments;
+}
+
+// Pairs a unit registers.
+std::size_t unit_pairs(const Sample &sample, const WorkUnit &unit) {
+    if (unit.group != nullptr) {
+        return unit.group->size();
+    }
+    const auto clouds = sample.fragment_count();
+    return clouds > 0 ? clouds - 1 : 0;
+}
+
+// Sample-major scheduling pays off when variants of one algorithm can reuse
+// each other's per-fragment data.
+bool has_variants(const std::vector<std::shared_ptr<AlgorithmBase>> &algorithms) {
+    for (std::size_t lhs = 0; lhs < algorithms.size(); ++lhs) {
+        for (std::size_t rhs = lhs + 1; rhs < algorithms.size(); ++rhs) {
+            if (algorithms[lhs]->name() == algorithms[rhs]->name()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Spreads samples over `node_count` nodes, largest remaining load first, by
+// point count. Deterministic so that place_samples() and run_evaluation()
+// agree on where each sample lives.
+std::vector<std::size_t> assign_sample_nodes(const std::vector<Sample> &samples,
+                                             std::size_t node_count) {
+    std::vector<std::size_t> nodes(samples.size(), 0);
+    if (node_count <= 1) {
+        return nodes;
+    }
+    std::vector<std::size_t> load(node_count, 0);
+    for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
+        std::size_t points = 0;
+        for (std::size_t fragment = 0; fragment < samples[sample_idx].fragment_count(); ++fragment) {
+            points += samples[sample_idx].point_count(fragment);
+        }
+        const auto node = static_cast<std::size_t>(
+            std::min_element(load.begin(), load.end()) - load.begin());
+        nodes[sample_idx] = node;
+        load[node] += points;
+    }
+    return nodes;
+}
+
+// One pool per NUMA node whose workers are pinned according to `mode`; a
+// single unpinned pool when affinity is off.
+std::vector<std::unique_ptr<BS::thread_pool>> make_pools(const CpuTopology &topology,
+                                                         AffinityMode mode,
+                                                         unsigned int thread_count) {
+    std::vector<std::unique_ptr<BS::thread_pool>> pools;
+    if (mode == AffinityMode::None) {
+        pools.emplace_back(std::make_unique<BS::thread_pool>(thread_count, mark_pool_worker));
+        return pools;
+    }
+
+    const auto total_cpus = std::max<std::size_t>(1, topology.cpu_count());
+    for (const auto &cpus : topology.nodes) {
+        const auto node_threads = std::max<unsigned int>(
+            1, static_cast<unsigned int>((thread_count * cpus.size() + total_cpus / 2) / total_cpus));
+        // Pinning every worker of a lone node to all its CPUs would change
+        // nothing.
+        if (mode == AffinityMode::Node && topology.node_count() == 1) {
+            pools.emplace_back(std::make_unique<BS::thread_pool>(node_threads, mark_pool_worker));
+            continue;
+        }
+        auto next_worker = std::make_shared<std::atomic<std::size_t>>(0);
+        pools.emplace_back(std::make_unique<BS::thread_pool>(
+            node_threads, [&cpus, mode, next_worker]() {
+                mark_pool_worker();
+                const auto worker = next_worker->fetch_add(1);
+                const bool pinned = mode == AffinityMode::Core
+                                        ? pin_current_thread({cpus[worker % cpus.size()]})
+                                        : pin_current_thread(cpus);
+                if (!pinned) {
+                    LOG_WARN(ROLE_PROCESS, "Could not pin worker {}; it runs unpinned", worker);
+                }
+            }));
+    }
+    return pools;
+}
 } // namespace
 
+void place_samples(std::vector<Sample> &samples, const RunnerOptions &options) {
+    if (options.affinity == AffinityMode::None || !options.first_touch) {
+        return;
+    }
+    const auto topology = CpuTopology::detect();
+    if (topology.node_count() <= 1) {
+        return;
+    }
+
+    // A thread pinned to each node copies that node's clouds, so the kernel's
+    // first-touch policy backs the new buffers with node-local pages; the
+    // originals are released as they are replaced.
+    const auto nodes = assign_sample_nodes(samples, topology.node_count());
+    std::vector<std::thread> workers;
+    for (std::size_t node = 0; node < topology.node_count(); ++node) {
+        workers.emplace_back([&samples, &nodes, &topology, node]() {
+            if (!pin_current_thread(topology.nodes[node])) {
+                LOG_WARN(ROLE_PROCESS, "Could not pin to node {}; its samples keep their placement", node);
+                return;
+            }
+            for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
+                if (nodes[sample_idx] != node) {
+                    continue;
+                }
+                for (auto &cloud : samples[sample_idx].point_clouds) {
+                    PointCloud local(cloud);
+                    cloud = std::move(local);
+                }
+                for (auto &cloud : samples[sample_idx].compact_clouds) {
+                    CompactPointCloud local(cloud);
+                    cloud = std::move(local);
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    LOG_INFO(ROLE_PROCESS, "Placed {} sample(s) on {} NUMA node(s)", samples.size(),
+             topology.node_count());
+}
+
+RunnerOptions RunnerOptions::from_json(const nlohmann::json &config) {
+    RunnerOptions options;
+    if (config.contains("threads")) {
+        const auto &threads_value = config["threads"];
+        if (threads_value.is_number_unsigned()) {
+            options.threads = threads_value.get<std::size_t>();
+        } else if (threads_value.is_number_integer()) {
+            const auto threads_signed = threads_value.get<long long>();
+            if (threads_signed > 0) {
+                options.threads = static_cast<std::size_t>(threads_signed);
+            }
+        }
+    }
+    if (config.contains("overlap")) {
+        if (!config["overlap"].is_object()) {
+            throw std::invalid_argument("runner.overlap must be an object");
+        }
+        options.overlap = OverlapFilter::from_json(config["overlap"]);
+    }
+    options.results_path = config.value("results", options.results_path);
+    options.results_store = config.value("results_store", options.results_store);
+    options.run = config.value("run", options.run);
+    const auto schedule = config.value("schedule", std::string{"auto"});
+    if (schedule == "algorithm") {
+        options.schedule = RunnerOptions::Schedule::AlgorithmMajor;
+    } else if (schedule == "sample") {
+        options.schedule = RunnerOptions::Schedule::SampleMajor;
+    } else if (schedule != "auto") {
+        throw std::invalid_argument("runner.schedule must be \"auto\", \"algorithm\" or \"sample\"");
+    }
+    if (config.contains("affinity")) {
+        options.affinity = affinity_mode_from_string(config["affinity"].get<std::string>());
+    }
+    options.first_touch = config.value("first_touch", options.first_touch);
+    if (config.contains("memory_budget")) {
+        const auto &budget = config["memory_budget"];
+        options.memory.budget_bytes = budget.is_string() ? parse_byte_size(budget.get<std::string>())
+                                                         : budget.get<std::size_t>();
+    }
+    options.memory.cache_bytes_per_point =
+        config.value("cache_bytes_per_point", options.memory.cache_bytes_per_point);
+    options.memory.task_bytes_per_point =
+        config.value("task_bytes_per_point", options.memory.task_bytes_per_point);
+    if (config.contains("spill_dir")) {
+        options.memory.spill_dir = config["spill_dir"].get<std::string>();
+    }
+    if (config.contains("motion_prior")) {
+        options.motion_prior = MotionPrior::from_json(config["motion_prior"]);
+    }
+    if (config.contains("report")) {
+        if (!config["report"].is_object()) {
+            throw std::invalid_argument("runner.report must be an object");
+        }
+        options.report = RunMonitor::Options::from_json(config["report"]);
+    }
+    return options;
+}
+
 AlgorithmResults run_evaluation(
     const std::vector<std::shared_ptr<AlgorithmBase>> &algorithms,
     const std::vector<Sample> &samples,
     const std::vector<std::shared_ptr<MetricBase>> &metrics,
-    std::size_t thread_count_hint) {
+    const RunnerOptions &options,
+    AlgorithmTimings *timings,
+    MemoryBudget *memory) {
     AlgorithmResults results;
 
     if (algorithms.empty() || samples.empty()) {
@@ -73,69 +422,384 @@ AlgorithmResults run_evaluation(
     }
 
     const unsigned int thread_count =
-        thread_count_hint > 0 ? static_cast<unsigned int>(thread_count_hint)
-                              : default_threads;
-    BS::thread_pool thread_pool(thread_count);
+        options.threads > 0 ? static_cast<unsigned int>(options.threads) : default_threads;
+    const auto topology = options.affinity == AffinityMode::None ? CpuTopology{}
+                                                                 : CpuTopology::detect();
+    const auto pools = make_pools(topology, options.affinity, thread_count);
+    // Every unit of a sample goes to the pool of the node holding its clouds.
+    const auto sample_nodes = assign_sample_nodes(samples, pools.size());
 
-    LOG_INFO(ROLE_PROCESS, "Starting evaluation with {} thread(s), {} algorithm(s) and {} sample(s)",
-             thread_count, algorithms.size(), samples.size());
+    // Affinity only helps when a sample's algorithms run where its data is.
+    const bool sample_major =
+        options.schedule == RunnerOptions::Schedule::SampleMajor ||
+        (options.schedule == RunnerOptions::Schedule::Auto &&
+         (options.affinity != AffinityMode::None || has_variants(algorithms)));
+    if (sample_major && options.schedule == RunnerOptions::Schedule::Auto &&
+        algorithms.size() > 1) {
+        LOG_INFO(ROLE_PROCESS, "Auto schedule runs sample-major because {}; per-algorithm wall "
+                 "time is apportioned from unit durations",
+                 options.affinity != AffinityMode::None ? "workers are pinned"
+                                                        : "algorithms include variants");
+    }
 
-    const std::size_t total_tasks = algorithms.size() * samples.size();
+    std::size_t worker_count = 0;
+    for (const auto &pool : pools) {
+        worker_count += pool->get_thread_count();
+    }
+    LOG_INFO(ROLE_PROCESS, "Starting evaluation with {} thread(s), {} algorithm(s) and {} sample(s), {}-major",
+             worker_count, algorithms.size(), samples.size(), sample_major ? "sample" : "algorithm");
+    if (options.affinity != AffinityMode::None) {
+        LOG_INFO(ROLE_PROCESS, "Workers pinned per {} across {} NUMA node(s)",
+                 options.affinity == AffinityMode::Core ? "core" : "node", pools.size());
+    }
+    const OverlapFilter &filter = options.overlap;
+    if (options.motion_prior.enabled()) {
+        LOG_INFO(ROLE_PROCESS, "Sequential pairs start from the '{}' motion prior",
+                 options.motion_prior.name());
+    }
+    if (filter.enabled()) {
+        LOG_INFO(ROLE_PROCESS, "Pairs with overlap below {} go to {}", filter.min_overlap,
+                 filter.fallback ? "'" + filter.fallback->label() + "'" : std::string{"skip"});
+    }
+
+    // Samples with an explicit pair list are split into per-target groups that
+    // run as separate units; all other samples are one unit each.
+    std::vector<std::vector<std::vector<std::size_t>>> pair_groups(samples.size());
+    std::vector<WorkUnit> units;
+    for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
+        if (!samples[sample_idx].pairs.empty()) {
+            pair_groups[sample_idx] = schedule_pairs(samples[sample_idx].pairs);
+            for (const auto &group : pair_groups[sample_idx]) {
+                units.push_back({sample_idx, &group});
+            }
+        } else {
+            units.push_back({sample_idx, nullptr});
+        }
+    }
+
+    const std::size_t total_tasks = algorithms.size() * units.size();
     std::atomic<std::size_t> completed_tasks{0};
+    auto update_progress = [&completed_tasks, total_tasks]() {
+        const auto finished = completed_tasks.fetch_add(1) + 1;
+        const double ratio = (total_tasks == 0)
+                                 ? 1.0
+                                 : static_cast<double>(finished) /
+                                       static_cast<double>(total_tasks);
+        Logger::instance().progress(ratio, finished, total_tasks);
+    };
 
+    std::vector<std::string> labels;
+    labels.reserve(algorithms.size());
     for (const auto &algorithm : algorithms) {
-        const auto algorithm_name = algorithm->name();
-        auto &sample_scores = results[algorithm_name];
-        sample_scores.resize(samples.size());
-
-        LOG_INFO(ROLE_PROCESS, "Evaluating algorithm '{}' on {} samples",
-                 algorithm_name, samples.size());
+        labels.emplace_back(algorithm->label());
+    }
 
-        std::vector<std::future<std::vector<double>>> futures;
-        futures.reserve(samples.size());
+    // Workers only touch their own slot of the monitor; its reporter thread
+    // renders the status line the per-task progress update would.
+    std::unique_ptr<RunMonitor> monitor;
+    if (options.report.interval_seconds > 0.0) {
+        std::size_t total_pairs = 0;
+        for (const auto &unit : units) {
+            total_pairs += unit_pairs(samples[unit.sample], unit);
+        }
+        monitor = std::make_unique<RunMonitor>(options.report, labels, worker_count, total_tasks,
+                                               total_pairs * algorithms.size());
+    }
 
-        for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
-            const Sample *sample_ptr = &samples[sample_idx];
-            auto algo_ptr = algorithm;
-
-            futures.emplace_back(thread_pool.submit_task(
-                [algo_ptr, sample_ptr, &metrics, &completed_tasks, total_tasks]() {
-                    auto update_progress = [&completed_tasks, total_tasks]() {
-                        const auto finished = completed_tasks.fetch_add(1) + 1;
-                        const double ratio = (total_tasks == 0)
-                                                 ? 1.0
-                                                 : static_cast<double>(finished) /
-                                                       static_cast<double>(total_tasks);
-                        Logger::instance().progress(ratio, finished, total_tasks);
-                    };
+    // Algorithm-major: one task per (algorithm, unit). Sample-major: one task
+    // per unit running every algorithm back to back on the same worker, so
+    // variants find the unit's fragments and their derived data hot.
+    // Tasks left per sample. A compact sample's decoded clouds live in its
+    // fragment cache, which is cleared once its last task is done so that
+    // only samples in flight hold full-precision copies. Fragments the budget
+    // can read again are released then too, unless the metrics still need
+    // them, in which case scoring releases them.
+    const bool metrics_need_clouds =
+        std::any_of(metrics.begin(), metrics.end(),
+                    [](const auto &metric) { return metric->needs_clouds(); });
+    std::vector<std::atomic<std::size_t>> open_tasks(samples.size());
+    for (const auto &unit : units) {
+        open_tasks[unit.sample] += sample_major ? 1 : algorithms.size();
+    }
+    const auto finish_task = [&samples, &open_tasks, memory,
+                              metrics_need_clouds](std::size_t sample_idx) {
+        if (open_tasks[sample_idx].fetch_sub(1) != 1) {
+            return;
+        }
+        if (!samples[sample_idx].compact_clouds.empty()) {
+            samples[sample_idx].cache->clear();
+        }
+        if (memory != nullptr && !metrics_need_clouds) {
+            memory->retire(sample_idx);
+        }
+    };
 
+    std::vector<std::future<std::vector<UnitOutcome>>> futures;
+    auto submit = [&](const WorkUnit &unit, std::vector<std::size_t> algorithm_indices) {
+        futures.emplace_back(pools[sample_nodes[unit.sample]]->submit_task(
+            [&algorithms, &samples, &labels, &filter, &prior = options.motion_prior,
+             &update_progress, &finish_task, memory,
+             monitor = monitor.get(), unit, algorithm_indices = std::move(algorithm_indices)]() {
+                // Held until every algorithm of the task is done with the
+                // unit's fragments.
+                MemoryBudget::Lease lease;
+                std::vector<UnitOutcome> outcomes;
+                outcomes.reserve(algorithm_indices.size());
+                if (memory != nullptr) {
+                    // A fragment that cannot be read fails its sample, like
+                    // any other error of the unit, not the whole run.
                     try {
-                        const auto &point_clouds = sample_ptr->point_clouds;
-                        const auto &ground_truth = sample_ptr->world_transforms;
-
-                        const auto estimated_transforms =
-                            register_sample(*algo_ptr, point_clouds);
-                        auto scores =
-                            evaluate_sample(metrics, estimated_transforms, ground_truth);
-
-                        update_progress();
-                        return scores;
+                        lease = memory->admit(unit.sample,
+                                              unit_fragments(samples[unit.sample], unit));
                     } catch (...) {
+                        const auto error = std::current_exception();
+                        const auto now = Clock::now();
+                        for (const auto algorithm_idx : algorithm_indices) {
+                            auto &outcome = outcomes.emplace_back();
+                            outcome.start = now;
+                            outcome.end = now;
+                            outcome.error = error;
+                            // Counted as done right away.
+                            if (monitor != nullptr) {
+                                monitor->begin(algorithm_idx, unit.sample,
+                                               unit_pairs(samples[unit.sample], unit));
+                            } else {
+                                update_progress();
+                            }
+                        }
+                        finish_task(unit.sample);
+                        return outcomes;
+                    }
+                }
+                for (const auto algorithm_idx : algorithm_indices) {
+                    std::optional<RunMonitor::Task> task;
+                    if (monitor != nullptr) {
+                        task.emplace(monitor->begin(algorithm_idx, unit.sample,
+                                                    unit_pairs(samples[unit.sample], unit)));
+                    }
+                    outcomes.emplace_back(run_unit(*algorithms[algorithm_idx],
+                                                   samples[unit.sample], unit, filter, prior,
+                                                   labels[algorithm_idx]));
+                    if (monitor == nullptr) {
                         update_progress();
-                        throw;
                     }
-                }));
+                }
+                // Unpins the fragments so that the last task can retire them.
+                lease = {};
+                finish_task(unit.sample);
+                return outcomes;
+            }));
+    };
+
+    // outcomes[algorithm][unit], filled as the tasks finish.
+    std::vector<std::vector<UnitOutcome>> outcomes(algorithms.size(),
+                                                   std::vector<UnitOutcome>(units.size()));
+    if (sample_major) {
+        std::vector<std::size_t> all(algorithms.size());
+        std::iota(all.begin(), all.end(), std::size_t{0});
+        for (const auto &unit : units) {
+            submit(unit, all);
+        }
+        for (std::size_t unit_idx = 0; unit_idx < units.size(); ++unit_idx) {
+            auto unit_outcomes = futures[unit_idx].get();
+            for (std::size_t algorithm_idx = 0; algorithm_idx < algorithms.size(); ++algorithm_idx) {
+                outcomes[algorithm_idx][unit_idx] = std::move(unit_outcomes[algorithm_idx]);
+            }
+        }
+    } else {
+        for (std::size_t algorithm_idx = 0; algorithm_idx < algorithms.size(); ++algorithm_idx) {
+            LOG_INFO(ROLE_PROCESS, "Evaluating algorithm '{}' on {} samples",
+                     labels[algorithm_idx], samples.size());
+            for (const auto &unit : units) {
+                submit(unit, {algorithm_idx});
+            }
+        }
+        for (std::size_t task_idx = 0; task_idx < futures.size(); ++task_idx) {
+            outcomes[task_idx / units.size()][task_idx % units.size()] =
+                std::move(futures[task_idx].get().front());
+        }
+    }
+    // Final report; scoring below is not tracked.
+    monitor.reset();
+
+    // In sample-major runs every algorithm spans the whole run; each is
+    // credited with the share of it that its own units took.
+    auto run_start = Clock::time_point::max();
+    auto run_end = Clock::time_point::min();
+    std::vector<double> unit_seconds(algorithms.size(), 0.0);
+    for (std::size_t algorithm_idx = 0; algorithm_idx < algorithms.size(); ++algorithm_idx) {
+        for (const auto &outcome : outcomes[algorithm_idx]) {
+            run_start = std::min(run_start, outcome.start);
+            run_end = std::max(run_end, outcome.end);
+            unit_seconds[algorithm_idx] += seconds_between(outcome.start, outcome.end);
+        }
+    }
+    const double total_unit_seconds =
+        std::accumulate(unit_seconds.begin(), unit_seconds.end(), 0.0);
+
+    for (std::size_t algorithm_idx = 0; algorithm_idx < algorithms.size(); ++algorithm_idx) {
+        const auto &algorithm_name = labels[algorithm_idx];
+        auto &sample_scores = results[algorithm_name];
+        sample_scores.resize(samples.size());
+
+        AlgorithmTiming *timing = nullptr;
+        if (timings != nullptr) {
+            timing = &(*timings)[algorithm_name];
+            timing->sample_seconds.assign(samples.size(),
+                                          std::numeric_limits<double>::quiet_NaN());
+            timing->sample_pairs.resize(samples.size());
+            timing->sample_iterations.assign(samples.size(), 0);
+            for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
+                const auto &sample = samples[sample_idx];
+                const auto clouds = sample.fragment_count();
+                timing->sample_pairs[sample_idx] =
+                    !sample.pairs.empty() ? sample.pairs.size() : (clouds > 0 ? clouds - 1 : 0);
+            }
         }
 
-        for (std::size_t sample_idx = 0; sample_idx < futures.size(); ++sample_idx) {
+        std::vector<std::vector<const UnitOutcome *>> sample_units(samples.size());
+        auto first_start = Clock::time_point::max();
+        auto last_end = Clock::time_point::min();
+        double registration_seconds = 0.0;
+        double metric_seconds = 0.0;
+        std::size_t iterations = 0;
+        std::size_t iterated_pairs = 0;
+        for (std::size_t unit_idx = 0; unit_idx < units.size(); ++unit_idx) {
+            const auto &outcome = outcomes[algorithm_idx][unit_idx];
+            sample_units[units[unit_idx].sample].emplace_back(&outcome);
+            first_start = std::min(first_start, outcome.start);
+            last_end = std::max(last_end, outcome.end);
+        }
+
+        // Units of a sample were created in group order, so the i-th unit of
+        // a pair sample is its i-th group.
+        for (std::size_t sample_idx = 0; sample_idx < samples.size(); ++sample_idx) {
             try {
-                sample_scores[sample_idx] = futures[sample_idx].get();
+                const auto &sample = samples[sample_idx];
+                MemoryBudget::Lease lease;
+                if (memory != nullptr && metrics_need_clouds) {
+                    std::vector<std::size_t> fragments(sample.fragment_count());
+                    std::iota(fragments.begin(), fragments.end(), std::size_t{0});
+                    lease = memory->admit(sample_idx, std::move(fragments));
+                }
+                PairRouteCounts routes;
+                double seconds = 0.0;
+                std::size_t sample_iterations = 0;
+                for (const auto *outcome : sample_units[sample_idx]) {
+                    if (outcome->error) {
+                        std::rethrow_exception(outcome->error);
+                    }
+                    routes.fallbacks += outcome->routes.fallbacks;
+                    routes.skipped += outcome->routes.skipped;
+                    seconds += seconds_between(outcome->start, outcome->end);
+                    sample_iterations += outcome->iterations;
+                }
+
+                std::vector<double> scores;
+                if (!pair_groups[sample_idx].empty()) {
+                    const auto &pairs = sample.pairs;
+                    std::vector<TransMat> estimated(pairs.size());
+                    std::vector<TransMat> ground_truth;
+                    ground_truth.reserve(pairs.size());
+                    for (const auto &pair : pairs) {
+                        ground_truth.emplace_back(pair.relative);
+                    }
+
+                    std::size_t failures = 0;
+                    std::vector<bool> skipped(pairs.size(), false);
+                    const auto &groups = pair_groups[sample_idx];
+                    for (std::size_t group_idx = 0; group_idx < groups.size(); ++group_idx) {
+                        const auto &group_outcome = *sample_units[sample_idx][group_idx];
+                        for (std::size_t idx = 0; idx < groups[group_idx].size(); ++idx) {
+                            estimated[groups[group_idx][idx]] = group_outcome.transforms[idx];
+                            skipped[groups[group_idx][idx]] =
+                                group_outcome.routes.skipped_pairs.at(idx);
+                        }
+                        failures += group_outcome.failures;
+                    }
+                    if (failures > 0) {
+                        LOG_WARN(ROLE_PROCESS, "{} of {} pairs failed in sample index {} with algorithm '{}'",
+                                 failures, pairs.size(), sample_idx, algorithm_name);
+                    }
+                    const auto metric_start = Clock::now();
+                    scores = evaluate_sample(metrics, estimated, ground_truth,
+                                             {&sample, true, routes.skipped > 0 ? &skipped : nullptr});
+                    metric_seconds += seconds_between(metric_start, Clock::now());
+                } else {
+                    const auto &outcome = *sample_units[sample_idx].front();
+                    const auto metric_start = Clock::now();
+                    scores = evaluate_sample(
+                        metrics, outcome.transforms, sample.world_transforms,
+                        {&sample, false, routes.skipped > 0 ? &outcome.routes.skipped_pairs : nullptr});
+                    metric_seconds += seconds_between(metric_start, Clock::now());
+                }
+                registration_seconds += seconds;
+                iterations += sample_iterations;
+                iterated_pairs += !sample.pairs.empty()
+                                      ? sample.pairs.size()
+                                      : (sample.fragment_count() > 0 ? sample.fragment_count() - 1 : 0);
+                if (routes.fallbacks > 0 || routes.skipped > 0) {
+                    LOG_INFO(ROLE_PROCESS, "Low overlap in sample index {} with algorithm '{}': "
+                             "{} pair(s) sent to the fallback, {} skipped and left out of pair scores",
+                             sample_idx, algorithm_name, routes.fallbacks, routes.skipped);
+                }
+
+                sample_scores[sample_idx] = std::move(scores);
+                // Drops what cloud-based metrics decoded again, and after the
+                // last algorithm the fragments they read.
+                if (metrics_need_clouds && !sample.compact_clouds.empty()) {
+                    sample.cache->clear();
+                }
+                if (memory != nullptr && metrics_need_clouds &&
+                    algorithm_idx + 1 == algorithms.size()) {
+                    lease = {};
+                    memory->retire(sample_idx);
+                }
+                if (timing != nullptr) {
+                    timing->sample_seconds[sample_idx] = seconds;
+                    timing->sample_iterations[sample_idx] = sample_iterations;
+                }
             } catch (const std::exception &e) {
                 LOG_ERROR(ROLE_PROCESS, "Error processing sample index {} with algorithm '{}': {}",
                           sample_idx, algorithm_name, e.what());
                 sample_scores[sample_idx] = {};
             }
         }
+
+        if (timing != nullptr && !sample_major) {
+            timing->wall_seconds = seconds_between(first_start, last_end);
+        } else if (timing != nullptr && total_unit_seconds > 0.0) {
+            timing->wall_seconds = seconds_between(run_start, run_end) *
+                                   unit_seconds[algorithm_idx] / total_unit_seconds;
+        }
+        // Compared across runs (see the baseline report), this is what a
+        // motion prior saves.
+        if (iterations > 0 && iterated_pairs > 0) {
+            LOG_INFO(ROLE_PROCESS, "Algorithm '{}' ran {:.2f} iterations per pair ({} in total) with motion prior '{}'",
+                     algorithm_name, static_cast<double>(iterations) / static_cast<double>(iterated_pairs),
+                     iterations, options.motion_prior.name());
+        }
+        // Cloud-based metrics are the expensive ones; keep their share visible.
+        if (registration_seconds > 0.0) {
+            LOG_INFO(ROLE_PROCESS, "Metrics for algorithm '{}' took {:.3f} s ({:.1f}% of registration time)",
+                     algorithm_name, metric_seconds, 100.0 * metric_seconds / registration_seconds);
+        }
+    }
+
+    if (memory != nullptr && !memory->bounded()) {
+        LOG_INFO(ROLE_PROCESS, "{} fragment(s) read as their tasks were scheduled",
+                 memory->stats().reloads);
+    } else if (memory != nullptr) {
+        const auto stats = memory->stats();
+        LOG_INFO(ROLE_PROCESS, "Memory budget {:.1f} MiB, estimated peak {:.1f} MiB: {} of {} task(s) waited "
+                 "{:.3f} s under memory pressure; {} fragment(s) released, {} reloaded, {} spilled",
+                 static_cast<double>(memory->options().budget_bytes) / (1 << 20),
+                 static_cast<double>(stats.peak_bytes) / (1 << 20), stats.waited_tasks, stats.tasks,
+                 stats.wait_seconds, stats.evictions, stats.reloads, stats.spilled_fragments);
+        if (stats.oversized_tasks > 0) {
+            LOG_WARN(ROLE_PROCESS, "{} task(s) exceeded the memory budget on their own and ran alone",
+                     stats.oversized_tasks);
+        }
     }
 
     return results;
@@ -150,7 +814,14 @@ void write_results_to_csv(const AlgorithmResults &results,
     }
 
     for (const auto &[algorithm_name, sample_scores] : results) {
-        const auto output_path = algorithm_name + "_result.csv";
+        // Sweep labels carry brackets, '=' and ';'; keep file names portable.
+        auto file_stem = algorithm_name;
+        for (auto &c : file_stem) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' && c != '_') {
+                c = '_';
+            }
+        }
+        const auto output_path = file_stem + "_result.csv";
         LOG_INFO(ROLE_PROCESS, "Writing results for algorithm '{}' to {}", algorithm_name,
                  output_path);
         std::ofstream csv_file(output_path);
@@ -178,3 +849,117 @@ void write_results_to_csv(const AlgorithmResults &results,
         }
     }
 }
+
+void write_results_store(const std::string &path, const std::string &run,
+                         const AlgorithmResults &results, const AlgorithmTimings &timings,
+                         const std::vector<std::string> &labels,
+                         const std::vector<AlgorithmVariant> &variants,
+                         const std::vector<std::shared_ptr<MetricBase>> &metrics) {
+    std::vector<ResultColumn> columns{{"run", ColumnType::String},
+                                      {"algorithm", ColumnType::String},
+                                      {"sample", ColumnType::Int64}};
+    constexpr std::size_t parameter_begin = 3;
+    // Swept names as the variants carry them; parameter i is column
+    // parameter_begin + i, whatever it is renamed to below.
+    std::vector<std::string> parameter_names;
+    for (const auto &variant : variants) {
+        for (const auto &[name, value] : variant.parameters) {
+            const auto type = value.is_number_integer() ? ColumnType::Int64
+                              : value.is_number()       ? ColumnType::Float64
+                                                        : ColumnType::String;
+            const auto found = std::find(parameter_names.begin(), parameter_names.end(), name);
+            if (found == parameter_names.end()) {
+                parameter_names.push_back(name);
+                columns.push_back({name, type});
+                continue;
+            }
+            auto &column = columns[parameter_begin + (found - parameter_names.begin())];
+            if (column.type != type) {
+                column.type = column.type != ColumnType::String && type != ColumnType::String
+                                  ? ColumnType::Float64
+                                  : ColumnType::String;
+            }
+        }
+    }
+    const std::size_t parameter_end = columns.size();
+    columns.push_back({"seconds", ColumnType::Float64});
+    columns.push_back({"pairs", ColumnType::Int64});
+    columns.push_back({"iterations", ColumnType::Int64});
+    for (const auto &metric : metrics) {
+        columns.push_back({metric->name(), ColumnType::Float64});
+    }
+    // A metric configured twice, or a parameter named like another column,
+    // still gets a column of its own. Parameters come last in line, so the
+    // fixed columns keep their names.
+    std::vector<std::size_t> order(parameter_begin);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    for (std::size_t idx = parameter_end; idx < columns.size(); ++idx) {
+        order.push_back(idx);
+    }
+    for (std::size_t idx = parameter_begin; idx < parameter_end; ++idx) {
+        order.push_back(idx);
+    }
+    std::vector<std::string> names;
+    for (const auto idx : order) {
+        names.push_back(columns[idx].name);
+    }
+    make_labels_unique(names);
+    for (std::size_t idx = 0; idx < order.size(); ++idx) {
+        columns[order[idx]].name = std::move(names[idx]);
+    }
+
+    LOG_INFO(ROLE_PROCESS, "Appending results of run '{}' to {}", run, path);
+    ResultStoreWriter writer(path, columns);
+    std::vector<ResultValue> row(columns.size());
+    for (std::size_t idx = 0; idx < labels.size(); ++idx) {
+        const auto found = results.find(labels[idx]);
+        if (found == results.end()) {
+            continue;
+        }
+        std::fill(row.begin(), row.end(), ResultValue{});
+        row[0] = run;
+        row[1] = labels[idx];
+        for (const auto &[name, value] : variants[idx].parameters) {
+            const auto column =
+                parameter_begin +
+                static_cast<std::size_t>(
+                    std::find(parameter_names.begin(), parameter_names.end(), name) -
+                    parameter_names.begin());
+            if (columns[column].type == ColumnType::String) {
+                row[column] = format_parameter_value(value);
+            } else if (value.is_number_integer()) {
+                row[column] = value.get<std::int64_t>();
+            } else {
+                row[column] = value.get<double>();
+            }
+        }
+
+        const auto timing = timings.find(labels[idx]);
+        const auto &sample_scores = found->second;
+        for (std::size_t sample_idx = 0; sample_idx < sample_scores.size(); ++sample_idx) {
+            row[2] = static_cast<std::int64_t>(sample_idx);
+            row[parameter_end] = ResultValue{};
+            row[parameter_end + 1] = ResultValue{};
+            row[parameter_end + 2] = ResultValue{};
+            if (timing != timings.end() && sample_idx < timing->second.sample_seconds.size()) {
+                const auto &sample_timing = timing->second;
+                row[parameter_end] = sample_timing.sample_seconds[sample_idx];
+                row[parameter_end + 1] =
+                    static_cast<std::int64_t>(sample_timing.sample_pairs[sample_idx]);
+                // Algorithms that report no iterations leave the cell missing.
+                if (sample_idx < sample_timing.sample_iterations.size() &&
+                    sample_timing.sample_iterations[sample_idx] > 0) {
+                    row[parameter_end + 2] =
+                        static_cast<std::int64_t>(sample_timing.sample_iterations[sample_idx]);
+                }
+            }
+            for (std::size_t metric_idx = 0; metric_idx < metrics.size(); ++metric_idx) {
+                const auto &scores = sample_scores[sample_idx];
+                row[parameter_end + 3 + metric_idx] =
+                    metric_idx < scores.size() ? ResultValue{scores[metric_idx]} : ResultValue{};
+            }
+            writer.append(row);
+        }
+    }
+    writer.flush();
+}
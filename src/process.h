@@ -1,29 +1,155 @@
 #pragma once
 
+#include "affinity.hpp"
 #include "algorithm/algorithm_base.hpp"
 #include "common.hpp"
 #include "dataset_loader/dataset_loader_base.hpp"
+#include "memory_budget.hpp"
 #include "metric/metric_base.hpp"
+#include "motion_prior.hpp"
+#include "overlap.hpp"
+#include "run_monitor.hpp"
 #include <memory>
 #include <map>
+#include <string>
 #include <vector>
 
-std::vector<TransMat> register_sample(AlgorithmBase &algorithm,
-                                      const std::vector<PointCloud> &point_clouds);
+// Pairs the overlap filter did not hand to the evaluated algorithm.
+struct PairRouteCounts {
+    std::size_t fallbacks{0};
+    std::size_t skipped{0};
+    // Whether each pair passed to add() was skipped, in the order added; what
+    // MetricContext::skipped is built from.
+    std::vector<bool> skipped_pairs;
+
+    void add(PairRoute route) {
+        fallbacks += route == PairRoute::Fallback ? 1 : 0;
+        skipped += route == PairRoute::Skipped ? 1 : 0;
+        skipped_pairs.push_back(route == PairRoute::Skipped);
+    }
+};
+
+// Registers each fragment of `sample` to the one before it and returns the
+// trajectory. Each pair starts from the guess `prior` predicts from the pairs
+// before it. The algorithm is handed all targets up front (prepare_targets).
+std::vector<TransMat> register_sample(AlgorithmBase &algorithm, const Sample &sample,
+                                      const OverlapFilter &filter = {},
+                                      PairRouteCounts *counts = nullptr,
+                                      const MotionPrior &prior = {});
+
+// Splits `pairs` into groups sharing a target fragment, sources sorted within
+// each group, so that a worker registers every pair against one target back
+// to back while that target and its search structures are hot.
+std::vector<std::vector<std::size_t>> schedule_pairs(const std::vector<FragmentPair> &pairs);
+
+// Registers the listed entries of `sample.pairs` in order and returns the
+// estimated source-to-target transforms.
+std::vector<TransMat> register_pairs(AlgorithmBase &algorithm,
+                                     const Sample &sample,
+                                     const std::vector<std::size_t> &pair_indices,
+                                     const OverlapFilter &filter = {},
+                                     PairRouteCounts *counts = nullptr);
+
+// register_pairs() for the single entry `pair_idx`, without building vectors.
+TransMat register_pair(AlgorithmBase &algorithm,
+                       const Sample &sample,
+                       std::size_t pair_idx,
+                       const OverlapFilter &filter = {},
+                       PairRouteCounts *counts = nullptr);
 
 std::vector<double> evaluate_sample(
     const std::vector<std::shared_ptr<MetricBase>> &metrics,
     const std::vector<TransMat> &estimated_transforms,
-    const std::vector<TransMat> &ground_truth_transforms);
+    const std::vector<TransMat> &ground_truth_transforms,
+    const MetricContext &context = {});
 
 using SampleScores = std::vector<std::vector<double>>;
 using AlgorithmResults = std::map<std::string, SampleScores>;
 
+struct AlgorithmTiming {
+    // Seconds spent registering and scoring each sample; NaN for failed samples.
+    std::vector<double> sample_seconds;
+    // Number of registered pairs per sample.
+    std::vector<std::size_t> sample_pairs;
+    // Iterations the algorithm reported per sample; 0 when it reports none.
+    std::vector<std::size_t> sample_iterations;
+    // Wall-clock time from the first submitted sample to the last finished one.
+    // Sample-major runs interleave every algorithm on the same workers, so
+    // there the run's wall time is split between the algorithms in
+    // proportion to their summed unit durations, keeping throughput
+    // comparable with algorithm-major runs.
+    double wall_seconds{0.0};
+};
+
+using AlgorithmTimings = std::map<std::string, AlgorithmTiming>;
+
+// Settings of the `runner` config section.
+struct RunnerOptions {
+    // Order in which (algorithm, sample) work is handed to the workers.
+    // Sample-major runs every algorithm on a sample back to back on one
+    // worker so that variants share its cached fragment data; Auto picks it
+    // when two algorithms are variants of the same method.
+    enum class Schedule { Auto, AlgorithmMajor, SampleMajor };
+
+    // Worker threads; 0 uses the hardware concurrency.
+    std::size_t threads{0};
+    OverlapFilter overlap;
+    Schedule schedule{Schedule::Auto};
+    // Combined table of every algorithm's per-sample scores.
+    std::string results_path{"results.csv"};
+    // Columnar store the run's rows are appended to ("results_store"); empty
+    // writes none. Rows are tagged with `run`, the start time by default.
+    std::string results_store;
+    std::string run;
+    // Pins workers per core or NUMA node and keeps each sample on one node's
+    // pool; "auto" scheduling then runs sample-major.
+    AffinityMode affinity{AffinityMode::None};
+    // With affinity on a multi-node machine, place_samples() moves each
+    // sample's clouds to the node that will process it.
+    bool first_touch{true};
+    // Ceiling on the estimated memory of loaded fragments and running tasks
+    // ("memory_budget", e.g. "8GiB"); with a zero budget_bytes fragments are
+    // still read as their tasks are scheduled, but nothing is evicted.
+    MemoryBudget::Options memory;
+    // Live status line and metrics textfile ("report"); an interval of 0
+    // falls back to the plain progress line.
+    RunMonitor::Options report;
+    // Initial guesses of sequential samples' pairs ("motion_prior").
+    MotionPrior motion_prior;
+
+    static RunnerOptions from_json(const nlohmann::json &config);
+};
+
+// Reallocates every sample's point buffers from a thread pinned to the NUMA
+// node that run_evaluation() will schedule it on. Does nothing without
+// affinity, with first_touch off or on a single-node machine.
+void place_samples(std::vector<Sample> &samples, const RunnerOptions &options);
+
+// With `memory`, which must be attached to `samples`, every task is admitted
+// through it and may wait until its fragments fit the budget, and a sample's
+// fragments are retired once its last task (or its scoring) is done.
 AlgorithmResults run_evaluation(
     const std::vector<std::shared_ptr<AlgorithmBase>> &algorithms,
     const std::vector<Sample> &samples,
     const std::vector<std::shared_ptr<MetricBase>> &metrics,
-    std::size_t thread_count_hint);
+    const RunnerOptions &options,
+    AlgorithmTimings *timings = nullptr,
+    MemoryBudget *memory = nullptr);
 
 void write_results_to_csv(const AlgorithmResults &results,
                           const std::vector<std::shared_ptr<MetricBase>> &metrics);
+
+struct AlgorithmVariant;
+
+// Appends one row per algorithm and sample to the columnar store at `path`
+// (see result_store.hpp): "run", "algorithm", "sample", the swept parameters
+// (sweep.hpp), "seconds", "pairs", "iterations" and the metrics, with failed
+// samples' metrics missing. A parameter or metric named like another column
+// gets a "#2"-style suffix; the fixed columns keep their names.
+// Swept parameters are Int64 or Float64 columns when every variant sets a
+// number, String columns otherwise.
+void write_results_store(const std::string &path, const std::string &run,
+                         const AlgorithmResults &results, const AlgorithmTimings &timings,
+                         const std::vector<std::string> &labels,
+                         const std::vector<AlgorithmVariant> &variants,
+                         const std::vector<std::shared_ptr<MetricBase>> &metrics);
@@ -0,0 +1,177 @@
+#include "registration_engine.hpp"
+#include "affinity.hpp"
+#include "logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+constexpr std::string_view ROLE_ENGINE{"engine"};
+
+std::string component_name(const nlohmann::json &config, const char *kind) {
+    if (!config.is_object() || !config.contains("name") || !config["name"].is_string()) {
+        throw std::invalid_argument(std::string("Each ") + kind +
+                                    " config must have a string 'name'");
+    }
+    return config["name"].get<std::string>();
+}
+
+unsigned int resolve_threads(std::size_t threads) {
+    if (threads > 0) {
+        return static_cast<unsigned int>(threads);
+    }
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+// Requests of a batch with their clouds numbered as fragments of one cache.
+struct Batch {
+    std::shared_ptr<AlgorithmBase> algorithm;
+    std::vector<RegistrationRequest> requests;
+    std::vector<std::size_t> source_slots;
+    std::vector<std::size_t> target_slots;
+    FragmentCache cache;
+
+    Batch(std::shared_ptr<AlgorithmBase> algorithm_, std::vector<RegistrationRequest> requests_)
+        : algorithm(std::move(algorithm_)), requests(std::move(requests_)) {
+        if (!algorithm) {
+            throw std::invalid_argument("RegistrationEngine: algorithm must not be null");
+        }
+        std::unordered_map<const PointCloud *, std::size_t> slots;
+        const auto slot_of = [&slots](const PointCloud *cloud) {
+            return slots.try_emplace(cloud, slots.size()).first->second;
+        };
+        source_slots.reserve(requests.size());
+        target_slots.reserve(requests.size());
+        for (const auto &request : requests) {
+            if (!request.source || !request.target) {
+                throw std::invalid_argument("RegistrationEngine: request without a cloud");
+            }
+            source_slots.emplace_back(slot_of(request.source.get()));
+            target_slots.emplace_back(slot_of(request.target.get()));
+        }
+    }
+
+    Fragment fragment(const PointCloud &cloud, const FragmentSlot &slot,
+                      std::size_t batch_index) {
+        if (slot.cache) {
+            return Fragment{cloud, slot.cache.get(), slot.index};
+        }
+        return Fragment{cloud, &cache, batch_index};
+    }
+
+    RegistrationResult run(std::size_t index) {
+        const auto &request = requests[index];
+        const auto start = std::chrono::steady_clock::now();
+        RegistrationResult result;
+        result.transform = request.initial_guess;
+        try {
+            result.transform = algorithm->register_fragments(
+                fragment(*request.source, request.source_slot, source_slots[index]),
+                fragment(*request.target, request.target_slot, target_slots[index]),
+                request.initial_guess);
+            result.success = true;
+        } catch (const std::exception &e) {
+            result.error = e.what();
+        }
+        result.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+} // namespace
+
+std::shared_ptr<AlgorithmBase> create_algorithm(const nlohmann::json &config) {
+    auto algorithm = algorithmManager.create(component_name(config, "algorithm"), config);
+    if (config.contains("label") && config["label"].is_string()) {
+        algorithm->set_label(config["label"].get<std::string>());
+    }
+    return algorithm;
+}
+
+std::shared_ptr<MetricBase> create_metric(const nlohmann::json &config) {
+    return metricManager.create(component_name(config, "metric"), config);
+}
+
+std::shared_ptr<DatasetLoaderBase> create_dataset_loader(const nlohmann::json &config) {
+    auto loader = datasetLoaderManager.create(component_name(config, "dataset loader"), config);
+    const auto bits = config.value("compact_bits", 0);
+    if (bits < 0 || bits > 16) {
+        throw std::invalid_argument("compact_bits must be between 0 and 16");
+    }
+    loader->set_compact_bits(bits);
+    return loader;
+}
+
+RegistrationEngine::RegistrationEngine(std::size_t threads)
+    : _pool(resolve_threads(threads), mark_pool_worker) {}
+
+std::size_t RegistrationEngine::thread_count() const {
+    return _pool.get_thread_count();
+}
+
+std::vector<std::future<RegistrationResult>>
+RegistrationEngine::submit(std::shared_ptr<AlgorithmBase> algorithm,
+                           std::vector<RegistrationRequest> requests) {
+    auto batch = std::make_shared<Batch>(std::move(algorithm), std::move(requests));
+    std::vector<std::future<RegistrationResult>> futures;
+    futures.reserve(batch->requests.size());
+    for (std::size_t index = 0; index < batch->requests.size(); ++index) {
+        futures.emplace_back(_pool.submit_task([batch, index]() { return batch->run(index); }));
+    }
+    return futures;
+}
+
+std::future<void> RegistrationEngine::submit(std::shared_ptr<AlgorithmBase> algorithm,
+                                             std::vector<RegistrationRequest> requests,
+                                             Callback on_result) {
+    struct Completion {
+        std::atomic<std::size_t> remaining;
+        std::promise<void> done;
+    };
+
+    auto batch = std::make_shared<Batch>(std::move(algorithm), std::move(requests));
+    auto completion = std::make_shared<Completion>();
+    completion->remaining = batch->requests.size();
+    auto finished = completion->done.get_future();
+    if (batch->requests.empty()) {
+        completion->done.set_value();
+        return finished;
+    }
+
+    auto callback = std::make_shared<Callback>(std::move(on_result));
+    for (std::size_t index = 0; index < batch->requests.size(); ++index) {
+        _pool.detach_task([this, batch, completion, callback, index]() {
+            const auto result = batch->run(index);
+            if (*callback) {
+                // A throwing callback must not take the pool down.
+                try {
+                    (*callback)(index, result);
+                } catch (const std::exception &e) {
+                    _callback_failures.fetch_add(1, std::memory_order_relaxed);
+                    LOG_WARN(ROLE_ENGINE, "Result callback for request {} threw: {}", index,
+                             e.what());
+                } catch (...) {
+                    _callback_failures.fetch_add(1, std::memory_order_relaxed);
+                    LOG_WARN(ROLE_ENGINE, "Result callback for request {} threw a non-exception",
+                             index);
+                }
+            }
+            if (completion->remaining.fetch_sub(1) == 1) {
+                completion->done.set_value();
+            }
+        });
+    }
+    return finished;
+}
+
+void RegistrationEngine::wait() {
+    _pool.wait();
+}
+
+std::size_t RegistrationEngine::callback_failures() const {
+    return _callback_failures.load(std::memory_order_relaxed);
+}
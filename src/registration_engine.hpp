@@ -0,0 +1,88 @@
+#pragma once
+
+#include "algorithm/algorithm_base.hpp"
+#include "common.hpp"
+#include "dataset_loader/dataset_loader_base.hpp"
+#include "metric/metric_base.hpp"
+#include <BS_thread_pool.hpp>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Creates a registered component from its config, which must contain a
+// string "name". Throws std::invalid_argument for a missing name and
+// std::runtime_error for an unknown one; the component may throw on bad
+// settings. An algorithm config may carry a string "label" to report results
+// under instead of the algorithm's name; a dataset loader config may set
+// "compact_bits" (1-16) to keep fragments quantized in memory.
+std::shared_ptr<AlgorithmBase> create_algorithm(const nlohmann::json &config);
+std::shared_ptr<MetricBase> create_metric(const nlohmann::json &config);
+std::shared_ptr<DatasetLoaderBase> create_dataset_loader(const nlohmann::json &config);
+
+// Cache entry owned by the caller for data derived from one cloud.
+struct FragmentSlot {
+    std::shared_ptr<FragmentCache> cache;
+    std::size_t index{0};
+};
+
+struct RegistrationRequest {
+    PointCloud::ConstPtr source;
+    PointCloud::ConstPtr target;
+    TransMat initial_guess{TransMat::Identity()};
+    // Set to keep a cloud's derived data beyond the batch, e.g. in a cache
+    // shared by many batches. Unset clouds use the batch's own cache.
+    FragmentSlot source_slot;
+    FragmentSlot target_slot;
+};
+
+struct RegistrationResult {
+    // Maps the source into the target frame; the initial guess on failure.
+    TransMat transform{TransMat::Identity()};
+    bool success{false};
+    std::string error;
+    double seconds{0.0};
+};
+
+// Runs registration requests concurrently on an internal pool. Requests of
+// one batch that share a cloud (by pointer) share its derived data, e.g. the
+// target's normals or search tree, as the fragments of a sample do. The
+// clouds must stay alive until their requests have finished.
+class RegistrationEngine {
+public:
+    // Called from worker threads with the position of the request in its
+    // batch, possibly concurrently.
+    using Callback = std::function<void(std::size_t index, const RegistrationResult &result)>;
+
+    // `threads` of 0 uses the hardware concurrency.
+    explicit RegistrationEngine(std::size_t threads = 0);
+
+    std::size_t thread_count() const;
+
+    // One future per request, in request order. Failures are reported in the
+    // result, never thrown from the future.
+    std::vector<std::future<RegistrationResult>>
+    submit(std::shared_ptr<AlgorithmBase> algorithm, std::vector<RegistrationRequest> requests);
+
+    // Reports every result through `on_result`; the returned future becomes
+    // ready once the whole batch has finished. An exception thrown by
+    // `on_result` is logged and counted (callback_failures()), and the batch
+    // goes on.
+    std::future<void> submit(std::shared_ptr<AlgorithmBase> algorithm,
+                             std::vector<RegistrationRequest> requests, Callback on_result);
+
+    // Blocks until every submitted request has finished.
+    void wait();
+
+    // Result callbacks that threw since the engine was created.
+    std::size_t callback_failures() const;
+
+private:
+    // Declared before the pool, whose workers update it until they are
+    // joined.
+    std::atomic<std::size_t> _callback_failures{0};
+    BS::thread_pool _pool;
+};
@@ -0,0 +1,662 @@
+#include "result_store.hpp"
+#include "logger.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+constexpr std::string_view ROLE_STORE{"result_store"};
+constexpr std::string_view MAGIC{"RGRSTORE"};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::size_t HEADER_BYTES = 16;
+
+constexpr std::size_t padded(std::size_t bytes) { return (bytes + 7) & ~std::size_t{7}; }
+
+template <typename T>
+void put(std::vector<char> &buffer, const T &value) {
+    const auto offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+void put_bytes(std::vector<char> &buffer, const void *data, std::size_t bytes) {
+    const auto offset = buffer.size();
+    buffer.resize(offset + bytes);
+    if (bytes > 0) {
+        std::memcpy(buffer.data() + offset, data, bytes);
+    }
+}
+
+void pad(std::vector<char> &buffer) { buffer.resize(padded(buffer.size()), '\0'); }
+
+// Bounds-checked cursor over a mapped chunk.
+class Cursor {
+public:
+    Cursor(const char *data, std::size_t size) : _data(data), _size(size) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const char *take(std::size_t bytes) {
+        if (bytes > _size - _offset) {
+            throw std::runtime_error("Corrupt result store chunk");
+        }
+        const char *data = _data + _offset;
+        _offset += bytes;
+        return data;
+    }
+
+    void align() { take(padded(_offset) - _offset); }
+
+private:
+    const char *_data;
+    std::size_t _size;
+    std::size_t _offset{0};
+};
+
+void check_header(const char *header, const std::filesystem::path &path) {
+    std::uint32_t version = 0;
+    std::uint32_t byte_order = 0;
+    std::memcpy(&version, header + MAGIC.size(), sizeof(version));
+    std::memcpy(&byte_order, header + MAGIC.size() + sizeof(version), sizeof(byte_order));
+    if (std::string_view(header, MAGIC.size()) != MAGIC) {
+        throw std::runtime_error("Not a result store: " + path.string());
+    }
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported result store version in " + path.string());
+    }
+    if (byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Result store was written with another byte order: " +
+                                 path.string());
+    }
+}
+
+// Size of the leading complete chunks of a store file of `size` bytes.
+std::size_t complete_bytes(std::ifstream &in, std::size_t size) {
+    std::size_t offset = HEADER_BYTES;
+    while (size - offset >= sizeof(std::uint64_t)) {
+        std::uint64_t payload = 0;
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char *>(&payload), sizeof(payload));
+        if (!in || payload > size - offset - sizeof(payload)) {
+            break;
+        }
+        offset += sizeof(payload) + payload;
+    }
+    return offset;
+}
+
+std::string format_number(double value) { return std::format("{}", value); }
+
+std::string quote(std::string_view value) {
+    if (value.find_first_of(",\"\n") == std::string_view::npos) {
+        return std::string(value);
+    }
+    std::string quoted = "\"";
+    for (const char c : value) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+// Text of row `row` of `column`; empty when missing.
+std::string cell_text(const ResultStoreReader::Column &column, std::size_t row) {
+    switch (column.type) {
+    case ColumnType::Int64: {
+        const auto value = column.integers()[row];
+        return value == MISSING_INT64 ? std::string{} : std::to_string(value);
+    }
+    case ColumnType::Float64: {
+        const auto value = column.reals()[row];
+        return std::isnan(value) ? std::string{} : format_number(value);
+    }
+    case ColumnType::String: {
+        const auto code = column.codes()[row];
+        return code == MISSING_STRING ? std::string{} : std::string(column.dictionary[code]);
+    }
+    }
+    return {};
+}
+
+// Distinct values of one group column, numbered in order of appearance.
+struct GroupValues {
+    bool numeric{false};
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<std::string> labels;
+    std::vector<double> numbers;
+
+    std::uint32_t intern(const std::string &label, double number) {
+        const auto [it, inserted] = ids.try_emplace(label, static_cast<std::uint32_t>(labels.size()));
+        if (inserted) {
+            labels.push_back(label);
+            numbers.push_back(number);
+        }
+        return it->second;
+    }
+
+    // Ids of every row of `column` (nullptr: missing in this chunk).
+    void chunk_ids(const ResultStoreReader::Column *column, std::size_t rows,
+                   std::vector<std::uint32_t> &out) {
+        out.resize(rows);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        if (column == nullptr) {
+            std::fill(out.begin(), out.end(), intern({}, nan));
+            return;
+        }
+        if (column->type == ColumnType::String) {
+            std::vector<std::uint32_t> code_ids(column->dictionary.size());
+            for (std::size_t code = 0; code < code_ids.size(); ++code) {
+                code_ids[code] = intern(std::string(column->dictionary[code]), nan);
+            }
+            const auto missing = intern({}, nan);
+            const auto *codes = column->codes();
+            for (std::size_t row = 0; row < rows; ++row) {
+                out[row] = codes[row] == MISSING_STRING ? missing : code_ids[codes[row]];
+            }
+            return;
+        }
+        // Numbers are formatted once per distinct value and chunk.
+        std::unordered_map<std::uint64_t, std::uint32_t> seen;
+        for (std::size_t row = 0; row < rows; ++row) {
+            const bool integer = column->type == ColumnType::Int64;
+            const std::uint64_t bits = integer ? static_cast<std::uint64_t>(column->integers()[row])
+                                               : std::bit_cast<std::uint64_t>(column->reals()[row]);
+            auto found = seen.find(bits);
+            if (found == seen.end()) {
+                const bool missing = integer ? column->integers()[row] == MISSING_INT64
+                                             : std::isnan(column->reals()[row]);
+                const double number = integer ? static_cast<double>(column->integers()[row])
+                                              : column->reals()[row];
+                const auto label = missing ? std::string{}
+                                   : integer ? std::to_string(column->integers()[row])
+                                             : format_number(number);
+                found = seen.emplace(bits, intern(label, missing ? nan : number)).first;
+            }
+            out[row] = found->second;
+        }
+    }
+
+    // Numeric columns sort by value, missing values first.
+    bool less(std::uint32_t a, std::uint32_t b) const {
+        if (!numeric) {
+            return labels[a] < labels[b];
+        }
+        const double x = numbers[a];
+        const double y = numbers[b];
+        if (std::isnan(x) || std::isnan(y)) {
+            return std::isnan(x) && !std::isnan(y);
+        }
+        return x < y;
+    }
+};
+} // namespace
+
+ResultStoreWriter::ResultStoreWriter(const std::filesystem::path &path,
+                                     std::vector<ResultColumn> columns, std::size_t chunk_rows)
+    : _columns(std::move(columns)), _buffers(_columns.size()),
+      _chunk_rows(std::max<std::size_t>(chunk_rows, 1)) {
+    std::unordered_set<std::string> names;
+    for (const auto &column : _columns) {
+        if (!names.insert(column.name).second) {
+            throw std::invalid_argument("Duplicate result store column '" + column.name + "'");
+        }
+    }
+
+    std::error_code error;
+    const auto size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path) : 0;
+    if (size > 0) {
+        std::ifstream in(path, std::ios::binary);
+        char header[HEADER_BYTES] = {};
+        if (!in.read(header, HEADER_BYTES)) {
+            throw std::runtime_error("Not a result store: " + path.string());
+        }
+        check_header(header, path);
+        const auto complete = complete_bytes(in, size);
+        in.close();
+        if (complete < size) {
+            LOG_WARN(ROLE_STORE, "Dropping {} byte(s) of an incomplete chunk at the end of {}",
+                     size - complete, path.string());
+            std::filesystem::resize_file(path, complete);
+        }
+    }
+
+    _file.open(path, std::ios::binary | std::ios::app);
+    if (!_file.is_open()) {
+        throw std::runtime_error("Failed to open result store: " + path.string());
+    }
+    if (size == 0) {
+        std::vector<char> header;
+        put_bytes(header, MAGIC.data(), MAGIC.size());
+        put(header, VERSION);
+        put(header, BYTE_ORDER_MARK);
+        _file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+}
+
+ResultStoreWriter::~ResultStoreWriter() {
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        LOG_ERROR(ROLE_STORE, "Failed to write result store chunk: {}", e.what());
+    }
+}
+
+void ResultStoreWriter::append(const std::vector<ResultValue> &row) {
+    if (row.size() != _columns.size()) {
+        throw std::invalid_argument(std::format("Result row has {} value(s) for {} column(s)",
+                                                row.size(), _columns.size()));
+    }
+    for (std::size_t idx = 0; idx < _columns.size(); ++idx) {
+        const auto &value = row[idx];
+        auto &buffer = _buffers[idx];
+        const auto mismatch = [this, idx]() {
+            return std::invalid_argument("Wrong value type for result store column '" +
+                                         _columns[idx].name + "'");
+        };
+        switch (_columns[idx].type) {
+        case ColumnType::Int64:
+            if (const auto *integer = std::get_if<std::int64_t>(&value)) {
+                buffer.integers.push_back(*integer);
+            } else if (const auto *real = std::get_if<double>(&value)) {
+                buffer.integers.push_back(std::isfinite(*real) ? std::llround(*real)
+                                                                : MISSING_INT64);
+            } else if (std::holds_alternative<std::monostate>(value)) {
+                buffer.integers.push_back(MISSING_INT64);
+            } else {
+                throw mismatch();
+            }
+            break;
+        case ColumnType::Float64:
+            if (const auto *integer = std::get_if<std::int64_t>(&value)) {
+                buffer.reals.push_back(static_cast<double>(*integer));
+            } else if (const auto *real = std::get_if<double>(&value)) {
+                buffer.reals.push_back(*real);
+            } else if (std::holds_alternative<std::monostate>(value)) {
+                buffer.reals.push_back(std::numeric_limits<double>::quiet_NaN());
+            } else {
+                throw mismatch();
+            }
+            break;
+        case ColumnType::String:
+            if (const auto *text = std::get_if<std::string>(&value)) {
+                const auto [found, inserted] = buffer.lookup.try_emplace(
+                    *text, static_cast<std::uint32_t>(buffer.dictionary.size()));
+                if (inserted) {
+                    buffer.dictionary.push_back(*text);
+                }
+                buffer.codes.push_back(found->second);
+            } else if (std::holds_alternative<std::monostate>(value)) {
+                buffer.codes.push_back(MISSING_STRING);
+            } else {
+                throw mismatch();
+            }
+            break;
+        }
+    }
+    if (++_buffered_rows >= _chunk_rows) {
+        flush();
+    }
+}
+
+void ResultStoreWriter::flush() {
+    if (_buffered_rows == 0) {
+        return;
+    }
+    std::vector<char> chunk;
+    put(chunk, std::uint64_t{0});
+    put(chunk, static_cast<std::uint64_t>(_buffered_rows));
+    put(chunk, static_cast<std::uint32_t>(_columns.size()));
+    put(chunk, std::uint32_t{0});
+    for (std::size_t idx = 0; idx < _columns.size(); ++idx) {
+        const auto &column = _columns[idx];
+        auto &buffer = _buffers[idx];
+        put(chunk, static_cast<std::uint32_t>(column.type));
+        put(chunk, static_cast<std::uint32_t>(column.name.size()));
+        put_bytes(chunk, column.name.data(), column.name.size());
+        pad(chunk);
+        switch (column.type) {
+        case ColumnType::Int64:
+            put_bytes(chunk, buffer.integers.data(), buffer.integers.size() * sizeof(std::int64_t));
+            break;
+        case ColumnType::Float64:
+            put_bytes(chunk, buffer.reals.data(), buffer.reals.size() * sizeof(double));
+            break;
+        case ColumnType::String:
+            put(chunk, static_cast<std::uint32_t>(buffer.dictionary.size()));
+            put(chunk, std::uint32_t{0});
+            for (const auto &entry : buffer.dictionary) {
+                put(chunk, static_cast<std::uint32_t>(entry.size()));
+                put_bytes(chunk, entry.data(), entry.size());
+            }
+            pad(chunk);
+            put_bytes(chunk, buffer.codes.data(), buffer.codes.size() * sizeof(std::uint32_t));
+            pad(chunk);
+            break;
+        }
+        buffer = {};
+    }
+    const std::uint64_t payload = chunk.size() - sizeof(std::uint64_t);
+    std::memcpy(chunk.data(), &payload, sizeof(payload));
+
+    // One write per chunk; a torn one is detected by its payload size.
+    _file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    _file.flush();
+    if (!_file) {
+        throw std::runtime_error("Failed to write result store chunk");
+    }
+    _rows_written += _buffered_rows;
+    _buffered_rows = 0;
+}
+
+const ResultStoreReader::Column *ResultStoreReader::Chunk::find(std::string_view name) const {
+    for (const auto &column : columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+ResultStoreReader::ResultStoreReader(const std::filesystem::path &path) : _file(path) {
+    if (_file.size() < HEADER_BYTES) {
+        throw std::runtime_error("Not a result store: " + path.string());
+    }
+    check_header(_file.data(), path);
+
+    std::size_t offset = HEADER_BYTES;
+    while (_file.size() - offset >= sizeof(std::uint64_t)) {
+        std::uint64_t payload = 0;
+        std::memcpy(&payload, _file.data() + offset, sizeof(payload));
+        offset += sizeof(payload);
+        if (payload > _file.size() - offset) {
+            LOG_WARN(ROLE_STORE, "Ignoring an incomplete chunk at the end of {}", path.string());
+            break;
+        }
+        Cursor cursor(_file.data() + offset, payload);
+        offset += payload;
+
+        Chunk chunk;
+        chunk.rows = cursor.get<std::uint64_t>();
+        const auto column_count = cursor.get<std::uint32_t>();
+        cursor.get<std::uint32_t>();
+        chunk.columns.resize(column_count);
+        for (auto &column : chunk.columns) {
+            column.type = static_cast<ColumnType>(cursor.get<std::uint32_t>());
+            const auto name_length = cursor.get<std::uint32_t>();
+            column.name = std::string_view(cursor.take(name_length), name_length);
+            cursor.align();
+            switch (column.type) {
+            case ColumnType::Int64:
+            case ColumnType::Float64:
+                column.data = cursor.take(chunk.rows * sizeof(std::int64_t));
+                break;
+            case ColumnType::String: {
+                const auto entries = cursor.get<std::uint32_t>();
+                cursor.get<std::uint32_t>();
+                column.dictionary.reserve(entries);
+                for (std::uint32_t entry = 0; entry < entries; ++entry) {
+                    const auto length = cursor.get<std::uint32_t>();
+                    column.dictionary.emplace_back(cursor.take(length), length);
+                }
+                cursor.align();
+                column.data = cursor.take(chunk.rows * sizeof(std::uint32_t));
+                cursor.align();
+                const auto *codes = column.codes();
+                for (std::size_t row = 0; row < chunk.rows; ++row) {
+                    if (codes[row] != MISSING_STRING && codes[row] >= entries) {
+                        throw std::runtime_error("Corrupt result store chunk");
+                    }
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown column type in result store " + path.string());
+            }
+        }
+        _chunks.push_back(std::move(chunk));
+    }
+}
+
+std::size_t ResultStoreReader::rows() const {
+    std::size_t rows = 0;
+    for (const auto &chunk : _chunks) {
+        rows += chunk.rows;
+    }
+    return rows;
+}
+
+std::vector<ResultColumn> ResultStoreReader::columns() const {
+    std::vector<ResultColumn> columns;
+    for (const auto &chunk : _chunks) {
+        for (const auto &column : chunk.columns) {
+            const auto found = std::find_if(columns.begin(), columns.end(),
+                                            [&column](const auto &c) { return c.name == column.name; });
+            if (found == columns.end()) {
+                columns.push_back({std::string(column.name), column.type});
+            } else if (found->type != column.type && column.type != ColumnType::String &&
+                       found->type != ColumnType::String) {
+                // Integer in one run, fractional in another.
+                found->type = ColumnType::Float64;
+            }
+        }
+    }
+    return columns;
+}
+
+QueryResult query_results(const ResultStoreReader &store, const ResultQuery &query) {
+    const auto columns = store.columns();
+    const auto column_type = [&columns](const std::string &name) {
+        const auto found = std::find_if(columns.begin(), columns.end(),
+                                        [&name](const auto &c) { return c.name == name; });
+        if (found == columns.end()) {
+            throw std::invalid_argument("Unknown result column '" + name + "'");
+        }
+        return found->type;
+    };
+
+    QueryResult result;
+    result.group_by = query.group_by;
+    result.percentiles = query.percentiles;
+    for (const auto p : query.percentiles) {
+        if (!(p >= 0.0 && p <= 100.0)) {
+            throw std::invalid_argument("Percentiles must lie in [0, 100]");
+        }
+    }
+    std::vector<GroupValues> group_values(query.group_by.size());
+    for (std::size_t idx = 0; idx < query.group_by.size(); ++idx) {
+        group_values[idx].numeric = column_type(query.group_by[idx]) != ColumnType::String;
+    }
+    if (query.values.empty()) {
+        for (const auto &column : columns) {
+            if (column.type != ColumnType::String &&
+                std::find(query.group_by.begin(), query.group_by.end(), column.name) ==
+                    query.group_by.end()) {
+                result.values.push_back(column.name);
+            }
+        }
+    } else {
+        for (const auto &name : query.values) {
+            if (column_type(name) == ColumnType::String) {
+                throw std::invalid_argument("Result column '" + name + "' is not numeric");
+            }
+        }
+        result.values = query.values;
+    }
+
+    struct GroupState {
+        std::vector<std::uint32_t> key;
+        std::size_t rows{0};
+        std::vector<std::vector<double>> values;
+    };
+    std::vector<GroupState> groups;
+    std::unordered_map<std::string, std::size_t> group_index;
+
+    std::vector<std::vector<std::uint32_t>> row_ids(query.group_by.size());
+    std::vector<const ResultStoreReader::Column *> value_columns(result.values.size());
+    std::string key(query.group_by.size() * sizeof(std::uint32_t), '\0');
+    for (const auto &chunk : store.chunks()) {
+        for (std::size_t idx = 0; idx < query.group_by.size(); ++idx) {
+            group_values[idx].chunk_ids(chunk.find(query.group_by[idx]), chunk.rows, row_ids[idx]);
+        }
+        for (std::size_t idx = 0; idx < result.values.size(); ++idx) {
+            value_columns[idx] = chunk.find(result.values[idx]);
+        }
+
+        for (std::size_t row = 0; row < chunk.rows; ++row) {
+            for (std::size_t idx = 0; idx < row_ids.size(); ++idx) {
+                std::memcpy(key.data() + idx * sizeof(std::uint32_t), &row_ids[idx][row],
+                            sizeof(std::uint32_t));
+            }
+            auto found = group_index.find(key);
+            if (found == group_index.end()) {
+                GroupState state;
+                for (const auto &ids : row_ids) {
+                    state.key.push_back(ids[row]);
+                }
+                state.values.resize(result.values.size());
+                groups.push_back(std::move(state));
+                found = group_index.emplace(key, groups.size() - 1).first;
+            }
+            auto &group = groups[found->second];
+            ++group.rows;
+            for (std::size_t idx = 0; idx < value_columns.size(); ++idx) {
+                const auto *column = value_columns[idx];
+                if (column == nullptr || column->type == ColumnType::String) {
+                    continue;
+                }
+                if (column->type == ColumnType::Int64) {
+                    if (column->integers()[row] != MISSING_INT64) {
+                        group.values[idx].push_back(static_cast<double>(column->integers()[row]));
+                    }
+                } else if (!std::isnan(column->reals()[row])) {
+                    group.values[idx].push_back(column->reals()[row]);
+                }
+            }
+        }
+    }
+
+    std::sort(groups.begin(), groups.end(), [&group_values](const auto &a, const auto &b) {
+        for (std::size_t idx = 0; idx < group_values.size(); ++idx) {
+            if (a.key[idx] != b.key[idx]) {
+                return group_values[idx].less(a.key[idx], b.key[idx]);
+            }
+        }
+        return false;
+    });
+
+    result.groups.reserve(groups.size());
+    for (auto &state : groups) {
+        QueryResult::Group group;
+        group.rows = state.rows;
+        for (std::size_t idx = 0; idx < state.key.size(); ++idx) {
+            group.key.push_back(group_values[idx].labels[state.key[idx]]);
+        }
+        for (auto &values : state.values) {
+            ValueSummary summary;
+            summary.count = values.size();
+            if (!values.empty()) {
+                double sum = 0.0;
+                for (const auto value : values) {
+                    sum += value;
+                }
+                summary.mean = sum / static_cast<double>(values.size());
+                const auto [min, max] = std::minmax_element(values.begin(), values.end());
+                summary.min = *min;
+                summary.max = *max;
+                for (const auto p : query.percentiles) {
+                    summary.percentiles.push_back(percentile_in_place(values, p / 100.0));
+                }
+            }
+            values = {};
+            group.values.push_back(std::move(summary));
+        }
+        result.groups.push_back(std::move(group));
+    }
+    return result;
+}
+
+void write_query_csv(const QueryResult &result, std::ostream &out) {
+    bool first = true;
+    const auto cell = [&out, &first](std::string_view text) {
+        if (!first) {
+            out << ',';
+        }
+        first = false;
+        out << quote(text);
+    };
+
+    for (const auto &name : result.group_by) {
+        cell(name);
+    }
+    cell("rows");
+    for (const auto &name : result.values) {
+        for (const auto *statistic : {"count", "mean", "min", "max"}) {
+            cell(name + ":" + statistic);
+        }
+        for (const auto p : result.percentiles) {
+            cell(std::format("{}:p{}", name, p));
+        }
+    }
+    out << '\n';
+
+    for (const auto &group : result.groups) {
+        first = true;
+        for (const auto &value : group.key) {
+            cell(value);
+        }
+        cell(std::to_string(group.rows));
+        for (const auto &summary : group.values) {
+            cell(std::to_string(summary.count));
+            // Groups without values keep their statistics empty.
+            const bool empty = summary.count == 0;
+            for (const auto value : {summary.mean, summary.min, summary.max}) {
+                cell(empty ? std::string{} : format_number(value));
+            }
+            for (std::size_t idx = 0; idx < result.percentiles.size(); ++idx) {
+                cell(empty ? std::string{} : format_number(summary.percentiles[idx]));
+            }
+        }
+        out << '\n';
+    }
+}
+
+void export_results_csv(const ResultStoreReader &store, std::ostream &out) {
+    const auto columns = store.columns();
+    for (std::size_t idx = 0; idx < columns.size(); ++idx) {
+        out << (idx > 0 ? "," : "") << quote(columns[idx].name);
+    }
+    out << '\n';
+
+    std::vector<const ResultStoreReader::Column *> chunk_columns(columns.size());
+    for (const auto &chunk : store.chunks()) {
+        for (std::size_t idx = 0; idx < columns.size(); ++idx) {
+            chunk_columns[idx] = chunk.find(columns[idx].name);
+        }
+        for (std::size_t row = 0; row < chunk.rows; ++row) {
+            for (std::size_t idx = 0; idx < columns.size(); ++idx) {
+                if (idx > 0) {
+                    out << ',';
+                }
+                if (chunk_columns[idx] != nullptr) {
+                    out << quote(cell_text(*chunk_columns[idx], row));
+                }
+            }
+            out << '\n';
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Columnar store of result rows. A store file is a header followed by
+// self-contained chunks, each holding a batch of rows column by column:
+//
+//   header:  "RGRSTORE", u32 version, u32 byte-order mark
+//   chunk:   u64 payload bytes, u64 rows, u32 columns, u32 reserved, then
+//            per column: u32 type, u32 name length, name,
+//                        Int64/Float64: one 8-byte value per row,
+//                        String: u32 dictionary size, u32 reserved,
+//                                (u32 length, bytes) per entry, u32 code per row
+//
+// Every section is padded to 8 bytes, so a mapped file is read in place.
+// Chunks are only ever appended, and columns are matched by name across
+// chunks, so successive runs (or runs with different variants and metrics)
+// can extend one store; a column a chunk lacks reads as missing.
+enum class ColumnType : std::uint32_t { Int64 = 1, Float64 = 2, String = 3 };
+
+struct ResultColumn {
+    std::string name;
+    ColumnType type{ColumnType::Float64};
+};
+
+// Missing cells: NaN in Float64 columns, these in the others.
+inline constexpr std::int64_t MISSING_INT64 = std::numeric_limits<std::int64_t>::min();
+inline constexpr std::uint32_t MISSING_STRING = std::numeric_limits<std::uint32_t>::max();
+
+// One cell of a row; monostate is a missing value.
+using ResultValue = std::variant<std::monostate, std::int64_t, double, std::string>;
+
+// Appends rows to a store, creating it if needed. Rows are buffered and
+// written as one chunk every `chunk_rows` rows and on flush() or
+// destruction; a chunk left incomplete by a crash is dropped when the store
+// is next opened for appending.
+class ResultStoreWriter {
+public:
+    ResultStoreWriter(const std::filesystem::path &path, std::vector<ResultColumn> columns,
+                      std::size_t chunk_rows = 65536);
+    ~ResultStoreWriter();
+
+    ResultStoreWriter(const ResultStoreWriter &) = delete;
+    ResultStoreWriter &operator=(const ResultStoreWriter &) = delete;
+
+    // `row` holds one value per column; numbers are converted to the
+    // column's type. Throws std::invalid_argument on a mismatch.
+    void append(const std::vector<ResultValue> &row);
+    void flush();
+
+    std::size_t rows_written() const { return _rows_written; }
+
+private:
+    struct ColumnBuffer {
+        std::vector<std::int64_t> integers;
+        std::vector<double> reals;
+        std::vector<std::uint32_t> codes;
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, std::uint32_t> lookup;
+    };
+
+    std::vector<ResultColumn> _columns;
+    std::vector<ColumnBuffer> _buffers;
+    std::size_t _chunk_rows;
+    std::size_t _buffered_rows{0};
+    std::size_t _rows_written{0};
+    std::ofstream _file;
+};
+
+// Read-only view of a store, mapped in place.
+class ResultStoreReader {
+public:
+    struct Column {
+        std::string_view name;
+        ColumnType type{ColumnType::Float64};
+        // Int64/Float64: the values. String: the per-row dictionary codes.
+        const void *data{nullptr};
+        std::vector<std::string_view> dictionary;
+
+        const std::int64_t *integers() const { return static_cast<const std::int64_t *>(data); }
+        const double *reals() const { return static_cast<const double *>(data); }
+        const std::uint32_t *codes() const { return static_cast<const std::uint32_t *>(data); }
+    };
+
+    struct Chunk {
+        std::size_t rows{0};
+        std::vector<Column> columns;
+
+        // nullptr when the chunk has no column `name`.
+        const Column *find(std::string_view name) const;
+    };
+
+    explicit ResultStoreReader(const std::filesystem::path &path);
+
+    const std::vector<Chunk> &chunks() const { return _chunks; }
+    std::size_t rows() const;
+    // Union of the chunks' columns in order of first appearance.
+    std::vector<ResultColumn> columns() const;
+
+private:
+    MappedFile _file;
+    std::vector<Chunk> _chunks;
+};
+
+// Grouped aggregation over a store: rows are grouped by the values of
+// `group_by` and every column of `values` (all numeric columns outside
+// `group_by` when empty) is summarized per group. Missing values are ignored.
+struct ResultQuery {
+    std::vector<std::string> group_by{"algorithm"};
+    std::vector<std::string> values;
+    // Percentiles in [0, 100], linearly interpolated.
+    std::vector<double> percentiles{50.0, 90.0, 99.0};
+};
+
+struct ValueSummary {
+    std::size_t count{0};
+    double mean{0.0};
+    double min{0.0};
+    double max{0.0};
+    std::vector<double> percentiles;
+};
+
+struct QueryResult {
+    struct Group {
+        std::vector<std::string> key;
+        std::size_t rows{0};
+        std::vector<ValueSummary> values;
+    };
+
+    std::vector<std::string> group_by;
+    std::vector<std::string> values;
+    std::vector<double> percentiles;
+    // Sorted by key.
+    std::vector<Group> groups;
+};
+
+// Streams the chunks once; only the values of each group are kept, for the
+// percentiles. Throws std::invalid_argument for unknown or non-numeric
+// columns.
+QueryResult query_results(const ResultStoreReader &store, const ResultQuery &query);
+
+// One row per group: the group columns, "rows", then count, mean, min, max
+// and the percentiles of every value column.
+void write_query_csv(const QueryResult &result, std::ostream &out);
+
+// The whole store as CSV over the union of its columns, missing cells empty.
+void export_results_csv(const ResultStoreReader &store, std::ostream &out);
@@ -0,0 +1,273 @@
+#include "run_monitor.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace {
+constexpr std::string_view ROLE_MONITOR{"monitor"};
+
+// Distinguishes monitors for the workers' cached slot, even when a new one
+// reuses an old one's address.
+std::atomic<std::uint64_t> monitor_generation{0};
+
+std::string format_duration(double seconds) {
+    if (!std::isfinite(seconds)) {
+        return "--:--:--";
+    }
+    const auto total = static_cast<long long>(std::llround(seconds));
+    return std::format("{:02}:{:02}:{:02}", total / 3600, total / 60 % 60, total % 60);
+}
+
+// Label values escape backslashes, quotes and newlines.
+std::string escape_label(std::string_view value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+} // namespace
+
+RunMonitor::Options RunMonitor::Options::from_json(const nlohmann::json &config) {
+    Options options;
+    options.interval_seconds = config.value("interval", options.interval_seconds);
+    options.status_line = config.value("status_line", options.status_line);
+    options.textfile = config.value("textfile", options.textfile);
+    if (!(options.interval_seconds >= 0.0)) {
+        throw std::invalid_argument("runner.report.interval must not be negative");
+    }
+    return options;
+}
+
+RunMonitor::Task::Task(Task &&other) noexcept
+    : _monitor(std::exchange(other._monitor, nullptr)), _slot(other._slot),
+      _pairs(other._pairs) {}
+
+RunMonitor::Task::~Task() {
+    if (_monitor != nullptr) {
+        _monitor->finish(*this);
+    }
+}
+
+RunMonitor::RunMonitor(Options options, std::vector<std::string> labels, std::size_t workers,
+                       std::size_t total_tasks, std::size_t total_pairs)
+    : _options(std::move(options)), _labels(std::move(labels)), _total_tasks(total_tasks),
+      _total_pairs(total_pairs), _start(Clock::now()), _generation(++monitor_generation),
+      _slots(std::make_unique<Slot[]>(std::max<std::size_t>(workers, 1))),
+      _slot_count(std::max<std::size_t>(workers, 1)), _last_busy_ns(_slot_count, 0) {
+    if (_options.interval_seconds > 0.0) {
+        _reporter = std::thread([this]() { run(); });
+    }
+}
+
+RunMonitor::~RunMonitor() {
+    if (!_reporter.joinable()) {
+        return;
+    }
+    {
+        std::scoped_lock lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    _reporter.join();
+}
+
+RunMonitor::Task RunMonitor::begin(std::size_t algorithm, std::size_t sample, std::size_t pairs) {
+    const auto index = slot();
+    auto &state = _slots[index];
+    state.algorithm.store(static_cast<std::uint32_t>(algorithm), std::memory_order_relaxed);
+    state.sample.store(static_cast<std::uint32_t>(sample), std::memory_order_relaxed);
+    state.started_ns.store(now_ns() + 1, std::memory_order_release);
+    _started_tasks.fetch_add(1, std::memory_order_relaxed);
+    return Task(this, index, pairs);
+}
+
+std::int64_t RunMonitor::now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _start).count();
+}
+
+std::size_t RunMonitor::slot() {
+    thread_local std::uint64_t generation = 0;
+    thread_local std::size_t index = 0;
+    if (generation != _generation) {
+        generation = _generation;
+        index = _next_slot.fetch_add(1, std::memory_order_relaxed) % _slot_count;
+    }
+    return index;
+}
+
+void RunMonitor::finish(const Task &task) {
+    auto &state = _slots[task._slot];
+    const auto started = state.started_ns.exchange(0, std::memory_order_acq_rel);
+    if (started > 0) {
+        state.busy_ns.fetch_add(now_ns() - (started - 1), std::memory_order_release);
+    }
+    _completed_pairs.fetch_add(task._pairs, std::memory_order_relaxed);
+    _completed_tasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunMonitor::run() {
+    const auto interval = std::chrono::duration<double>(_options.interval_seconds);
+    std::unique_lock lock(_mutex);
+    while (!_wake.wait_for(lock, interval, [this]() { return _stopping; })) {
+        const auto snapshot = sample();
+        render(snapshot, false);
+        write_textfile(snapshot);
+    }
+    const auto snapshot = sample();
+    render(snapshot, true);
+    write_textfile(snapshot);
+}
+
+RunMonitor::Snapshot RunMonitor::sample() {
+    Snapshot snapshot;
+    const auto now = now_ns();
+    const double since_last = static_cast<double>(now - _last_sample_ns) * 1e-9;
+    snapshot.elapsed_seconds = static_cast<double>(now) * 1e-9;
+    snapshot.completed_tasks = _completed_tasks.load(std::memory_order_relaxed);
+    snapshot.completed_pairs = _completed_pairs.load(std::memory_order_relaxed);
+    const auto started = _started_tasks.load(std::memory_order_relaxed);
+    snapshot.queued_tasks = _total_tasks - std::min(started, _total_tasks);
+
+    // Rate over the last interval; the ETA uses the run's average, which is
+    // steadier than one interval of mixed task sizes.
+    if (since_last > 0.0) {
+        snapshot.pairs_per_second =
+            static_cast<double>(snapshot.completed_pairs - _last_pairs) / since_last;
+    }
+    const auto remaining = _total_pairs - std::min(snapshot.completed_pairs, _total_pairs);
+    snapshot.eta_seconds = snapshot.completed_pairs > 0
+                               ? static_cast<double>(remaining) * snapshot.elapsed_seconds /
+                                     static_cast<double>(snapshot.completed_pairs)
+                               : std::numeric_limits<double>::quiet_NaN();
+
+    snapshot.busy_ratio.resize(_slot_count);
+    for (std::size_t idx = 0; idx < _slot_count; ++idx) {
+        const auto &state = _slots[idx];
+        const auto running = state.started_ns.load(std::memory_order_acquire);
+        std::int64_t busy = state.busy_ns.load(std::memory_order_acquire);
+        // Still the same task after reading busy_ns, so its time is not in
+        // there yet.
+        if (running > 0 && state.started_ns.load(std::memory_order_acquire) == running) {
+            const auto age = now - (running - 1);
+            busy += age;
+            const double seconds = static_cast<double>(age) * 1e-9;
+            if (seconds > snapshot.slowest_seconds) {
+                snapshot.slowest_seconds = seconds;
+                snapshot.slowest_algorithm = state.algorithm.load(std::memory_order_relaxed);
+                snapshot.slowest_sample = state.sample.load(std::memory_order_relaxed);
+            }
+        }
+        snapshot.busy_ratio[idx] =
+            since_last > 0.0
+                ? std::clamp(static_cast<double>(busy - _last_busy_ns[idx]) * 1e-9 / since_last,
+                             0.0, 1.0)
+                : 0.0;
+        _last_busy_ns[idx] = busy;
+    }
+    _last_sample_ns = now;
+    _last_pairs = snapshot.completed_pairs;
+    return snapshot;
+}
+
+void RunMonitor::render(const Snapshot &snapshot, bool last) const {
+    if (!_options.status_line) {
+        return;
+    }
+    double busy = 0.0;
+    double least_busy = 1.0;
+    for (const auto ratio : snapshot.busy_ratio) {
+        busy += ratio;
+        least_busy = std::min(least_busy, ratio);
+    }
+    busy /= static_cast<double>(snapshot.busy_ratio.size());
+
+    const double percent = _total_tasks > 0 ? 100.0 * static_cast<double>(snapshot.completed_tasks) /
+                                                  static_cast<double>(_total_tasks)
+                                            : 100.0;
+    auto line = std::format("Progress: {:6.2f}% ({}/{}) | {:.1f} pairs/s | ETA {} | busy {:.0f}% "
+                            "(min {:.0f}%) | queued {}",
+                            percent, snapshot.completed_tasks, _total_tasks,
+                            snapshot.pairs_per_second, format_duration(snapshot.eta_seconds),
+                            100.0 * busy, 100.0 * least_busy, snapshot.queued_tasks);
+    if (snapshot.slowest_seconds >= 0.0 && snapshot.slowest_algorithm < _labels.size()) {
+        line += std::format(" | slowest '{}' sample {} ({:.1f} s)",
+                            _labels[snapshot.slowest_algorithm], snapshot.slowest_sample,
+                            snapshot.slowest_seconds);
+    }
+    Logger::instance().status(line, last);
+}
+
+void RunMonitor::write_textfile(const Snapshot &snapshot) const {
+    if (_options.textfile.empty()) {
+        return;
+    }
+    std::string text;
+    const auto gauge = [&text](std::string_view name, std::string_view help) {
+        text += std::format("# HELP registration_{} {}\n# TYPE registration_{} gauge\n", name,
+                            help, name);
+    };
+    gauge("elapsed_seconds", "Seconds since the evaluation started.");
+    text += std::format("registration_elapsed_seconds {}\n", snapshot.elapsed_seconds);
+    gauge("tasks", "Algorithm and work unit tasks of the evaluation.");
+    text += std::format("registration_tasks {}\n", _total_tasks);
+    gauge("tasks_completed", "Tasks finished so far.");
+    text += std::format("registration_tasks_completed {}\n", snapshot.completed_tasks);
+    gauge("tasks_queued", "Tasks not yet started by a worker.");
+    text += std::format("registration_tasks_queued {}\n", snapshot.queued_tasks);
+    gauge("pairs", "Fragment pairs the evaluation registers.");
+    text += std::format("registration_pairs {}\n", _total_pairs);
+    gauge("pairs_completed", "Fragment pairs registered so far.");
+    text += std::format("registration_pairs_completed {}\n", snapshot.completed_pairs);
+    gauge("pairs_per_second", "Pairs registered per second over the last report interval.");
+    text += std::format("registration_pairs_per_second {}\n", snapshot.pairs_per_second);
+    if (std::isfinite(snapshot.eta_seconds)) {
+        gauge("eta_seconds", "Estimated seconds until all pairs are registered.");
+        text += std::format("registration_eta_seconds {}\n", snapshot.eta_seconds);
+    }
+    gauge("worker_busy_ratio", "Share of the last report interval a worker spent in tasks.");
+    for (std::size_t idx = 0; idx < snapshot.busy_ratio.size(); ++idx) {
+        text += std::format("registration_worker_busy_ratio{{worker=\"{}\"}} {}\n", idx,
+                            snapshot.busy_ratio[idx]);
+    }
+    if (snapshot.slowest_seconds >= 0.0 && snapshot.slowest_algorithm < _labels.size()) {
+        gauge("slowest_task_seconds", "Age of the oldest task still running.");
+        text += std::format("registration_slowest_task_seconds{{algorithm=\"{}\",sample=\"{}\"}} {}\n",
+                            escape_label(_labels[snapshot.slowest_algorithm]),
+                            snapshot.slowest_sample, snapshot.slowest_seconds);
+    }
+
+    // Written aside and renamed, so the collector never reads half a file.
+    const std::filesystem::path path(_options.textfile);
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << text;
+        if (!file) {
+            LOG_WARN(ROLE_MONITOR, "Failed to write metrics textfile {}", temporary.string());
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        LOG_WARN(ROLE_MONITOR, "Failed to replace metrics textfile {}: {}", path.string(),
+                 error.message());
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live view of a running evaluation. Workers only update relaxed atomics in
+// their own slot; a reporter thread samples them every `interval_seconds`
+// and renders pairs/s, ETA, per-worker busy ratio, queue depth and the
+// slowest in-flight task as a status line, and as gauges in a Prometheus
+// textfile for the node exporter's textfile collector.
+class RunMonitor {
+public:
+    struct Options {
+        // Seconds between reports; 0 disables the reporter.
+        double interval_seconds{1.0};
+        bool status_line{true};
+        // Rewritten atomically on every report; empty writes none.
+        std::string textfile;
+
+        static Options from_json(const nlohmann::json &config);
+    };
+
+    // Marks the calling worker busy with one (algorithm, unit) task until
+    // destroyed, then counts the task and its pairs as done.
+    class Task {
+    public:
+        Task(Task &&other) noexcept;
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        Task &operator=(Task &&) = delete;
+        ~Task();
+
+    private:
+        friend class RunMonitor;
+        Task(RunMonitor *monitor, std::size_t slot, std::size_t pairs)
+            : _monitor(monitor), _slot(slot), _pairs(pairs) {}
+
+        RunMonitor *_monitor;
+        std::size_t _slot;
+        std::size_t _pairs;
+    };
+
+    // `labels` names the algorithms tasks refer to by index; `workers` is the
+    // number of threads that will call begin().
+    RunMonitor(Options options, std::vector<std::string> labels, std::size_t workers,
+               std::size_t total_tasks, std::size_t total_pairs);
+    // Stops the reporter after a final report.
+    ~RunMonitor();
+
+    RunMonitor(const RunMonitor &) = delete;
+    RunMonitor &operator=(const RunMonitor &) = delete;
+
+    Task begin(std::size_t algorithm, std::size_t sample, std::size_t pairs);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct alignas(64) Slot {
+        // Nanoseconds spent in finished tasks.
+        std::atomic<std::int64_t> busy_ns{0};
+        // Start of the running task in nanoseconds since construction, plus
+        // one; 0 while idle.
+        std::atomic<std::int64_t> started_ns{0};
+        std::atomic<std::uint32_t> algorithm{0};
+        std::atomic<std::uint32_t> sample{0};
+    };
+
+    // Point-in-time gauges computed by the reporter.
+    struct Snapshot {
+        double elapsed_seconds{0.0};
+        std::size_t completed_tasks{0};
+        std::size_t completed_pairs{0};
+        std::size_t queued_tasks{0};
+        double pairs_per_second{0.0};
+        // NaN until the first pair finished.
+        double eta_seconds{0.0};
+        std::vector<double> busy_ratio;
+        // -1 when no task is in flight.
+        double slowest_seconds{-1.0};
+        std::size_t slowest_algorithm{0};
+        std::size_t slowest_sample{0};
+    };
+
+    std::int64_t now_ns() const;
+    std::size_t slot();
+    void finish(const Task &task);
+    void run();
+    Snapshot sample();
+    void render(const Snapshot &snapshot, bool last) const;
+    void write_textfile(const Snapshot &snapshot) const;
+
+    Options _options;
+    std::vector<std::string> _labels;
+    std::size_t _total_tasks;
+    std::size_t _total_pairs;
+    Clock::time_point _start;
+    std::uint64_t _generation;
+    std::unique_ptr<Slot[]> _slots;
+    std::size_t _slot_count;
+    std::atomic<std::size_t> _next_slot{0};
+    std::atomic<std::size_t> _started_tasks{0};
+    std::atomic<std::size_t> _completed_tasks{0};
+    std::atomic<std::size_t> _completed_pairs{0};
+
+    // Reporter state.
+    std::vector<std::int64_t> _last_busy_ns;
+    std::int64_t _last_sample_ns{0};
+    std::size_t _last_pairs{0};
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping{false};
+    std::thread _reporter;
+};
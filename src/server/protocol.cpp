@@ -0,0 +1,135 @@
+#include "server/protocol.hpp"
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+std::string CloudRef::cache_key() const {
+    return is_shared_memory() ? std::format("shm:{}#{}#{}", shm, points, generation)
+                              : std::format("sample:{}/{}", sample, fragment);
+}
+
+nlohmann::json CloudRef::to_json() const {
+    if (is_shared_memory()) {
+        return {{"shm", shm}, {"points", points}, {"generation", generation}};
+    }
+    return {{"sample", sample}, {"fragment", fragment}};
+}
+
+CloudRef CloudRef::from_json(const nlohmann::json &json) {
+    if (!json.is_object()) {
+        throw std::invalid_argument("cloud reference must be an object");
+    }
+    CloudRef ref;
+    if (json.contains("shm")) {
+        ref.shm = json.at("shm").get<std::string>();
+        ref.points = json.at("points").get<std::size_t>();
+        ref.generation = json.value("generation", ref.generation);
+        if (ref.shm.empty() || ref.shm.front() != '/') {
+            throw std::invalid_argument("shared memory names must start with '/'");
+        }
+    } else if (json.contains("sample") && json.contains("fragment")) {
+        ref.sample = json.at("sample").get<std::size_t>();
+        ref.fragment = json.at("fragment").get<std::size_t>();
+    } else {
+        throw std::invalid_argument("cloud reference needs 'shm' or 'sample' and 'fragment'");
+    }
+    return ref;
+}
+
+nlohmann::json transform_to_json(const TransMat &transform) {
+    auto json = nlohmann::json::array();
+    for (int row = 0; row < 4; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            json.push_back(transform(row, col));
+        }
+    }
+    return json;
+}
+
+TransMat transform_from_json(const nlohmann::json &json) {
+    if (!json.is_array() || json.size() != 16) {
+        throw std::invalid_argument("transforms are arrays of 16 numbers, row-major");
+    }
+    TransMat transform;
+    for (int row = 0; row < 4; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            transform(row, col) = json[row * 4 + col].get<float>();
+        }
+    }
+    return transform;
+}
+
+LineSocket::LineSocket(int fd) : _fd(fd) {}
+
+LineSocket::~LineSocket() {
+    ::close(_fd);
+}
+
+bool LineSocket::read_line(std::string &line) {
+    while (true) {
+        const auto end = _buffer.find('\n', _consumed);
+        if (end != std::string::npos) {
+            line.assign(_buffer, _consumed, end - _consumed);
+            _consumed = end + 1;
+            return true;
+        }
+        _buffer.erase(0, _consumed);
+        _consumed = 0;
+
+        char chunk[4096];
+        const auto received = ::recv(_fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        _buffer.append(chunk, static_cast<std::size_t>(received));
+    }
+}
+
+void LineSocket::write_line(const std::string &line) {
+    std::scoped_lock lock(_write_mutex);
+    std::string message = line + '\n';
+    std::size_t sent = 0;
+    while (sent < message.size()) {
+        const auto written =
+            ::send(_fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw std::runtime_error(std::string("socket write failed: ") +
+                                     std::strerror(errno));
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+}
+
+void LineSocket::shutdown() {
+    ::shutdown(_fd, SHUT_RDWR);
+}
+
+int connect_unix_socket(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error("connect " + path + ": " + std::strerror(error));
+    }
+    return fd;
+}
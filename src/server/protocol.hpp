@@ -0,0 +1,68 @@
+#pragma once
+
+#include "common.hpp"
+#include <cstdint>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+
+// Wire format of the registration server: one JSON object per line in each
+// direction over a Unix stream socket.
+//
+//   request   {"id": 7, "algorithm": "icp", "source": <cloud>, "target": <cloud>,
+//              "initial_guess": [16 numbers, row-major]}
+//   cloud     {"shm": "/name", "points": n, "generation": g}
+//                 POSIX shared memory object of n float32 x, y, z, pad records
+//                 written by the client; bump `generation` when a name is
+//                 reused for different points
+//             {"sample": s, "fragment": f}
+//                 fragment f of sample s of the server's dataset
+//   response  {"id": 7, "ok": true, "transform": [16 numbers], "seconds": t, "batch": n}
+//             {"id": 7, "ok": false, "error": "..."}
+//
+// {"command": "stats"} is answered with the server counters. Responses are
+// sent as requests complete, not in request order.
+
+struct CloudRef {
+    std::string shm;
+    std::size_t points{0};
+    std::uint64_t generation{0};
+    std::size_t sample{0};
+    std::size_t fragment{0};
+
+    bool is_shared_memory() const { return !shm.empty(); }
+    // Identity of the cloud in the server's fragment cache.
+    std::string cache_key() const;
+
+    nlohmann::json to_json() const;
+    static CloudRef from_json(const nlohmann::json &json);
+};
+
+nlohmann::json transform_to_json(const TransMat &transform);
+TransMat transform_from_json(const nlohmann::json &json);
+
+// Buffered line I/O on a connected stream socket, which it owns. Writes are
+// serialized so that worker threads can answer on the same connection.
+class LineSocket {
+public:
+    explicit LineSocket(int fd);
+    ~LineSocket();
+
+    LineSocket(const LineSocket &) = delete;
+    LineSocket &operator=(const LineSocket &) = delete;
+
+    // False at end of stream.
+    bool read_line(std::string &line);
+    // Throws std::runtime_error when the peer is gone.
+    void write_line(const std::string &line);
+    // Unblocks a pending read_line from another thread.
+    void shutdown();
+
+private:
+    int _fd;
+    std::string _buffer;
+    std::size_t _consumed{0};
+    std::mutex _write_mutex;
+};
+
+int connect_unix_socket(const std::string &path);
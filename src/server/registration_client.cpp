@@ -0,0 +1,58 @@
+#include "server/registration_client.hpp"
+#include <stdexcept>
+
+RegistrationClient::RegistrationClient(const std::string &socket_path)
+    : _socket(connect_unix_socket(socket_path)) {}
+
+std::uint64_t RegistrationClient::send(const std::string &algorithm, const CloudRef &source,
+                                       const CloudRef &target, const TransMat &initial_guess) {
+    const auto id = _next_id++;
+    nlohmann::json request = {{"id", id},
+                              {"source", source.to_json()},
+                              {"target", target.to_json()},
+                              {"initial_guess", transform_to_json(initial_guess)}};
+    if (!algorithm.empty()) {
+        request["algorithm"] = algorithm;
+    }
+    _socket.write_line(request.dump());
+    return id;
+}
+
+nlohmann::json RegistrationClient::receive_json() {
+    std::string line;
+    if (!_socket.read_line(line)) {
+        throw std::runtime_error("registration server closed the connection");
+    }
+    return nlohmann::json::parse(line);
+}
+
+ServerReply RegistrationClient::receive() {
+    const auto message = receive_json();
+    ServerReply reply;
+    reply.id = message.value("id", std::uint64_t{0});
+    reply.ok = message.value("ok", false);
+    if (reply.ok) {
+        reply.transform = transform_from_json(message.at("transform"));
+        reply.seconds = message.value("seconds", 0.0);
+        reply.batch = message.value("batch", std::size_t{0});
+    } else {
+        reply.error = message.value("error", std::string{"unknown error"});
+    }
+    return reply;
+}
+
+ServerReply RegistrationClient::register_pair(const std::string &algorithm,
+                                              const CloudRef &source, const CloudRef &target,
+                                              const TransMat &initial_guess) {
+    const auto id = send(algorithm, source, target, initial_guess);
+    auto reply = receive();
+    if (reply.id != id) {
+        throw std::logic_error("register_pair called with other requests outstanding");
+    }
+    return reply;
+}
+
+nlohmann::json RegistrationClient::stats() {
+    _socket.write_line(nlohmann::json{{"command", "stats"}}.dump());
+    return receive_json();
+}
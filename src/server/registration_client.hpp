@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common.hpp"
+#include "server/protocol.hpp"
+#include <cstdint>
+#include <string>
+
+struct ServerReply {
+    std::uint64_t id{0};
+    bool ok{false};
+    TransMat transform{TransMat::Identity()};
+    std::string error;
+    // Registration time on the server.
+    double seconds{0.0};
+    // Number of requests submitted together with this one.
+    std::size_t batch{0};
+};
+
+// Connection to a RegistrationServer. Requests may be pipelined with send()
+// and collected with receive(); replies arrive in completion order and are
+// matched by id. Not thread-safe; use one client per thread.
+class RegistrationClient {
+public:
+    explicit RegistrationClient(const std::string &socket_path);
+
+    std::uint64_t send(const std::string &algorithm, const CloudRef &source,
+                       const CloudRef &target,
+                       const TransMat &initial_guess = TransMat::Identity());
+    ServerReply receive();
+
+    // send() followed by the matching receive(); requires no other request
+    // to be outstanding.
+    ServerReply register_pair(const std::string &algorithm, const CloudRef &source,
+                              const CloudRef &target,
+                              const TransMat &initial_guess = TransMat::Identity());
+
+    nlohmann::json stats();
+
+private:
+    nlohmann::json receive_json();
+
+    LineSocket _socket;
+    std::uint64_t _next_id{1};
+};
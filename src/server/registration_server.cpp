@@ -0,0 +1,371 @@
+#include "server/registration_server.hpp"
+#include "logger.hpp"
+#include "server/shared_cloud.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::string_view ROLE_SERVER{"server"};
+
+std::atomic<bool> stop_requested{false};
+
+void request_stop(int) {
+    stop_requested = true;
+}
+
+int listen_unix_socket(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error("listen on " + path + ": " + std::strerror(error));
+    }
+    return fd;
+}
+
+nlohmann::json error_response(const nlohmann::json &id, const std::string &error) {
+    return {{"id", id}, {"ok", false}, {"error", error}};
+}
+} // namespace
+
+ServerOptions ServerOptions::from_json(const nlohmann::json &config) {
+    ServerOptions options;
+    options.socket_path = config.value("socket", options.socket_path);
+    options.threads = config.value("threads", options.threads);
+    options.batch_window_ms = config.value("batch_window_ms", options.batch_window_ms);
+    options.max_batch = config.value("max_batch", options.max_batch);
+    options.cache_fragments = config.value("cache_fragments", options.cache_fragments);
+    if (options.max_batch == 0 || options.cache_fragments == 0) {
+        throw std::invalid_argument("server.max_batch and server.cache_fragments must be positive");
+    }
+    return options;
+}
+
+FragmentLru::FragmentLru(std::size_t capacity) : _capacity(capacity) {}
+
+FragmentLru::Entry FragmentLru::insert(const std::string &key, const Entry &entry) {
+    std::vector<Entry> evicted;
+    {
+        std::scoped_lock lock(_mutex);
+        const auto existing = _entries.find(key);
+        if (existing != _entries.end()) {
+            return existing->second.first;
+        }
+        _order.push_front(key);
+        _entries.emplace(key, std::make_pair(entry, _order.begin()));
+        while (_entries.size() > _capacity) {
+            const auto oldest = _entries.find(_order.back());
+            evicted.emplace_back(std::move(oldest->second.first));
+            _entries.erase(oldest);
+            _order.pop_back();
+        }
+    }
+    // Requests still running keep what they hold; the rest is released here.
+    for (const auto &old : evicted) {
+        old.slot.cache->evict(old.slot.index);
+    }
+    return entry;
+}
+
+std::size_t FragmentLru::size() const {
+    std::scoped_lock lock(_mutex);
+    return _entries.size();
+}
+
+RegistrationServer::RegistrationServer(ServerOptions options,
+                                       std::vector<std::shared_ptr<AlgorithmBase>> algorithms,
+                                       std::vector<Sample> samples)
+    : _options(std::move(options)), _algorithms(std::move(algorithms)),
+      _samples(std::move(samples)), _engine(_options.threads), _lru(_options.cache_fragments) {
+    if (_algorithms.empty()) {
+        throw std::invalid_argument("RegistrationServer needs at least one algorithm");
+    }
+}
+
+RegistrationServer::~RegistrationServer() {
+    {
+        std::scoped_lock lock(_connections_mutex);
+        for (const auto &weak : _connections) {
+            if (const auto connection = weak.lock()) {
+                connection->shutdown();
+            }
+        }
+    }
+    for (auto &connection_thread : _connection_threads) {
+        if (connection_thread.thread.joinable()) {
+            connection_thread.thread.join();
+        }
+    }
+    _engine.wait();
+}
+
+FragmentLru::Entry RegistrationServer::resolve_cloud(const CloudRef &ref) {
+    bool hit = false;
+    auto entry = _lru.get(
+        ref.cache_key(),
+        [this, &ref]() {
+            FragmentLru::Entry loaded;
+            if (ref.is_shared_memory()) {
+                loaded.cloud = std::make_shared<const PointCloud>(read_shared_cloud(ref));
+                loaded.slot = FragmentSlot{_shared_memory_cache, _next_shared_slot++};
+                return loaded;
+            }
+            if (ref.sample >= _samples.size() ||
+                ref.fragment >= _samples[ref.sample].fragment_count()) {
+                throw std::out_of_range("no fragment " + std::to_string(ref.fragment) +
+                                        " in sample " + std::to_string(ref.sample));
+            }
+            const auto &sample = _samples[ref.sample];
+            loaded.cloud = sample.fragment(ref.fragment).shared();
+            loaded.slot = FragmentSlot{sample.cache, ref.fragment};
+            return loaded;
+        },
+        hit);
+    ++(hit ? _cache_hits : _cache_misses);
+    return entry;
+}
+
+RegistrationRequest RegistrationServer::resolve(const nlohmann::json &message) {
+    const auto source = resolve_cloud(CloudRef::from_json(message.at("source")));
+    const auto target = resolve_cloud(CloudRef::from_json(message.at("target")));
+
+    RegistrationRequest request;
+    request.source = source.cloud;
+    request.target = target.cloud;
+    request.source_slot = source.slot;
+    request.target_slot = target.slot;
+    if (message.contains("initial_guess")) {
+        request.initial_guess = transform_from_json(message["initial_guess"]);
+    }
+    return request;
+}
+
+void RegistrationServer::handle_line(const std::shared_ptr<LineSocket> &connection,
+                                     const std::string &line) {
+    nlohmann::json id;
+    try {
+        const auto message = nlohmann::json::parse(line);
+        id = message.value("id", nlohmann::json());
+        if (message.value("command", std::string{}) == "stats") {
+            auto reply = stats();
+            reply["id"] = id;
+            connection->write_line(reply.dump());
+            return;
+        }
+
+        Pending pending;
+        pending.connection = connection;
+        pending.id = id;
+        const auto algorithm = message.value("algorithm", _algorithms.front()->label());
+        pending.algorithm = _algorithms.size();
+        for (std::size_t idx = 0; idx < _algorithms.size(); ++idx) {
+            if (_algorithms[idx]->label() == algorithm) {
+                pending.algorithm = idx;
+                break;
+            }
+        }
+        if (pending.algorithm == _algorithms.size()) {
+            throw std::invalid_argument("algorithm not served: " + algorithm);
+        }
+        pending.request = resolve(message);
+
+        {
+            std::scoped_lock lock(_pending_mutex);
+            if (_stopping) {
+                throw std::runtime_error("server is stopping");
+            }
+            _pending.emplace_back(std::move(pending));
+        }
+        ++_requests;
+        _pending_ready.notify_one();
+    } catch (const std::exception &e) {
+        ++_failures;
+        connection->write_line(error_response(id, e.what()).dump());
+    }
+}
+
+void RegistrationServer::serve_connection(std::shared_ptr<LineSocket> connection) {
+    std::string line;
+    try {
+        while (connection->read_line(line)) {
+            if (!line.empty()) {
+                handle_line(connection, line);
+            }
+        }
+    } catch (const std::exception &e) {
+        LOG_WARN(ROLE_SERVER, "Connection closed: {}", e.what());
+    }
+}
+
+void RegistrationServer::dispatch() {
+    const auto window = std::chrono::duration<double, std::milli>(_options.batch_window_ms);
+    while (true) {
+        std::vector<Pending> batch;
+        {
+            std::unique_lock lock(_pending_mutex);
+            _pending_ready.wait(lock, [this]() { return _stopping || !_pending.empty(); });
+            if (_pending.empty()) {
+                return;
+            }
+            // Give concurrent clients the window to join this batch.
+            _pending_ready.wait_for(lock, window, [this]() {
+                return _pending.size() >= _options.max_batch;
+            });
+            while (!_pending.empty() && batch.size() < _options.max_batch) {
+                batch.emplace_back(std::move(_pending.front()));
+                _pending.pop_front();
+            }
+        }
+
+        std::vector<std::vector<Pending>> by_algorithm(_algorithms.size());
+        for (auto &pending : batch) {
+            by_algorithm[pending.algorithm].emplace_back(std::move(pending));
+        }
+        for (std::size_t algorithm = 0; algorithm < by_algorithm.size(); ++algorithm) {
+            auto group = std::make_shared<std::vector<Pending>>(std::move(by_algorithm[algorithm]));
+            if (group->empty()) {
+                continue;
+            }
+            ++_batches;
+            std::vector<RegistrationRequest> requests;
+            requests.reserve(group->size());
+            for (const auto &pending : *group) {
+                requests.emplace_back(pending.request);
+            }
+            const auto size = group->size();
+            _engine.submit(_algorithms[algorithm], std::move(requests),
+                           [this, group, size](std::size_t index, const RegistrationResult &result) {
+                               const auto &pending = (*group)[index];
+                               nlohmann::json reply;
+                               if (result.success) {
+                                   reply = {{"id", pending.id},
+                                            {"ok", true},
+                                            {"transform", transform_to_json(result.transform)},
+                                            {"seconds", result.seconds},
+                                            {"batch", size}};
+                               } else {
+                                   ++_failures;
+                                   reply = error_response(pending.id, result.error);
+                               }
+                               pending.connection->write_line(reply.dump());
+                           });
+        }
+    }
+}
+
+void RegistrationServer::reap_connections() {
+    std::scoped_lock lock(_connections_mutex);
+    std::erase_if(_connections, [](const auto &weak) { return weak.expired(); });
+    for (auto it = _connection_threads.begin(); it != _connection_threads.end();) {
+        if (it->done->load()) {
+            it->thread.join();
+            it = _connection_threads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void RegistrationServer::run(const std::atomic<bool> &stop) {
+    const int listener = listen_unix_socket(_options.socket_path);
+    LOG_INFO(ROLE_SERVER, "Listening on {} with {} engine thread(s), {} algorithm(s), {} sample(s)",
+             _options.socket_path, _engine.thread_count(), _algorithms.size(), _samples.size());
+
+    std::thread dispatcher([this]() { dispatch(); });
+
+    while (!stop) {
+        // Closed connections are joined here, so a long-running server holds
+        // one thread per open connection only.
+        reap_connections();
+        pollfd descriptor{listener, POLLIN, 0};
+        if (::poll(&descriptor, 1, 200) <= 0) {
+            continue;
+        }
+        const int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        auto connection = std::make_shared<LineSocket>(fd);
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::scoped_lock lock(_connections_mutex);
+        _connections.emplace_back(connection);
+        _connection_threads.push_back(
+            {std::thread([this, connection, done]() mutable {
+                 serve_connection(std::move(connection));
+                 *done = true;
+             }),
+             done});
+    }
+
+    ::close(listener);
+    ::unlink(_options.socket_path.c_str());
+    // Requests queued so far are still dispatched; connections get an error
+    // for anything sent from now on.
+    {
+        std::scoped_lock lock(_pending_mutex);
+        _stopping = true;
+    }
+    _pending_ready.notify_all();
+    dispatcher.join();
+    // Answers every request in flight while its connection is still open.
+    _engine.wait();
+    LOG_INFO(ROLE_SERVER, "Stopped after {} request(s) in {} batch(es)", _requests.load(),
+             _batches.load());
+}
+
+nlohmann::json RegistrationServer::stats() const {
+    return {{"requests", _requests.load()},
+            {"batches", _batches.load()},
+            {"failures", _failures.load()},
+            {"cache_hits", _cache_hits.load()},
+            {"cache_misses", _cache_misses.load()},
+            {"cached_fragments", _lru.size()}};
+}
+
+void run_server(const nlohmann::json &config) {
+    const auto server_config = config.value("server", nlohmann::json::object());
+    auto options = ServerOptions::from_json(server_config);
+
+    const auto &algorithm_configs = server_config.contains("algorithms")
+                                        ? server_config["algorithms"]
+                                        : config.value("algorithms", nlohmann::json::array());
+    std::vector<std::shared_ptr<AlgorithmBase>> algorithms;
+    for (const auto &algorithm_config : algorithm_configs) {
+        algorithms.emplace_back(create_algorithm(algorithm_config));
+    }
+
+    std::vector<Sample> samples;
+    const auto loader_config = server_config.contains("dataset_loader")
+                                   ? server_config["dataset_loader"]
+                                   : config.value("dataset_loader", nlohmann::json());
+    if (loader_config.is_object()) {
+        samples = create_dataset_loader(loader_config)->load_samples();
+    }
+
+    stop_requested = false;
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    RegistrationServer server(std::move(options), std::move(algorithms), std::move(samples));
+    server.run(stop_requested);
+}
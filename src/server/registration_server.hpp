@@ -0,0 +1,147 @@
+#pragma once
+
+#include "algorithm/algorithm_base.hpp"
+#include "dataset_loader/dataset_loader_base.hpp"
+#include "registration_engine.hpp"
+#include "server/protocol.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Settings of the `server` config section.
+struct ServerOptions {
+    std::string socket_path{"/tmp/pointcloud_registration.sock"};
+    // Engine pool size; 0 uses the hardware concurrency.
+    std::size_t threads{0};
+    // Requests arriving within `batch_window_ms` of the first waiting one
+    // are submitted together, up to `max_batch` of them.
+    double batch_window_ms{2.0};
+    std::size_t max_batch{64};
+    // Fragments whose derived data (normals, covariances, search
+    // structures) and shared memory copies are kept warm.
+    std::size_t cache_fragments{256};
+
+    static ServerOptions from_json(const nlohmann::json &config);
+};
+
+// Least recently used set of clouds with their derived data. Dataset
+// fragments stay loaded and only lose their cache entries on eviction;
+// shared memory clouds are dropped entirely.
+class FragmentLru {
+public:
+    explicit FragmentLru(std::size_t capacity);
+
+    struct Entry {
+        PointCloud::ConstPtr cloud;
+        FragmentSlot slot;
+    };
+
+    // Cached entry for `key`, or the one produced by `load` (called without
+    // the lock held) after evicting the least recently used entries.
+    template <typename Load>
+    Entry get(const std::string &key, Load &&load, bool &hit);
+
+    std::size_t size() const;
+
+private:
+    // Returns the entry already stored by a concurrent miss, if any.
+    Entry insert(const std::string &key, const Entry &entry);
+
+    std::size_t _capacity;
+    mutable std::mutex _mutex;
+    std::list<std::string> _order;
+    std::unordered_map<std::string, std::pair<Entry, std::list<std::string>::iterator>> _entries;
+};
+
+template <typename Load>
+FragmentLru::Entry FragmentLru::get(const std::string &key, Load &&load, bool &hit) {
+    {
+        std::scoped_lock lock(_mutex);
+        const auto it = _entries.find(key);
+        if (it != _entries.end()) {
+            _order.splice(_order.begin(), _order, it->second.second);
+            hit = true;
+            return it->second.first;
+        }
+    }
+    hit = false;
+    return insert(key, load());
+}
+
+// Registration daemon: accepts JSON-line requests (see protocol.hpp) on a
+// Unix domain socket, batches concurrent requests onto a RegistrationEngine
+// and answers each on its connection as soon as it completes.
+class RegistrationServer {
+public:
+    RegistrationServer(ServerOptions options,
+                       std::vector<std::shared_ptr<AlgorithmBase>> algorithms,
+                       std::vector<Sample> samples);
+    ~RegistrationServer();
+
+    // Serves until `stop` becomes true. Requests already accepted are then
+    // still registered and answered before run() returns; later ones get an
+    // error reply.
+    void run(const std::atomic<bool> &stop);
+
+    nlohmann::json stats() const;
+
+private:
+    struct Pending {
+        std::shared_ptr<LineSocket> connection;
+        nlohmann::json id;
+        std::size_t algorithm{0};
+        RegistrationRequest request;
+    };
+
+    void serve_connection(std::shared_ptr<LineSocket> connection);
+    void handle_line(const std::shared_ptr<LineSocket> &connection, const std::string &line);
+    RegistrationRequest resolve(const nlohmann::json &message);
+    FragmentLru::Entry resolve_cloud(const CloudRef &ref);
+    // Submits batches until stopping and the queue is empty.
+    void dispatch();
+    // Joins the threads of connections that have closed.
+    void reap_connections();
+
+    ServerOptions _options;
+    std::vector<std::shared_ptr<AlgorithmBase>> _algorithms;
+    std::vector<Sample> _samples;
+    RegistrationEngine _engine;
+    FragmentLru _lru;
+    std::shared_ptr<FragmentCache> _shared_memory_cache{std::make_shared<FragmentCache>()};
+    std::atomic<std::size_t> _next_shared_slot{0};
+
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_ready;
+    std::deque<Pending> _pending;
+    // Set under _pending_mutex once run() stops; nothing is queued after.
+    bool _stopping{false};
+
+    struct ConnectionThread {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    std::mutex _connections_mutex;
+    std::vector<std::weak_ptr<LineSocket>> _connections;
+    std::list<ConnectionThread> _connection_threads;
+
+    std::atomic<std::uint64_t> _requests{0};
+    std::atomic<std::uint64_t> _batches{0};
+    std::atomic<std::uint64_t> _failures{0};
+    std::atomic<std::uint64_t> _cache_hits{0};
+    std::atomic<std::uint64_t> _cache_misses{0};
+};
+
+// Daemon entry point: builds the algorithms (`server.algorithms`, else the
+// top-level `algorithms`) and loads the dataset (`server.dataset_loader`,
+// else the top-level one, optional), then serves until SIGINT or SIGTERM.
+void run_server(const nlohmann::json &config);
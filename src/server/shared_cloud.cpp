@@ -0,0 +1,85 @@
+#include "server/shared_cloud.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::size_t RECORD_SIZE = sizeof(pcl::PointXYZ);
+
+std::runtime_error shm_error(const std::string &what, const std::string &name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+} // namespace
+
+SharedCloudWriter::SharedCloudWriter(std::string name, const PointCloud &cloud,
+                                     std::uint64_t generation) {
+    _ref.shm = std::move(name);
+    _ref.points = cloud.size();
+    _ref.generation = generation;
+
+    const int fd = ::shm_open(_ref.shm.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        throw shm_error("shm_open", _ref.shm);
+    }
+    const std::size_t bytes = cloud.size() * RECORD_SIZE;
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        ::shm_unlink(_ref.shm.c_str());
+        throw shm_error("ftruncate", _ref.shm);
+    }
+    if (bytes > 0) {
+        void *address = ::mmap(nullptr, bytes, PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            ::shm_unlink(_ref.shm.c_str());
+            throw shm_error("mmap", _ref.shm);
+        }
+        std::memcpy(address, cloud.points.data(), bytes);
+        ::munmap(address, bytes);
+    }
+    ::close(fd);
+}
+
+SharedCloudWriter::~SharedCloudWriter() {
+    ::shm_unlink(_ref.shm.c_str());
+}
+
+PointCloud read_shared_cloud(const CloudRef &ref) {
+    const int fd = ::shm_open(ref.shm.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw shm_error("shm_open", ref.shm);
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw shm_error("fstat", ref.shm);
+    }
+    const std::size_t bytes = ref.points * RECORD_SIZE;
+    if (static_cast<std::size_t>(info.st_size) < bytes) {
+        ::close(fd);
+        throw std::runtime_error("shared memory object " + ref.shm + " holds fewer than " +
+                                 std::to_string(ref.points) + " points");
+    }
+
+    PointCloud cloud;
+    if (bytes > 0) {
+        void *address = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw shm_error("mmap", ref.shm);
+        }
+        cloud.resize(ref.points);
+        std::memcpy(static_cast<void *>(cloud.points.data()), address, bytes);
+        ::munmap(address, bytes);
+        for (auto &point : cloud.points) {
+            point.data[3] = 1.0f;
+        }
+    }
+    ::close(fd);
+    return cloud;
+}
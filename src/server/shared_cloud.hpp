@@ -0,0 +1,27 @@
+#pragma once
+
+#include "common.hpp"
+#include "server/protocol.hpp"
+#include <string>
+
+// Client side of the shared memory transport: publishes a cloud as a POSIX
+// shared memory object of PointXYZ records that the server maps instead of
+// receiving the points through the socket. The object is unlinked when the
+// writer is destroyed, so it must outlive the requests that use it.
+class SharedCloudWriter {
+public:
+    SharedCloudWriter(std::string name, const PointCloud &cloud, std::uint64_t generation = 0);
+    ~SharedCloudWriter();
+
+    SharedCloudWriter(const SharedCloudWriter &) = delete;
+    SharedCloudWriter &operator=(const SharedCloudWriter &) = delete;
+
+    CloudRef ref() const { return _ref; }
+
+private:
+    CloudRef _ref;
+};
+
+// Server side: maps the object named by `ref` read-only and copies its
+// records straight into a cloud.
+PointCloud read_shared_cloud(const CloudRef &ref);
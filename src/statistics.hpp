@@ -0,0 +1,32 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Linearly interpolated percentile of `values` at `fraction` (clamped to
+// [0, 1]): 0.5 is the median, 1 the maximum. Reorders `values`, so callers
+// taking several percentiles of one vector pay for no copies; 0 for an empty
+// vector.
+inline double percentile_in_place(std::vector<double> &values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const double rank = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(values.size() - 1);
+    const auto lower = static_cast<std::size_t>(std::floor(rank));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(lower),
+                     values.end());
+    const double low = values[lower];
+    if (lower + 1 >= values.size()) {
+        return low;
+    }
+    const double high = *std::min_element(values.begin() + static_cast<std::ptrdiff_t>(lower) + 1,
+                                          values.end());
+    const double weight = rank - static_cast<double>(lower);
+    return low * (1.0 - weight) + high * weight;
+}
+
+// percentile_in_place() of a copy of `values`.
+inline double percentile(std::vector<double> values, double fraction) {
+    return percentile_in_place(values, fraction);
+}
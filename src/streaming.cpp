@@ -0,0 +1,363 @@
+#include "streaming.hpp"
+
+#include "algorithm/voxel_hash_correspondence.hpp"
+#include "algorithm/voxel_key.hpp"
+#include "dataset_loader/kitti_dataset_loader.hpp"
+#include "dataset_loader/ply_reader.hpp"
+#include "logger.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <pcl/io/ply_io.h>
+#include <pcl/registration/icp.h>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr std::string_view ROLE_STREAM{"stream"};
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds_between(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+struct PendingFrame {
+    fs::path path;
+    Clock::time_point arrival;
+};
+
+// Hand-off between the input watcher and the registration loop.
+class FrameQueue {
+public:
+    void push(PendingFrame frame) {
+        {
+            std::scoped_lock lock(_mutex);
+            _frames.emplace_back(std::move(frame));
+        }
+        _ready.notify_one();
+    }
+
+    void close() {
+        {
+            std::scoped_lock lock(_mutex);
+            _closed = true;
+        }
+        _ready.notify_all();
+    }
+
+    // Blocks until a frame is available; false once closed and drained.
+    // `backlog` receives the number of frames still waiting after this one.
+    bool pop(PendingFrame &frame, std::size_t &backlog) {
+        std::unique_lock lock(_mutex);
+        _ready.wait(lock, [this]() { return _closed || !_frames.empty(); });
+        if (_frames.empty()) {
+            return false;
+        }
+        frame = std::move(_frames.front());
+        _frames.pop_front();
+        backlog = _frames.size();
+        return true;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::deque<PendingFrame> _frames;
+    bool _closed{false};
+};
+
+bool is_frame_file(const fs::path &path) {
+    const auto extension = path.extension();
+    return extension == ".bin" || extension == ".ply";
+}
+
+// Polls `directory` and queues files once their size is stable over two
+// polls, so that frames still being written are not read.
+void watch_directory(const StreamingOptions &options, FrameQueue &queue) {
+    std::unordered_set<std::string> queued;
+    std::map<fs::path, std::uintmax_t> growing;
+    auto last_activity = Clock::now();
+    const auto poll = std::chrono::duration<double, std::milli>(options.poll_ms);
+
+    while (true) {
+        std::vector<fs::path> ready;
+        std::error_code error;
+        for (const auto &entry : fs::directory_iterator(options.input, error)) {
+            if (!entry.is_regular_file() || !is_frame_file(entry.path()) ||
+                queued.contains(entry.path().string())) {
+                continue;
+            }
+            const auto size = entry.file_size(error);
+            if (error || size == 0) {
+                continue;
+            }
+            const auto previous = growing.find(entry.path());
+            if (previous != growing.end() && previous->second == size) {
+                ready.emplace_back(entry.path());
+                growing.erase(previous);
+            } else {
+                growing[entry.path()] = size;
+                last_activity = Clock::now();
+            }
+        }
+
+        std::sort(ready.begin(), ready.end());
+        for (auto &path : ready) {
+            queued.insert(path.string());
+            queue.push({std::move(path), Clock::now()});
+            last_activity = Clock::now();
+        }
+
+        if (options.idle_timeout_s > 0.0 &&
+            milliseconds_between(last_activity, Clock::now()) > options.idle_timeout_s * 1000.0) {
+            break;
+        }
+        std::this_thread::sleep_for(poll);
+    }
+    queue.close();
+}
+
+// Reads frame paths, one per line, until every writer closed the pipe.
+void read_pipe(const StreamingOptions &options, FrameQueue &queue) {
+    std::ifstream pipe(options.input);
+    std::string line;
+    while (std::getline(pipe, line)) {
+        if (!line.empty()) {
+            queue.push({fs::path(line), Clock::now()});
+        }
+    }
+    queue.close();
+}
+
+PointCloud load_frame(const fs::path &path, const StreamingOptions &options) {
+    if (path.extension() == ".bin") {
+        return read_kitti_scan(path, options.min_range, options.max_range);
+    }
+    PointCloud cloud;
+    if (read_ply_points(path, cloud)) {
+        return cloud;
+    }
+    if (pcl::io::loadPLYFile(path.string(), cloud) != 0) {
+        throw std::runtime_error("Failed to load frame " + path.string());
+    }
+    return cloud;
+}
+
+// Keeps the first point of every voxel of `voxel_size`.
+PointCloud thin_frame(const PointCloud &cloud, float voxel_size) {
+    const float inverse_voxel_size = 1.0f / voxel_size;
+    std::unordered_set<std::uint64_t> occupied;
+    occupied.reserve(cloud.size());
+    PointCloud thinned;
+    thinned.reserve(cloud.size());
+    for (const auto &point : cloud) {
+        if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z)) {
+            continue;
+        }
+        const auto key =
+            pack_voxel_key(voxel_coordinates(point.getVector3fMap(), inverse_voxel_size));
+        if (occupied.insert(key).second) {
+            thinned.push_back(point);
+        }
+    }
+    return thinned;
+}
+
+void write_pose(std::ofstream &out, const TransMat &pose) {
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            out << pose(row, col) << (row == 2 && col == 3 ? '\n' : ' ');
+        }
+    }
+}
+} // namespace
+
+StreamingOptions StreamingOptions::from_json(const nlohmann::json &config) {
+    StreamingOptions options;
+    if (!config.contains("input") || !config["input"].is_string()) {
+        throw std::invalid_argument("streaming.input must be a directory or named pipe path");
+    }
+    options.input = config["input"].get<std::string>();
+    options.poll_ms = config.value("poll_ms", options.poll_ms);
+    options.idle_timeout_s = config.value("idle_timeout_s", options.idle_timeout_s);
+    options.deadline_ms = config.value("deadline_ms", options.deadline_ms);
+    options.drop_late = config.value("drop_late", options.drop_late);
+    options.window = config.value("window", options.window);
+    options.voxel_size = config.value("voxel_size", options.voxel_size);
+    options.max_points_per_voxel =
+        config.value("max_points_per_voxel", options.max_points_per_voxel);
+    options.frame_voxel_size = config.value("frame_voxel_size", options.frame_voxel_size);
+    options.min_range = config.value("min_range", options.min_range);
+    options.max_range = config.value("max_range", options.max_range);
+    options.max_iterations = config.value("max_iterations", options.max_iterations);
+    options.max_correspondence_distance =
+        config.value("max_correspondence_distance", options.voxel_size);
+    options.transformation_epsilon =
+        config.value("transformation_epsilon", options.transformation_epsilon);
+    if (config.contains("trajectory")) {
+        options.trajectory = config["trajectory"].get<std::string>();
+    }
+
+    if (options.window == 0) {
+        throw std::invalid_argument("streaming.window must be positive");
+    }
+    if (!(options.voxel_size > 0.0) || !(options.max_correspondence_distance > 0.0)) {
+        throw std::invalid_argument(
+            "streaming.voxel_size and max_correspondence_distance must be positive");
+    }
+    return options;
+}
+
+StreamingOdometry::StreamingOdometry(const StreamingOptions &options)
+    : _options(options),
+      _map(std::make_shared<IncrementalVoxelMap>(static_cast<float>(options.voxel_size),
+                                                 options.max_points_per_voxel)) {}
+
+TransMat StreamingOdometry::process(const PointCloud &frame) {
+    const PointCloud thinned =
+        _options.frame_voxel_size > 0.0
+            ? thin_frame(frame, static_cast<float>(_options.frame_voxel_size))
+            : frame;
+    if (thinned.empty()) {
+        throw std::runtime_error("frame has no valid points");
+    }
+
+    TransMat pose = TransMat::Identity();
+    if (_next_frame > 0) {
+        pcl::IterativeClosestPoint<pcl::PointXYZ, pcl::PointXYZ> icp;
+        icp.setInputSource(PointCloud::ConstPtr(PointCloud::ConstPtr{}, &thinned));
+        icp.setInputTarget(_map->cloud());
+        CorrespondenceBackend::attach<pcl::PointXYZ, pcl::PointXYZ, float, IncrementalVoxelMap>(
+            icp, _map);
+        icp.setMaxCorrespondenceDistance(_options.max_correspondence_distance);
+        icp.setMaximumIterations(_options.max_iterations);
+        icp.setTransformationEpsilon(_options.transformation_epsilon);
+
+        PointCloud aligned;
+        icp.align(aligned, _pose * _velocity);
+        if (!icp.hasConverged()) {
+            throw std::runtime_error("ICP did not converge against the local map");
+        }
+        pose = icp.getFinalTransformation();
+    }
+
+    _velocity = _pose.inverse() * pose;
+    _pose = pose;
+    _map->insert(_next_frame, thinned, pose);
+    if (_next_frame >= _options.window) {
+        _map->evict(_next_frame - _options.window);
+    }
+    ++_next_frame;
+    return pose;
+}
+
+TransMat StreamingOdometry::skip() {
+    if (_next_frame == 0) {
+        return _pose;
+    }
+    _pose = _pose * _velocity;
+    return _pose;
+}
+
+StreamingReport run_streaming(const StreamingOptions &options) {
+    if (!fs::exists(options.input)) {
+        throw std::runtime_error("Streaming input does not exist: " + options.input.string());
+    }
+    const bool from_pipe = fs::is_fifo(options.input);
+    LOG_INFO(ROLE_STREAM, "Streaming frames from {} {} with a {} ms deadline",
+             from_pipe ? "pipe" : "directory", options.input.string(), options.deadline_ms);
+
+    std::ofstream trajectory;
+    std::ofstream frame_status;
+    if (!options.trajectory.empty()) {
+        auto status_path = options.trajectory;
+        status_path += ".frames";
+        trajectory.open(options.trajectory);
+        frame_status.open(status_path);
+        if (!trajectory.is_open() || !frame_status.is_open()) {
+            throw std::runtime_error("Failed to open trajectory file " +
+                                     options.trajectory.string());
+        }
+    }
+    // Keeps line N of the trajectory on frame N, whatever became of it.
+    const auto record = [&trajectory, &frame_status](const PendingFrame &frame,
+                                                     const TransMat &pose,
+                                                     std::string_view status) {
+        if (trajectory.is_open()) {
+            write_pose(trajectory, pose);
+            frame_status << frame.path.filename().string() << ' ' << status << '\n';
+        }
+    };
+
+    FrameQueue queue;
+    std::thread watcher([&options, &queue, from_pipe]() {
+        try {
+            if (from_pipe) {
+                read_pipe(options, queue);
+            } else {
+                watch_directory(options, queue);
+            }
+        } catch (const std::exception &e) {
+            LOG_ERROR(ROLE_STREAM, "Input watcher stopped: {}", e.what());
+            queue.close();
+        }
+    });
+
+    StreamingOdometry odometry(options);
+    StreamingReport report;
+    PendingFrame frame;
+    std::size_t backlog = 0;
+    while (queue.pop(frame, backlog)) {
+        ++report.frames;
+        if (options.drop_late && backlog > 0 &&
+            milliseconds_between(frame.arrival, Clock::now()) > options.deadline_ms) {
+            ++report.dropped;
+            LOG_WARN(ROLE_STREAM, "Dropped late frame {} ({} waiting)",
+                     frame.path.filename().string(), backlog);
+            record(frame, odometry.skip(), "dropped");
+            continue;
+        }
+
+        const auto start = Clock::now();
+        try {
+            const auto pose = odometry.process(load_frame(frame.path, options));
+            const auto done = Clock::now();
+            ++report.registered;
+            report.processing_ms.emplace_back(milliseconds_between(start, done));
+            report.latency_ms.emplace_back(milliseconds_between(frame.arrival, done));
+            if (report.latency_ms.back() > options.deadline_ms) {
+                ++report.deadline_misses;
+            }
+            record(frame, pose, "registered");
+        } catch (const std::exception &e) {
+            ++report.failures;
+            LOG_WARN(ROLE_STREAM, "Frame {} failed: {}", frame.path.filename().string(),
+                     e.what());
+            record(frame, odometry.skip(), "failed");
+        }
+    }
+    watcher.join();
+
+    LOG_INFO(ROLE_STREAM,
+             "{} frames: {} registered, {} dropped, {} failed, {} over the deadline",
+             report.frames, report.registered, report.dropped, report.failures,
+             report.deadline_misses);
+    LOG_INFO(ROLE_STREAM, "Latency ms p50 {:.2f} p90 {:.2f} p99 {:.2f} max {:.2f}",
+             percentile(report.latency_ms, 0.5), percentile(report.latency_ms, 0.9),
+             percentile(report.latency_ms, 0.99), percentile(report.latency_ms, 1.0));
+    LOG_INFO(ROLE_STREAM, "Registration ms p50 {:.2f} p99 {:.2f}; map holds {} points in {} voxels",
+             percentile(report.processing_ms, 0.5), percentile(report.processing_ms, 0.99),
+             odometry.map().size(), odometry.map().voxel_count());
+    return report;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "algorithm/incremental_voxel_map.hpp"
+#include "common.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Settings of the `streaming` config section.
+struct StreamingOptions {
+    // Directory watched for new frame files, or a named pipe delivering one
+    // frame path per line. Frames are KITTI .bin scans or .ply files.
+    std::filesystem::path input;
+    // Directory polling interval and the idle time after which a watched
+    // directory is considered finished (0 watches forever).
+    double poll_ms{10.0};
+    double idle_timeout_s{5.0};
+    // A frame misses its deadline when its pose is ready more than
+    // `deadline_ms` after it arrived. With `drop_late`, a frame that is
+    // already late while newer ones are waiting is dropped unprocessed.
+    double deadline_ms{100.0};
+    bool drop_late{true};
+
+    // Local map: the last `window` registered frames.
+    std::size_t window{10};
+    double voxel_size{0.5};
+    std::size_t max_points_per_voxel{20};
+    // Frames are thinned to one point per voxel of this size (0 keeps all).
+    double frame_voxel_size{0.0};
+    float min_range{0.0f};
+    float max_range{0.0f};
+
+    int max_iterations{30};
+    double max_correspondence_distance{0.0};
+    double transformation_epsilon{1e-6};
+
+    // Optional output of the estimated poses, KITTI format, one line per
+    // input frame. Frames that were dropped or failed get their predicted
+    // pose; "<trajectory>.frames" lists every frame's file name with
+    // "registered", "dropped" or "failed", line for line.
+    std::filesystem::path trajectory;
+
+    static StreamingOptions from_json(const nlohmann::json &config);
+};
+
+struct StreamingReport {
+    std::size_t frames{0};
+    std::size_t registered{0};
+    std::size_t dropped{0};
+    std::size_t deadline_misses{0};
+    std::size_t failures{0};
+    // Arrival-to-pose latency and registration time of every processed
+    // frame, in milliseconds.
+    std::vector<double> latency_ms;
+    std::vector<double> processing_ms;
+};
+
+// Frame-to-map odometry: each frame is registered by point-to-point ICP
+// against an IncrementalVoxelMap of the last frames, starting from a
+// constant-velocity prediction, and then inserted while the oldest frame is
+// evicted.
+class StreamingOdometry {
+public:
+    explicit StreamingOdometry(const StreamingOptions &options);
+
+    // Pose of `frame` in the frame of the first one. Throws when the frame
+    // cannot be registered; the map and motion model are left unchanged.
+    TransMat process(const PointCloud &frame);
+
+    // Pose of a frame that is not registered (dropped or failed), predicted
+    // from the motion model, which then carries on from it; the map is left
+    // unchanged.
+    TransMat skip();
+
+    const IncrementalVoxelMap &map() const { return *_map; }
+
+private:
+    StreamingOptions _options;
+    std::shared_ptr<IncrementalVoxelMap> _map;
+    std::uint64_t _next_frame{0};
+    TransMat _pose{TransMat::Identity()};
+    TransMat _velocity{TransMat::Identity()};
+};
+
+// Runs the streaming mode until the input ends and reports latency
+// percentiles and deadline statistics.
+StreamingReport run_streaming(const StreamingOptions &options);
@@ -0,0 +1,264 @@
+#include "sweep.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+namespace {
+constexpr std::string_view ROLE_SWEEP{"sweep"};
+
+nlohmann::json::json_pointer parameter_pointer(const std::string &parameter) {
+    return nlohmann::json::json_pointer("/" + parameter);
+}
+
+std::string variant_label(const std::string &prefix,
+                          const std::vector<std::pair<std::string, nlohmann::json>> &parameters) {
+    std::string label = prefix + "[";
+    for (std::size_t idx = 0; idx < parameters.size(); ++idx) {
+        if (idx > 0) {
+            label += ';';
+        }
+        label += parameters[idx].first + "=" + format_parameter_value(parameters[idx].second);
+    }
+    return label + "]";
+}
+
+// A parameter's value space: an explicit list or a numeric range.
+struct ParameterSpace {
+    std::string name;
+    std::vector<nlohmann::json> choices;
+    double min{0.0};
+    double max{0.0};
+    bool log{false};
+    bool integer{false};
+
+    static ParameterSpace from_json(const std::string &name, const nlohmann::json &config) {
+        ParameterSpace space;
+        space.name = name;
+        if (config.is_array()) {
+            if (config.empty()) {
+                throw std::invalid_argument("sweep parameter '" + name + "' has no values");
+            }
+            space.choices.assign(config.begin(), config.end());
+            return space;
+        }
+        if (!config.is_object() || !config.contains("min") || !config.contains("max")) {
+            throw std::invalid_argument("sweep parameter '" + name +
+                                        "' must be a list of values or {\"min\", \"max\"}");
+        }
+        space.min = config["min"].get<double>();
+        space.max = config["max"].get<double>();
+        space.log = config.value("log", false);
+        space.integer = config.value("integer", false);
+        if (space.max < space.min || (space.log && space.min <= 0.0)) {
+            throw std::invalid_argument("sweep parameter '" + name + "' has an invalid range");
+        }
+        return space;
+    }
+
+    nlohmann::json draw(std::mt19937_64 &rng) const {
+        if (!choices.empty()) {
+            std::uniform_int_distribution<std::size_t> pick(0, choices.size() - 1);
+            return choices[pick(rng)];
+        }
+        double value = 0.0;
+        if (log) {
+            std::uniform_real_distribution<double> exponent(std::log(min), std::log(max));
+            value = std::exp(exponent(rng));
+        } else {
+            std::uniform_real_distribution<double> uniform(min, max);
+            value = uniform(rng);
+        }
+        if (integer) {
+            return static_cast<long long>(std::llround(value));
+        }
+        return value;
+    }
+};
+
+std::vector<ParameterSpace> read_spaces(const nlohmann::json &params, std::string_view kind) {
+    if (!params.is_object() || params.empty()) {
+        throw std::invalid_argument("sweep." + std::string(kind) +
+                                    " must be a non-empty object of parameters");
+    }
+    std::vector<ParameterSpace> spaces;
+    for (const auto &[key, values] : params.items()) {
+        const auto name = key.starts_with('/') ? key.substr(1) : key;
+        spaces.emplace_back(ParameterSpace::from_json(name, values));
+        if (kind == "grid" && spaces.back().choices.empty()) {
+            throw std::invalid_argument("sweep.grid parameter '" + name + "' must be a list of values");
+        }
+    }
+    return spaces;
+}
+
+std::vector<std::vector<std::pair<std::string, nlohmann::json>>>
+grid_points(const std::vector<ParameterSpace> &spaces) {
+    std::vector<std::vector<std::pair<std::string, nlohmann::json>>> points{{}};
+    for (const auto &space : spaces) {
+        std::vector<std::vector<std::pair<std::string, nlohmann::json>>> next;
+        next.reserve(points.size() * space.choices.size());
+        for (const auto &point : points) {
+            for (const auto &value : space.choices) {
+                next.emplace_back(point);
+                next.back().emplace_back(space.name, value);
+            }
+        }
+        points = std::move(next);
+    }
+    return points;
+}
+
+std::vector<std::vector<std::pair<std::string, nlohmann::json>>>
+random_points(const std::vector<ParameterSpace> &spaces, std::size_t samples, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::vector<std::pair<std::string, nlohmann::json>>> points(samples);
+    for (auto &point : points) {
+        for (const auto &space : spaces) {
+            point.emplace_back(space.name, space.draw(rng));
+        }
+    }
+    return points;
+}
+} // namespace
+
+std::vector<AlgorithmVariant> expand_sweep(const nlohmann::json &algorithm_config) {
+    if (!algorithm_config.is_object() || !algorithm_config.contains("sweep")) {
+        AlgorithmVariant variant{algorithm_config, algorithm_config.value("label", std::string{}), {}};
+        return {std::move(variant)};
+    }
+
+    const auto &sweep = algorithm_config["sweep"];
+    if (!sweep.is_object() || sweep.contains("grid") == sweep.contains("random")) {
+        throw std::invalid_argument("sweep must contain exactly one of \"grid\" or \"random\"");
+    }
+
+    std::vector<std::vector<std::pair<std::string, nlohmann::json>>> points;
+    if (sweep.contains("grid")) {
+        points = grid_points(read_spaces(sweep["grid"], "grid"));
+    } else {
+        const auto &random = sweep["random"];
+        if (!random.is_object()) {
+            throw std::invalid_argument("sweep.random must be an object");
+        }
+        const auto samples = random.value("samples", std::size_t{0});
+        if (samples == 0) {
+            throw std::invalid_argument("sweep.random.samples must be positive");
+        }
+        points = random_points(read_spaces(random.value("params", nlohmann::json{}), "random"),
+                               samples, random.value("seed", std::uint64_t{0}));
+    }
+
+    auto base = algorithm_config;
+    base.erase("sweep");
+    const auto prefix = algorithm_config.value("label", algorithm_config.value("name", std::string{}));
+
+    std::vector<AlgorithmVariant> variants;
+    variants.reserve(points.size());
+    for (auto &parameters : points) {
+        AlgorithmVariant variant{base, variant_label(prefix, parameters), {}};
+        for (const auto &[name, value] : parameters) {
+            variant.config[parameter_pointer(name)] = value;
+        }
+        variant.parameters = std::move(parameters);
+        variants.emplace_back(std::move(variant));
+    }
+    LOG_INFO(ROLE_SWEEP, "Expanded '{}' into {} variant(s)", prefix, variants.size());
+    return variants;
+}
+
+std::string format_parameter_value(const nlohmann::json &value) {
+    return value.is_string() ? value.get<std::string>() : value.dump();
+}
+
+void make_labels_unique(std::vector<std::string> &labels) {
+    std::map<std::string, std::size_t> seen;
+    for (auto &label : labels) {
+        const auto count = ++seen[label];
+        if (count > 1) {
+            auto unique = label + "#" + std::to_string(count);
+            while (seen.contains(unique)) {
+                unique += "'";
+            }
+            ++seen[unique];
+            label = std::move(unique);
+        }
+    }
+}
+
+void write_combined_results(const std::string &path, const AlgorithmResults &results,
+                            const std::vector<std::string> &labels,
+                            const std::vector<AlgorithmVariant> &variants,
+                            const std::vector<std::shared_ptr<MetricBase>> &metrics) {
+    std::vector<std::string> parameter_names;
+    for (const auto &variant : variants) {
+        for (const auto &[name, value] : variant.parameters) {
+            if (std::find(parameter_names.begin(), parameter_names.end(), name) ==
+                parameter_names.end()) {
+                parameter_names.emplace_back(name);
+            }
+        }
+    }
+
+    std::ofstream csv_file(path);
+    if (!csv_file.is_open()) {
+        LOG_ERROR(ROLE_SWEEP, "Failed to open combined result file {}", path);
+        return;
+    }
+    LOG_INFO(ROLE_SWEEP, "Writing combined results to {}", path);
+
+    // Labels and string values may contain the separator.
+    const auto quote = [](const std::string &value) {
+        if (value.find_first_of(",\"\n") == std::string::npos) {
+            return value;
+        }
+        std::string quoted = "\"";
+        for (const char c : value) {
+            quoted += c;
+            if (c == '"') {
+                quoted += '"';
+            }
+        }
+        return quoted + "\"";
+    };
+
+    csv_file << "algorithm,sample";
+    for (const auto &name : parameter_names) {
+        csv_file << ',' << quote(name);
+    }
+    for (const auto &metric : metrics) {
+        csv_file << ',' << quote(metric->name());
+    }
+    csv_file << '\n';
+
+    for (std::size_t idx = 0; idx < labels.size(); ++idx) {
+        const auto found = results.find(labels[idx]);
+        if (found == results.end()) {
+            continue;
+        }
+        std::vector<std::string> parameter_values(parameter_names.size());
+        for (const auto &[name, value] : variants[idx].parameters) {
+            const auto column = std::find(parameter_names.begin(), parameter_names.end(), name);
+            parameter_values[column - parameter_names.begin()] = format_parameter_value(value);
+        }
+
+        const auto &sample_scores = found->second;
+        for (std::size_t sample_idx = 0; sample_idx < sample_scores.size(); ++sample_idx) {
+            csv_file << quote(labels[idx]) << ',' << sample_idx;
+            for (const auto &value : parameter_values) {
+                csv_file << ',' << quote(value);
+            }
+            // Failed samples have no scores; leave their metric cells empty.
+            for (std::size_t metric_idx = 0; metric_idx < metrics.size(); ++metric_idx) {
+                csv_file << ',';
+                if (metric_idx < sample_scores[sample_idx].size()) {
+                    csv_file << sample_scores[sample_idx][metric_idx];
+                }
+            }
+            csv_file << '\n';
+        }
+    }
+}
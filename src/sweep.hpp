@@ -0,0 +1,53 @@
+#pragma once
+#include "metric/metric_base.hpp"
+#include "process.h"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One concrete algorithm configuration produced from a config entry.
+struct AlgorithmVariant {
+    // Algorithm config with the swept parameters substituted and "sweep"
+    // removed; passed to create_algorithm().
+    nlohmann::json config;
+    // Name results are reported under; empty keeps the algorithm's name().
+    std::string label;
+    // Swept parameter values of this variant, in sweep order.
+    std::vector<std::pair<std::string, nlohmann::json>> parameters;
+};
+
+// Expands an algorithm config entry into its variants. Entries without a
+// "sweep" object yield themselves. A sweep is either
+//
+//   "sweep": {"grid": {"max_iterations": [20, 50], "correspondence/voxel_size": [0.05, 0.1]}}
+//
+// for the full cross product, or
+//
+//   "sweep": {"random": {"samples": 16, "seed": 7, "params": {
+//       "max_correspondence_distance": {"min": 0.01, "max": 0.2, "log": true},
+//       "max_iterations": {"min": 10, "max": 80, "integer": true},
+//       "use_reciprocal": [true, false]}}}
+//
+// for independent random draws. Parameter names are '/'-separated paths into
+// the config, so nested settings can be swept too. Variants are labelled
+// "<label or name>[param=value;...]"; a "label" in the entry replaces the
+// name prefix. Throws std::invalid_argument on a malformed sweep.
+std::vector<AlgorithmVariant> expand_sweep(const nlohmann::json &algorithm_config);
+
+// Text of a swept parameter value in labels and tables: strings as they are,
+// anything else as JSON.
+std::string format_parameter_value(const nlohmann::json &value);
+
+// Makes every label unique among `labels` by appending "#2", "#3", ... to
+// repeats, keeping the first occurrence unchanged.
+void make_labels_unique(std::vector<std::string> &labels);
+
+// Writes one table covering every algorithm and sample: columns "algorithm",
+// "sample", the union of all swept parameters (empty where a variant does not
+// set one) and the metrics. `variants[i]` describes the algorithm whose
+// results are stored under `labels[i]`.
+void write_combined_results(const std::string &path, const AlgorithmResults &results,
+                            const std::vector<std::string> &labels,
+                            const std::vector<AlgorithmVariant> &variants,
+                            const std::vector<std::shared_ptr<MetricBase>> &metrics);
@@ -0,0 +1,47 @@
+#pragma once
+// Command-line cloud arguments of the registration tools: "S:F" names
+// fragment F of sample S in the server's dataset, anything else is a .ply or
+// KITTI .bin file that is published through shared memory.
+
+#include <charconv>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "dataset_loader/kitti_dataset_loader.hpp"
+#include "dataset_loader/ply_reader.hpp"
+#include "server/shared_cloud.hpp"
+
+struct CloudArgument {
+    CloudRef ref;
+    // Keeps the shared memory object alive while requests use it.
+    std::shared_ptr<SharedCloudWriter> writer;
+};
+
+inline CloudArgument parse_cloud_argument(const std::string &argument, const std::string &role) {
+    CloudArgument result;
+    const auto colon = argument.find(':');
+    if (colon != std::string::npos && !std::filesystem::exists(argument)) {
+        const char *begin = argument.data();
+        const char *end = begin + argument.size();
+        const auto sample = std::from_chars(begin, begin + colon, result.ref.sample);
+        const auto fragment = std::from_chars(begin + colon + 1, end, result.ref.fragment);
+        if (sample.ec == std::errc{} && fragment.ec == std::errc{} && fragment.ptr == end) {
+            return result;
+        }
+    }
+
+    const std::filesystem::path path(argument);
+    PointCloud cloud;
+    if (path.extension() == ".bin") {
+        cloud = read_kitti_scan(path);
+    } else if (!read_ply_points(path, cloud)) {
+        throw std::runtime_error("unsupported cloud file " + argument);
+    }
+    result.writer = std::make_shared<SharedCloudWriter>(
+        "/pcr-" + std::to_string(::getpid()) + "-" + role, cloud);
+    result.ref = result.writer->ref();
+    return result;
+}
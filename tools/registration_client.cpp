@@ -0,0 +1,50 @@
+// Sends one registration request to a running server and prints the result.
+#include <iostream>
+
+#include <cxxopts.hpp>
+
+#include "server/registration_client.hpp"
+#include "cloud_argument.hpp"
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("registration_client", "Register one pair on a registration server");
+    options.add_options()
+        ("socket", "Server socket", cxxopts::value<std::string>()->default_value("/tmp/pointcloud_registration.sock"))
+        ("algorithm", "Served algorithm (default: the server's first)", cxxopts::value<std::string>()->default_value(""))
+        ("source", "Source cloud: SAMPLE:FRAGMENT or a .ply/.bin file", cxxopts::value<std::string>())
+        ("target", "Target cloud: SAMPLE:FRAGMENT or a .ply/.bin file", cxxopts::value<std::string>())
+        ("stats", "Print the server counters")
+        ("h,help", "Print usage");
+    const auto args = options.parse(argc, argv);
+    if (args.count("help")) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        RegistrationClient client(args["socket"].as<std::string>());
+        if (args.count("stats")) {
+            std::cout << client.stats().dump(2) << std::endl;
+            return 0;
+        }
+        if (!args.count("source") || !args.count("target")) {
+            std::cerr << "--source and --target are required" << std::endl;
+            return 1;
+        }
+
+        const auto source = parse_cloud_argument(args["source"].as<std::string>(), "source");
+        const auto target = parse_cloud_argument(args["target"].as<std::string>(), "target");
+        const auto reply =
+            client.register_pair(args["algorithm"].as<std::string>(), source.ref, target.ref);
+        if (!reply.ok) {
+            std::cerr << "registration failed: " << reply.error << std::endl;
+            return 2;
+        }
+        std::cout << reply.transform << "\n(" << reply.seconds * 1000.0 << " ms on the server, batch of "
+                  << reply.batch << ")" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Load generator for the registration server: several connections keep a
+// fixed number of requests in flight and the end-to-end latency of every
+// request is recorded.
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "server/registration_client.hpp"
+#include "statistics.hpp"
+#include "cloud_argument.hpp"
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("registration_loadgen", "Measure registration server latency and throughput");
+    options.add_options()
+        ("socket", "Server socket", cxxopts::value<std::string>()->default_value("/tmp/pointcloud_registration.sock"))
+        ("algorithm", "Served algorithm (default: the server's first)", cxxopts::value<std::string>()->default_value(""))
+        ("source", "Source cloud: SAMPLE:FRAGMENT or a .ply/.bin file", cxxopts::value<std::string>())
+        ("target", "Target cloud: SAMPLE:FRAGMENT or a .ply/.bin file", cxxopts::value<std::string>())
+        ("connections", "Concurrent connections", cxxopts::value<std::size_t>()->default_value("4"))
+        ("requests", "Requests per connection", cxxopts::value<std::size_t>()->default_value("100"))
+        ("depth", "Requests in flight per connection", cxxopts::value<std::size_t>()->default_value("4"))
+        ("h,help", "Print usage");
+    const auto args = options.parse(argc, argv);
+    if (args.count("help") || !args.count("source") || !args.count("target")) {
+        std::cout << options.help() << std::endl;
+        return args.count("help") ? 0 : 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto socket = args["socket"].as<std::string>();
+    const auto algorithm = args["algorithm"].as<std::string>();
+    const auto connections = args["connections"].as<std::size_t>();
+    const auto requests = args["requests"].as<std::size_t>();
+    const auto depth = std::max<std::size_t>(1, args["depth"].as<std::size_t>());
+
+    try {
+        const auto source = parse_cloud_argument(args["source"].as<std::string>(), "source");
+        const auto target = parse_cloud_argument(args["target"].as<std::string>(), "target");
+
+        std::mutex results_mutex;
+        std::vector<double> latency_ms;
+        std::vector<double> server_ms;
+        std::atomic<std::size_t> failures{0};
+
+        const auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t worker = 0; worker < connections; ++worker) {
+            workers.emplace_back([&]() {
+                RegistrationClient client(socket);
+                std::map<std::uint64_t, Clock::time_point> in_flight;
+                std::vector<double> local_latency;
+                std::vector<double> local_server;
+                std::size_t sent = 0;
+                while (sent < requests || !in_flight.empty()) {
+                    while (sent < requests && in_flight.size() < depth) {
+                        in_flight.emplace(client.send(algorithm, source.ref, target.ref),
+                                          Clock::now());
+                        ++sent;
+                    }
+                    const auto reply = client.receive();
+                    const auto it = in_flight.find(reply.id);
+                    if (it == in_flight.end()) {
+                        continue;
+                    }
+                    local_latency.emplace_back(
+                        std::chrono::duration<double, std::milli>(Clock::now() - it->second)
+                            .count());
+                    local_server.emplace_back(reply.seconds * 1000.0);
+                    in_flight.erase(it);
+                    if (!reply.ok) {
+                        ++failures;
+                    }
+                }
+                std::scoped_lock lock(results_mutex);
+                latency_ms.insert(latency_ms.end(), local_latency.begin(), local_latency.end());
+                server_ms.insert(server_ms.end(), local_server.begin(), local_server.end());
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << std::format("{} requests over {} connection(s), depth {}: {:.1f} req/s, {} failed\n",
+                                 latency_ms.size(), connections, depth,
+                                 static_cast<double>(latency_ms.size()) / seconds, failures.load());
+        std::cout << std::format("latency ms  p50 {:.2f}  p90 {:.2f}  p99 {:.2f}  max {:.2f}\n",
+                                 percentile(latency_ms, 0.5), percentile(latency_ms, 0.9),
+                                 percentile(latency_ms, 0.99), percentile(latency_ms, 1.0));
+        std::cout << std::format("server ms   p50 {:.2f}  p99 {:.2f}\n", percentile(server_ms, 0.5),
+                                 percentile(server_ms, 0.99));
+        std::cout << RegistrationClient(socket).stats().dump() << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -19,10 +19,69 @@ package("shark")
     end)
 package_end()
 
+-- Replaces the global operator new with a per-thread counting one, so that
+-- benchmarks can check that registration paths do not allocate.
+option("alloc_counter")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Count heap allocations per thread (see src/allocation_counter.hpp)")
+    add_defines("REGISTRATION_COUNT_ALLOCATIONS")
+option_end()
+
+-- Engines, loaders, metrics and the evaluation runner, for embedding.
+-- Components register themselves from static initializers, so static
+-- builds must be linked whole (see the CLI below).
+target("registration_core")
+    set_kind("$(kind)")
+    add_files("src/**.cpp|main.cpp")
+    add_options("alloc_counter")
+    set_languages("c++23")
+    add_includedirs("src", {public = true})
+    add_headerfiles("src/(**.hpp)", "src/(**.h)")
+    add_packages("pcl", "eigen","nlohmann_json","thread-pool","csvparser","openmp","nanoflann","boost","shark","cxxopts", {public = true})
+target_end()
+
 target("pointcloud_registration")
     set_kind("binary")
-    add_files("src/**.cpp")
+    add_deps("registration_core")
+    add_linkgroups("registration_core", {whole = true})
+    add_files("src/main.cpp")
     set_languages("c++23")
-    add_includedirs("src")
     add_packages("pcl", "eigen","nlohmann_json","thread-pool","csvparser","openmp","nanoflann","boost","shark","cxxopts")
-target_end()
\ No newline at end of file
+target_end()
+
+target("spatial_index_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/spatial_index_bench.cpp", "src/algorithm/voxel_hash_index.cpp")
+    set_languages("c++23")
+    add_includedirs("src")
+    add_packages("pcl", "eigen", "nanoflann", "cxxopts")
+target_end()
+
+target("pair_allocation_bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("registration_core")
+    add_files("bench/pair_allocation_bench.cpp")
+    set_languages("c++23")
+    add_packages("pcl", "eigen", "nlohmann_json", "cxxopts")
+target_end()
+
+target("registration_client")
+    set_kind("binary")
+    set_default(false)
+    add_deps("registration_core")
+    add_files("tools/registration_client.cpp")
+    set_languages("c++23")
+    add_packages("pcl", "eigen", "nlohmann_json", "cxxopts")
+target_end()
+
+target("registration_loadgen")
+    set_kind("binary")
+    set_default(false)
+    add_deps("registration_core")
+    add_files("tools/registration_loadgen.cpp")
+    set_languages("c++23")
+    add_packages("pcl", "eigen", "nlohmann_json", "cxxopts")
+target_end()